@@ -27,6 +27,7 @@
    CGLM_INLINE void  glm_mat4_pick3t(mat4 mat, mat3 dest);
    CGLM_INLINE void  glm_mat4_ins3(mat3 mat, mat4 dest);
    CGLM_INLINE void  glm_mat4_mul(mat4 m1, mat4 m2, mat4 dest);
+   CGLM_INLINE void  glm_mat4_mul2(mat4 m1[2], mat4 m2[2], mat4 dest[2]);
    CGLM_INLINE void  glm_mat4_mulN(mat4 *matrices[], int len, mat4 dest);
    CGLM_INLINE void  glm_mat4_mulv(mat4 m, vec4 v, vec4 dest);
    CGLM_INLINE void  glm_mat4_mulv3(mat4 m, vec3 v, float last, vec3 dest);
@@ -40,6 +41,8 @@
    CGLM_INLINE float glm_mat4_det(mat4 mat);
    CGLM_INLINE void  glm_mat4_inv(mat4 mat, mat4 dest);
    CGLM_INLINE void  glm_mat4_inv_fast(mat4 mat, mat4 dest);
+   CGLM_INLINE void  glm_mat4_inv2(mat4 mat[2], mat4 dest[2]);
+   CGLM_INLINE void  glm_mat4_inv_fast2(mat4 mat[2], mat4 dest[2]);
    CGLM_INLINE void  glm_mat4_swap_col(mat4 mat, int col1, int col2);
    CGLM_INLINE void  glm_mat4_swap_row(mat4 mat, int row1, int row2);
    CGLM_INLINE float glm_mat4_rmc(vec4 r, mat4 m, vec4 c);
@@ -352,6 +355,28 @@ glm_mat4_mul(mat4 m1, mat4 m2, mat4 dest) {
 #endif
 }
 
+/*!
+ * @brief two independent products, dest[i] = m1[i] * m2[i]
+ *
+ * with AVX and FMA the two are interleaved, two columns per register (without
+ * FMA that is slower than two glm_mat4_mul() calls). dest may be the same
+ * array as m1 or m2, like glm_mat4_mul()
+ *
+ * @param[in]  m1   left matrices
+ * @param[in]  m2   right matrices
+ * @param[out] dest destination matrices
+ */
+CGLM_INLINE
+void
+glm_mat4_mul2(mat4 m1[2], mat4 m2[2], mat4 dest[2]) {
+#if defined(__AVX__) && defined(__FMA__)
+  glm_mat4_mul2_avx(m1, m2, dest);
+#else
+  glm_mat4_mul(m1[0], m2[0], dest[0]);
+  glm_mat4_mul(m1[1], m2[1], dest[1]);
+#endif
+}
+
 /*!
  * @brief mupliply N mat4 matrices and store result in dest
  *
@@ -398,6 +423,8 @@ void
 glm_mat4_mulv(mat4 m, vec4 v, vec4 dest) {
 #if defined(__wasm__) && defined(__wasm_simd128__)
   glm_mat4_mulv_wasm(m, v, dest);
+#elif defined(__AVX2__) && defined(__FMA__)
+  glm_mat4_mulv_avx(m, v, dest);
 #elif defined( __SSE__ ) || defined( __SSE2__ )
   glm_mat4_mulv_sse2(m, v, dest);
 #elif defined(CGLM_NEON_FP)
@@ -719,6 +746,42 @@ glm_mat4_inv_fast(mat4 mat, mat4 dest) {
 #endif
 }
 
+/*!
+ * @brief inverse of two matrices, dest[i] = inverse of mat[i]
+ *
+ * with AVX both are computed at once, one per 128-bit lane
+ *
+ * @param[in]  mat  matrices
+ * @param[out] dest inverse matrices
+ */
+CGLM_INLINE
+void
+glm_mat4_inv2(mat4 mat[2], mat4 dest[2]) {
+#if defined(__AVX__)
+  glm_mat4_inv2_avx(mat, dest);
+#else
+  glm_mat4_inv(mat[0], dest[0]);
+  glm_mat4_inv(mat[1], dest[1]);
+#endif
+}
+
+/*!
+ * @brief inverse of two matrices with glm_mat4_inv_fast() precision
+ *
+ * @param[in]  mat  matrices
+ * @param[out] dest inverse matrices
+ */
+CGLM_INLINE
+void
+glm_mat4_inv_fast2(mat4 mat[2], mat4 dest[2]) {
+#if defined(__AVX__)
+  glm_mat4_inv_fast2_avx(mat, dest);
+#else
+  glm_mat4_inv_fast(mat[0], dest[0]);
+  glm_mat4_inv_fast(mat[1], dest[1]);
+#endif
+}
+
 /*!
  * @brief swap two matrix columns
  *
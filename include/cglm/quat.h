@@ -32,6 +32,7 @@
    CGLM_INLINE float glm_quat_angle(versor q);
    CGLM_INLINE void glm_quat_axis(versor q, vec3 dest);
    CGLM_INLINE void glm_quat_mul(versor p, versor q, versor dest);
+   CGLM_INLINE void glm_quat_mul2(versor p[2], versor q[2], versor dest[2]);
    CGLM_INLINE void glm_quat_mat4(versor q, mat4 dest);
    CGLM_INLINE void glm_quat_mat4t(versor q, mat4 dest);
    CGLM_INLINE void glm_quat_mat3(versor q, mat3 dest);
@@ -68,6 +69,10 @@
 #  include "simd/sse2/quat.h"
 #endif
 
+#ifdef CGLM_AVX_FP
+#  include "simd/avx/quat.h"
+#endif
+
 #ifdef CGLM_NEON_FP
 #  include "simd/neon/quat.h"
 #endif
@@ -473,6 +478,26 @@ glm_quat_mul(versor p, versor q, versor dest) {
 #endif
 }
 
+/*!
+ * @brief two independent products, dest[i] = p[i] * q[i]
+ *
+ * with AVX both are computed at once, one per 128-bit lane
+ *
+ * @param[in]   p     quaternions p
+ * @param[in]   q     quaternions q
+ * @param[out]  dest  result quaternions
+ */
+CGLM_INLINE
+void
+glm_quat_mul2(versor p[2], versor q[2], versor dest[2]) {
+#if defined(__AVX__)
+  glm_quat_mul2_avx(p, q, dest);
+#else
+  glm_quat_mul(p[0], q[0], dest[0]);
+  glm_quat_mul(p[1], q[1], dest[1]);
+#endif
+}
+
 /*!
  * @brief convert quaternion to mat4
  *
@@ -19,6 +19,18 @@
                                  float * __restrict t1,
                                  float * __restrict t2)
  CGLM_INLINE void glm_ray_at(vec3 orig, vec3 dir, float t, vec3 point);
+ CGLM_INLINE int glm_ray_triangle8(vec3   origin,
+                                   vec3   direction,
+                                   float  v0[3][8],
+                                   float  v1[3][8],
+                                   float  v2[3][8],
+                                   float *d);
+ CGLM_INLINE int glm_ray8_triangle(float  origin[3][8],
+                                   float  direction[3][8],
+                                   vec3   v0,
+                                   vec3   v1,
+                                   vec3   v2,
+                                   float *d);
 */
 
 #ifndef cglm_ray_h
@@ -26,6 +38,14 @@
 
 #include "vec3.h"
 
+#ifdef CGLM_SSE2_FP
+#  include "simd/sse2/ray.h"
+#endif
+
+#ifdef CGLM_AVX_FP
+#  include "simd/avx/ray.h"
+#endif
+
 /*!
  * @brief Möller–Trumbore ray-triangle intersection algorithm
  * 
@@ -171,4 +191,132 @@ glm_ray_at(vec3 orig, vec3 dir, float t, vec3 point) {
   glm_vec3_add(orig, dst, point);
 }
 
+/*!
+ * @brief one ray against eight triangles, glm_ray_triangle() for each
+ *
+ * The triangles are stored per component (v0[axis][triangle]) so they can be
+ * tested eight (AVX) or four (SSE2) at a time. The SIMD paths do the same
+ * operations in the same order as glm_ray_triangle(), so hits and distances
+ * are bit for bit the same, unless the scalar one was built with FMA
+ * contraction (e.g. -mfma), where distances can differ in the last bits.
+ *
+ * @param[in]      origin     origin of ray
+ * @param[in]      direction  direction of ray
+ * @param[in]      v0         first vertices
+ * @param[in]      v1         second vertices
+ * @param[in]      v2         third vertices
+ * @param[in, out] d          distance per triangle, written where
+ *                            glm_ray_triangle() would write it (may be NULL)
+ * @return bit i set if triangle i is hit
+ */
+CGLM_INLINE
+int
+glm_ray_triangle8(vec3   origin,
+                  vec3   direction,
+                  float  v0[3][8],
+                  float  v1[3][8],
+                  float  v2[3][8],
+                  float *d) {
+#if defined(__AVX__)
+  return glm_ray_triangle8_avx(origin, direction, v0, v1, v2, d);
+#elif defined(CGLM_SSE2_FP)
+  __m128 o[3], dir[3], a[3], b[3], c[3], dist, written;
+  int    i, half, hit;
+
+  hit = 0;
+  for (i = 0; i < 3; i++) {
+    o[i]   = _mm_set1_ps(origin[i]);
+    dir[i] = _mm_set1_ps(direction[i]);
+  }
+
+  for (half = 0; half < 8; half += 4) {
+    for (i = 0; i < 3; i++) {
+      a[i] = _mm_loadu_ps(v0[i] + half);
+      b[i] = _mm_loadu_ps(v1[i] + half);
+      c[i] = _mm_loadu_ps(v2[i] + half);
+    }
+    hit |= glmm_ray_triangle4(o, dir, a, b, c, &dist, &written) << half;
+    if (d)
+      glmm_ray_store4(d + half, dist, written);
+  }
+
+  return hit;
+#else
+  vec3 a, b, c;
+  int  i, hit;
+
+  hit = 0;
+  for (i = 0; i < 8; i++) {
+    glm_vec3_copy((vec3){v0[0][i], v0[1][i], v0[2][i]}, a);
+    glm_vec3_copy((vec3){v1[0][i], v1[1][i], v1[2][i]}, b);
+    glm_vec3_copy((vec3){v2[0][i], v2[1][i], v2[2][i]}, c);
+    hit |= glm_ray_triangle(origin, direction, a, b, c, d ? d + i : NULL) << i;
+  }
+
+  return hit;
+#endif
+}
+
+/*!
+ * @brief eight rays against one triangle, glm_ray_triangle() for each
+ *
+ * Rays are stored per component (origin[axis][ray]), see glm_ray_triangle8()
+ * for how the results compare to the scalar function.
+ *
+ * @param[in]      origin     ray origins
+ * @param[in]      direction  ray directions
+ * @param[in]      v0         first vertex of triangle
+ * @param[in]      v1         second vertex of triangle
+ * @param[in]      v2         third vertex of triangle
+ * @param[in, out] d          distance per ray, written where
+ *                            glm_ray_triangle() would write it (may be NULL)
+ * @return bit i set if ray i hits
+ */
+CGLM_INLINE
+int
+glm_ray8_triangle(float  origin[3][8],
+                  float  direction[3][8],
+                  vec3   v0,
+                  vec3   v1,
+                  vec3   v2,
+                  float *d) {
+#if defined(__AVX__)
+  return glm_ray8_triangle_avx(origin, direction, v0, v1, v2, d);
+#elif defined(CGLM_SSE2_FP)
+  __m128 o[3], dir[3], a[3], b[3], c[3], dist, written;
+  int    i, half, hit;
+
+  hit = 0;
+  for (i = 0; i < 3; i++) {
+    a[i] = _mm_set1_ps(v0[i]);
+    b[i] = _mm_set1_ps(v1[i]);
+    c[i] = _mm_set1_ps(v2[i]);
+  }
+
+  for (half = 0; half < 8; half += 4) {
+    for (i = 0; i < 3; i++) {
+      o[i]   = _mm_loadu_ps(origin[i] + half);
+      dir[i] = _mm_loadu_ps(direction[i] + half);
+    }
+    hit |= glmm_ray_triangle4(o, dir, a, b, c, &dist, &written) << half;
+    if (d)
+      glmm_ray_store4(d + half, dist, written);
+  }
+
+  return hit;
+#else
+  vec3 o, dir;
+  int  i, hit;
+
+  hit = 0;
+  for (i = 0; i < 8; i++) {
+    glm_vec3_copy((vec3){origin[0][i], origin[1][i], origin[2][i]}, o);
+    glm_vec3_copy((vec3){direction[0][i], direction[1][i], direction[2][i]}, dir);
+    hit |= glm_ray_triangle(o, dir, v0, v1, v2, d ? d + i : NULL) << i;
+  }
+
+  return hit;
+#endif
+}
+
 #endif
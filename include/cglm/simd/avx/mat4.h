@@ -72,5 +72,183 @@ glm_mat4_mul_avx(mat4 m1, mat4 m2, mat4 dest) {
                                             _mm256_mul_ps(y5, y9))));
 }
 
+CGLM_INLINE
+void
+glm_mat4_mul2_avx(mat4 m1[2], mat4 m2[2], mat4 dest[2]) {
+  /* two columns of each product per register: m1 columns are broadcast to
+     both lanes, m2 columns i and i + 1 are splatted within their lane */
+
+  __m256 a0, a1, a2, a3, b0, b1, c0, c1, c2, c3, d0, d1, d2, d3;
+
+  a0 = _mm256_broadcast_ps((__m128 *)m1[0][0]);
+  a1 = _mm256_broadcast_ps((__m128 *)m1[0][1]);
+  a2 = _mm256_broadcast_ps((__m128 *)m1[0][2]);
+  a3 = _mm256_broadcast_ps((__m128 *)m1[0][3]);
+  c0 = _mm256_broadcast_ps((__m128 *)m1[1][0]);
+  c1 = _mm256_broadcast_ps((__m128 *)m1[1][1]);
+  c2 = _mm256_broadcast_ps((__m128 *)m1[1][2]);
+  c3 = _mm256_broadcast_ps((__m128 *)m1[1][3]);
+
+  b0 = glmm_load256(m2[0][0]);
+  b1 = glmm_load256(m2[0][2]);
+  d0 = glmm_load256(m2[1][0]);
+  d1 = glmm_load256(m2[1][2]);
+
+  /* everything is loaded, so dest may alias m1 or m2 */
+  d2 = _mm256_mul_ps(c0, _mm256_permute_ps(d0, _MM_SHUFFLE(0, 0, 0, 0)));
+  d3 = _mm256_mul_ps(c0, _mm256_permute_ps(d1, _MM_SHUFFLE(0, 0, 0, 0)));
+  c0 = _mm256_mul_ps(a0, _mm256_permute_ps(b0, _MM_SHUFFLE(0, 0, 0, 0)));
+  a0 = _mm256_mul_ps(a0, _mm256_permute_ps(b1, _MM_SHUFFLE(0, 0, 0, 0)));
+
+  c0 = glmm256_fmadd(a1, _mm256_permute_ps(b0, _MM_SHUFFLE(1, 1, 1, 1)), c0);
+  a0 = glmm256_fmadd(a1, _mm256_permute_ps(b1, _MM_SHUFFLE(1, 1, 1, 1)), a0);
+  d2 = glmm256_fmadd(c1, _mm256_permute_ps(d0, _MM_SHUFFLE(1, 1, 1, 1)), d2);
+  d3 = glmm256_fmadd(c1, _mm256_permute_ps(d1, _MM_SHUFFLE(1, 1, 1, 1)), d3);
+
+  c0 = glmm256_fmadd(a2, _mm256_permute_ps(b0, _MM_SHUFFLE(2, 2, 2, 2)), c0);
+  a0 = glmm256_fmadd(a2, _mm256_permute_ps(b1, _MM_SHUFFLE(2, 2, 2, 2)), a0);
+  d2 = glmm256_fmadd(c2, _mm256_permute_ps(d0, _MM_SHUFFLE(2, 2, 2, 2)), d2);
+  d3 = glmm256_fmadd(c2, _mm256_permute_ps(d1, _MM_SHUFFLE(2, 2, 2, 2)), d3);
+
+  c0 = glmm256_fmadd(a3, _mm256_permute_ps(b0, _MM_SHUFFLE(3, 3, 3, 3)), c0);
+  a0 = glmm256_fmadd(a3, _mm256_permute_ps(b1, _MM_SHUFFLE(3, 3, 3, 3)), a0);
+  d2 = glmm256_fmadd(c3, _mm256_permute_ps(d0, _MM_SHUFFLE(3, 3, 3, 3)), d2);
+  d3 = glmm256_fmadd(c3, _mm256_permute_ps(d1, _MM_SHUFFLE(3, 3, 3, 3)), d3);
+
+  glmm_store256(dest[0][0], c0);
+  glmm_store256(dest[0][2], a0);
+  glmm_store256(dest[1][0], d2);
+  glmm_store256(dest[1][2], d3);
+}
+
+CGLM_INLINE
+void
+glm_mat4_mulv_avx(mat4 m, vec4 v, vec4 dest) {
+  __m256 y0, y1, y2, y3;
+
+  y0 = glmm_load256(m[0]);                 /* m[1] | m[0] */
+  y1 = glmm_load256(m[2]);                 /* m[3] | m[2] */
+  y2 = _mm256_broadcast_ps((__m128 *)v);   /* v    | v    */
+
+  /* y y y y x x x x,  w w w w z z z z */
+  y3 = _mm256_permutevar_ps(y2, _mm256_set_epi32(3, 3, 3, 3, 2, 2, 2, 2));
+  y2 = _mm256_permutevar_ps(y2, _mm256_set_epi32(1, 1, 1, 1, 0, 0, 0, 0));
+
+  y0 = glmm256_fmadd(y1, y3, _mm256_mul_ps(y0, y2));
+
+  glmm_store(dest, _mm_add_ps(_mm256_castps256_ps128(y0),
+                              _mm256_extractf128_ps(y0, 1)));
+}
+
+/*!
+ * @brief adjugates of two matrices and their determinants, one matrix per
+ *        128-bit lane
+ *
+ * glm_mat4_inv_sse2() with every register twice as wide. Only in-lane
+ * shuffles are needed, so it costs about as much as one 128-bit inverse.
+ */
+static inline
+__m256
+glmm_mat4_adj2_avx(mat4 mat[2], __m256 v[4]) {
+  __m256 r0, r1, r2, r3,
+         t0, t1, t2, t3, t4, t5,
+         x0, x1, x2, x3, x4, x5, x6, x7, x8, x9;
+
+  /* x8 = + - + - in each lane, x9 = - + - + */
+  x8 = _mm256_castsi256_ps(_mm256_setr_epi32(0, GLMM_NEGZEROf, 0, GLMM_NEGZEROf,
+                                             0, GLMM_NEGZEROf, 0, GLMM_NEGZEROf));
+  x9 = _mm256_permute_ps(x8, _MM_SHUFFLE(2, 1, 2, 1));
+
+  /* 127 <- 0, mat[1] in the high lane */
+  r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(glmm_load(mat[0][0])),
+                            glmm_load(mat[1][0]), 1);  /* d c b a */
+  r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(glmm_load(mat[0][1])),
+                            glmm_load(mat[1][1]), 1);  /* h g f e */
+  r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(glmm_load(mat[0][2])),
+                            glmm_load(mat[1][2]), 1);  /* l k j i */
+  r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(glmm_load(mat[0][3])),
+                            glmm_load(mat[1][3]), 1);  /* p o n m */
+
+  x0 = _mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(r2),
+                                           _mm256_castps_pd(r3))); /* p o l k */
+  x3 = _mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(r2),
+                                           _mm256_castps_pd(r3))); /* n m j i */
+  x1 = _mm256_permute_ps(x0, _MM_SHUFFLE(1, 3, 3, 3));           /* l p p p */
+  x2 = _mm256_permute_ps(x0, _MM_SHUFFLE(0, 2, 2, 2));           /* k o o o */
+  x4 = _mm256_permute_ps(x3, _MM_SHUFFLE(1, 3, 3, 3));           /* j n n n */
+  x7 = _mm256_permute_ps(x3, _MM_SHUFFLE(0, 2, 2, 2));           /* i m m m */
+
+  x6 = _mm256_shuffle_ps(r2, r1, _MM_SHUFFLE(0, 0, 0, 0));       /* e e i i */
+  x5 = _mm256_shuffle_ps(r2, r1, _MM_SHUFFLE(1, 1, 1, 1));       /* f f j j */
+  x3 = _mm256_shuffle_ps(r2, r1, _MM_SHUFFLE(2, 2, 2, 2));       /* g g k k */
+  x0 = _mm256_shuffle_ps(r2, r1, _MM_SHUFFLE(3, 3, 3, 3));       /* h h l l */
+
+  t0 = glmm256_fnmadd(x2, x0, _mm256_mul_ps(x3, x1));
+  t1 = glmm256_fnmadd(x4, x0, _mm256_mul_ps(x5, x1));
+  t2 = glmm256_fnmadd(x4, x3, _mm256_mul_ps(x5, x2));
+  t3 = glmm256_fnmadd(x7, x0, _mm256_mul_ps(x6, x1));
+  t4 = glmm256_fnmadd(x7, x3, _mm256_mul_ps(x6, x2));
+  t5 = glmm256_fnmadd(x7, x5, _mm256_mul_ps(x6, x4));
+
+  x4 = _mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(r0),
+                                           _mm256_castps_pd(r1))); /* f e b a */
+  x5 = _mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(r0),
+                                           _mm256_castps_pd(r1))); /* h g d c */
+
+  x0 = _mm256_permute_ps(x4, _MM_SHUFFLE(0, 0, 0, 2));           /* a a a e */
+  x1 = _mm256_permute_ps(x4, _MM_SHUFFLE(1, 1, 1, 3));           /* b b b f */
+  x2 = _mm256_permute_ps(x5, _MM_SHUFFLE(0, 0, 0, 2));           /* c c c g */
+  x3 = _mm256_permute_ps(x5, _MM_SHUFFLE(1, 1, 1, 3));           /* d d d h */
+
+  v[0] = glmm256_fmadd(x3, t2, glmm256_fnmadd(x2, t1, _mm256_mul_ps(x1, t0)));
+  v[1] = glmm256_fmadd(x3, t4, glmm256_fnmadd(x2, t3, _mm256_mul_ps(x0, t0)));
+  v[2] = glmm256_fmadd(x3, t5, glmm256_fnmadd(x1, t3, _mm256_mul_ps(x0, t1)));
+  v[3] = glmm256_fmadd(x2, t5, glmm256_fnmadd(x1, t4, _mm256_mul_ps(x0, t2)));
+
+  v[0] = _mm256_xor_ps(v[0], x8);
+  v[1] = _mm256_xor_ps(v[1], x9);
+  v[2] = _mm256_xor_ps(v[2], x8);
+  v[3] = _mm256_xor_ps(v[3], x9);
+
+  /* determinant */
+  x0 = _mm256_shuffle_ps(v[0], v[1], _MM_SHUFFLE(0, 0, 0, 0));
+  x1 = _mm256_shuffle_ps(v[2], v[3], _MM_SHUFFLE(0, 0, 0, 0));
+  x0 = _mm256_shuffle_ps(x0, x1, _MM_SHUFFLE(2, 0, 2, 0));
+  x0 = _mm256_mul_ps(x0, r0);
+
+  x0 = _mm256_add_ps(x0, _mm256_permute_ps(x0, _MM_SHUFFLE(0, 1, 2, 3)));
+  return _mm256_add_ps(x0, _mm256_permute_ps(x0, _MM_SHUFFLE(1, 0, 0, 1)));
+}
+
+static inline
+void
+glmm_mat4_store2_avx(mat4 dest[2], __m256 v[4], __m256 s) {
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    v[i] = _mm256_mul_ps(v[i], s);
+    glmm_store(dest[0][i], _mm256_castps256_ps128(v[i]));
+    glmm_store(dest[1][i], _mm256_extractf128_ps(v[i], 1));
+  }
+}
+
+CGLM_INLINE
+void
+glm_mat4_inv2_avx(mat4 mat[2], mat4 dest[2]) {
+  __m256 v[4], det;
+
+  det = glmm_mat4_adj2_avx(mat, v);
+  glmm_mat4_store2_avx(dest, v, _mm256_div_ps(_mm256_set1_ps(1.0f), det));
+}
+
+CGLM_INLINE
+void
+glm_mat4_inv_fast2_avx(mat4 mat[2], mat4 dest[2]) {
+  __m256 v[4], det;
+
+  det = glmm_mat4_adj2_avx(mat, v);
+  glmm_mat4_store2_avx(dest, v, _mm256_rcp_ps(det));
+}
+
 #endif
 #endif /* cglm_mat_simd_avx_h */
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#ifndef cglm_quat_simd_avx_h
+#define cglm_quat_simd_avx_h
+#ifdef __AVX__
+
+#include "../../common.h"
+#include "../intrin.h"
+
+#include <immintrin.h>
+
+CGLM_INLINE
+void
+glm_quat_mul2_avx(versor p[2], versor q[2], versor dest[2]) {
+  /*
+   + (a1 b2 + b1 a2 + c1 d2 − d1 c2)i
+   + (a1 c2 − b1 d2 + c1 a2 + d1 b2)j
+   + (a1 d2 + b1 c2 − c1 b2 + d1 a2)k
+     a1 a2 − b1 b2 − c1 c2 − d1 d2
+
+   glm_quat_mul_sse2() with p[1] * q[1] in the high lane
+   */
+
+  __m256 xp, xq, x1, x2, x3, r, x, y, z;
+
+  xp = _mm256_insertf128_ps(_mm256_castps128_ps256(glmm_load(p[0])),
+                            glmm_load(p[1]), 1);
+  xq = _mm256_insertf128_ps(_mm256_castps128_ps256(glmm_load(q[0])),
+                            glmm_load(q[1]), 1);
+  x1 = _mm256_castsi256_ps(_mm256_setr_epi32(0, GLMM_NEGZEROf, 0, GLMM_NEGZEROf,
+                                             0, GLMM_NEGZEROf, 0, GLMM_NEGZEROf));
+  r  = _mm256_mul_ps(_mm256_permute_ps(xp, _MM_SHUFFLE(3, 3, 3, 3)), xq);
+
+  x2 = _mm256_unpackhi_ps(x1, x1);
+  x3 = _mm256_permute_ps(x1, _MM_SHUFFLE(3, 2, 0, 1));
+  x  = _mm256_permute_ps(xp, _MM_SHUFFLE(0, 0, 0, 0));
+  y  = _mm256_permute_ps(xp, _MM_SHUFFLE(1, 1, 1, 1));
+  z  = _mm256_permute_ps(xp, _MM_SHUFFLE(2, 2, 2, 2));
+
+  x  = _mm256_xor_ps(x, x1);
+  y  = _mm256_xor_ps(y, x2);
+  z  = _mm256_xor_ps(z, x3);
+
+  x1 = _mm256_permute_ps(xq, _MM_SHUFFLE(0, 1, 2, 3));
+  x2 = _mm256_permute_ps(xq, _MM_SHUFFLE(1, 0, 3, 2));
+  x3 = _mm256_permute_ps(xq, _MM_SHUFFLE(2, 3, 0, 1));
+
+  r  = glmm256_fmadd(x, x1, r);
+  r  = glmm256_fmadd(y, x2, r);
+  r  = glmm256_fmadd(z, x3, r);
+
+  glmm_store(dest[0], _mm256_castps256_ps128(r));
+  glmm_store(dest[1], _mm256_extractf128_ps(r, 1));
+}
+
+#endif
+#endif /* cglm_quat_simd_avx_h */
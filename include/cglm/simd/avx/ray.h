@@ -0,0 +1,173 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#ifndef cglm_ray_avx_h
+#define cglm_ray_avx_h
+#ifdef __AVX__
+
+#include "../../common.h"
+#include "../intrin.h"
+
+#include <immintrin.h>
+
+/*!
+ * @brief Möller–Trumbore for eight ray/triangle pairs at once, one lane each
+ *
+ * Same operations in the same order as glm_ray_triangle(), so every lane gives
+ * the same result as the scalar function would for that pair.
+ *
+ * @param[in]  o        ray origins, one register per component
+ * @param[in]  dir      ray directions
+ * @param[in]  v0       first vertices
+ * @param[in]  v1       second vertices
+ * @param[in]  v2       third vertices
+ * @param[out] dist     distances, only meaningful in lanes set in *written
+ * @param[out] written  all bits set in the lanes the scalar function would
+ *                      have written d for
+ * @return mask of the lanes that hit
+ */
+CGLM_INLINE
+int
+glmm_ray_triangle8(__m256 o[3],
+                   __m256 dir[3],
+                   __m256 v0[3],
+                   __m256 v1[3],
+                   __m256 v2[3],
+                   __m256 *dist,
+                   __m256 *written) {
+  __m256 e1[3], e2[3], p[3], t[3], q[3];
+  __m256 det, inv_det, u, v, miss, eps, zero, one;
+  int    i;
+
+  eps  = _mm256_set1_ps(0.000001f);
+  zero = _mm256_setzero_ps();
+  one  = _mm256_set1_ps(1.0f);
+
+  for (i = 0; i < 3; i++) {
+    e1[i] = _mm256_sub_ps(v1[i], v0[i]);
+    e2[i] = _mm256_sub_ps(v2[i], v0[i]);
+    t[i]  = _mm256_sub_ps(o[i], v0[i]);
+  }
+
+  p[0] = _mm256_sub_ps(_mm256_mul_ps(dir[1], e2[2]), _mm256_mul_ps(dir[2], e2[1]));
+  p[1] = _mm256_sub_ps(_mm256_mul_ps(dir[2], e2[0]), _mm256_mul_ps(dir[0], e2[2]));
+  p[2] = _mm256_sub_ps(_mm256_mul_ps(dir[0], e2[1]), _mm256_mul_ps(dir[1], e2[0]));
+
+  det  = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1[0], p[0]), _mm256_mul_ps(e1[1], p[1])),
+                       _mm256_mul_ps(e1[2], p[2]));
+  miss = _mm256_and_ps(_mm256_cmp_ps(det, _mm256_set1_ps(-0.000001f), _CMP_GT_OQ),
+                       _mm256_cmp_ps(det, eps, _CMP_LT_OQ));
+
+  inv_det = _mm256_div_ps(one, det);
+
+  u    = _mm256_mul_ps(inv_det,
+                       _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(t[0], p[0]), _mm256_mul_ps(t[1], p[1])),
+                                     _mm256_mul_ps(t[2], p[2])));
+  miss = _mm256_or_ps(miss, _mm256_or_ps(_mm256_cmp_ps(u, zero, _CMP_LT_OQ),
+                                         _mm256_cmp_ps(u, one, _CMP_GT_OQ)));
+
+  q[0] = _mm256_sub_ps(_mm256_mul_ps(t[1], e1[2]), _mm256_mul_ps(t[2], e1[1]));
+  q[1] = _mm256_sub_ps(_mm256_mul_ps(t[2], e1[0]), _mm256_mul_ps(t[0], e1[2]));
+  q[2] = _mm256_sub_ps(_mm256_mul_ps(t[0], e1[1]), _mm256_mul_ps(t[1], e1[0]));
+
+  v    = _mm256_mul_ps(inv_det,
+                       _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dir[0], q[0]), _mm256_mul_ps(dir[1], q[1])),
+                                     _mm256_mul_ps(dir[2], q[2])));
+  miss = _mm256_or_ps(miss, _mm256_or_ps(_mm256_cmp_ps(v, zero, _CMP_LT_OQ),
+                                         _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_GT_OQ)));
+
+  *dist    = _mm256_mul_ps(inv_det,
+                           _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2[0], q[0]), _mm256_mul_ps(e2[1], q[1])),
+                                         _mm256_mul_ps(e2[2], q[2])));
+  *written = _mm256_andnot_ps(miss, _mm256_castsi256_ps(_mm256_set1_epi32(-1)));
+
+  return _mm256_movemask_ps(_mm256_andnot_ps(miss, _mm256_cmp_ps(*dist, eps, _CMP_GT_OQ)));
+}
+
+/* stores the lanes in written, leaves the rest of d alone */
+CGLM_INLINE
+void
+glmm_ray_store8(float *d, __m256 dist, __m256 written) {
+  _mm256_maskstore_ps(d, _mm256_castps_si256(written), dist);
+}
+
+/*!
+ * @brief one ray against eight triangles stored per component
+ *
+ * @param[in]      origin     origin of ray
+ * @param[in]      direction  direction of ray
+ * @param[in]      v0         first vertices, v0[axis][triangle]
+ * @param[in]      v1         second vertices
+ * @param[in]      v2         third vertices
+ * @param[in, out] d          distances, written like glm_ray_triangle() (may be NULL)
+ * @return mask of the triangles hit
+ */
+CGLM_INLINE
+int
+glm_ray_triangle8_avx(vec3   origin,
+                      vec3   direction,
+                      float  v0[3][8],
+                      float  v1[3][8],
+                      float  v2[3][8],
+                      float *d) {
+  __m256 o[3], dir[3], a[3], b[3], c[3], dist, written;
+  int    i, hit;
+
+  for (i = 0; i < 3; i++) {
+    o[i]   = _mm256_set1_ps(origin[i]);
+    dir[i] = _mm256_set1_ps(direction[i]);
+    a[i]   = _mm256_loadu_ps(v0[i]);
+    b[i]   = _mm256_loadu_ps(v1[i]);
+    c[i]   = _mm256_loadu_ps(v2[i]);
+  }
+
+  hit = glmm_ray_triangle8(o, dir, a, b, c, &dist, &written);
+  if (d)
+    glmm_ray_store8(d, dist, written);
+
+  return hit;
+}
+
+/*!
+ * @brief eight rays stored per component against one triangle
+ *
+ * @param[in]      origin     ray origins, origin[axis][ray]
+ * @param[in]      direction  ray directions
+ * @param[in]      v0         first vertex of triangle
+ * @param[in]      v1         second vertex of triangle
+ * @param[in]      v2         third vertex of triangle
+ * @param[in, out] d          distances, written like glm_ray_triangle() (may be NULL)
+ * @return mask of the rays that hit
+ */
+CGLM_INLINE
+int
+glm_ray8_triangle_avx(float  origin[3][8],
+                      float  direction[3][8],
+                      vec3   v0,
+                      vec3   v1,
+                      vec3   v2,
+                      float *d) {
+  __m256 o[3], dir[3], a[3], b[3], c[3], dist, written;
+  int    i, hit;
+
+  for (i = 0; i < 3; i++) {
+    o[i]   = _mm256_loadu_ps(origin[i]);
+    dir[i] = _mm256_loadu_ps(direction[i]);
+    a[i]   = _mm256_set1_ps(v0[i]);
+    b[i]   = _mm256_set1_ps(v1[i]);
+    c[i]   = _mm256_set1_ps(v2[i]);
+  }
+
+  hit = glmm_ray_triangle8(o, dir, a, b, c, &dist, &written);
+  if (d)
+    glmm_ray_store8(d, dist, written);
+
+  return hit;
+}
+
+#endif
+#endif /* cglm_ray_avx_h */
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c), Recep Aslantas.
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#ifndef cglm_ray_sse2_h
+#define cglm_ray_sse2_h
+#if defined( __SSE2__ )
+
+#include "../../common.h"
+#include "../intrin.h"
+
+/*!
+ * @brief Möller–Trumbore for four ray/triangle pairs at once, one lane each
+ *
+ * Same operations in the same order as glm_ray_triangle(), so every lane gives
+ * the same result as the scalar function would for that pair.
+ *
+ * @param[in]  o        ray origins, one register per component
+ * @param[in]  dir      ray directions
+ * @param[in]  v0       first vertices
+ * @param[in]  v1       second vertices
+ * @param[in]  v2       third vertices
+ * @param[out] dist     distances, only meaningful in lanes set in *written
+ * @param[out] written  all bits set in the lanes the scalar function would
+ *                      have written d for
+ * @return mask of the lanes that hit
+ */
+CGLM_INLINE
+int
+glmm_ray_triangle4(__m128 o[3],
+                   __m128 dir[3],
+                   __m128 v0[3],
+                   __m128 v1[3],
+                   __m128 v2[3],
+                   __m128 *dist,
+                   __m128 *written) {
+  __m128 e1[3], e2[3], p[3], t[3], q[3];
+  __m128 det, inv_det, u, v, miss, eps, zero, one;
+  int    i;
+
+  eps  = _mm_set1_ps(0.000001f);
+  zero = _mm_setzero_ps();
+  one  = _mm_set1_ps(1.0f);
+
+  for (i = 0; i < 3; i++) {
+    e1[i] = _mm_sub_ps(v1[i], v0[i]);
+    e2[i] = _mm_sub_ps(v2[i], v0[i]);
+    t[i]  = _mm_sub_ps(o[i], v0[i]);
+  }
+
+  p[0] = _mm_sub_ps(_mm_mul_ps(dir[1], e2[2]), _mm_mul_ps(dir[2], e2[1]));
+  p[1] = _mm_sub_ps(_mm_mul_ps(dir[2], e2[0]), _mm_mul_ps(dir[0], e2[2]));
+  p[2] = _mm_sub_ps(_mm_mul_ps(dir[0], e2[1]), _mm_mul_ps(dir[1], e2[0]));
+
+  det  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1[0], p[0]), _mm_mul_ps(e1[1], p[1])),
+                    _mm_mul_ps(e1[2], p[2]));
+  miss = _mm_and_ps(_mm_cmpgt_ps(det, _mm_set1_ps(-0.000001f)),
+                    _mm_cmplt_ps(det, eps));
+
+  inv_det = _mm_div_ps(one, det);
+
+  u    = _mm_mul_ps(inv_det,
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(t[0], p[0]), _mm_mul_ps(t[1], p[1])),
+                               _mm_mul_ps(t[2], p[2])));
+  miss = _mm_or_ps(miss, _mm_or_ps(_mm_cmplt_ps(u, zero), _mm_cmpgt_ps(u, one)));
+
+  q[0] = _mm_sub_ps(_mm_mul_ps(t[1], e1[2]), _mm_mul_ps(t[2], e1[1]));
+  q[1] = _mm_sub_ps(_mm_mul_ps(t[2], e1[0]), _mm_mul_ps(t[0], e1[2]));
+  q[2] = _mm_sub_ps(_mm_mul_ps(t[0], e1[1]), _mm_mul_ps(t[1], e1[0]));
+
+  v    = _mm_mul_ps(inv_det,
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(dir[0], q[0]), _mm_mul_ps(dir[1], q[1])),
+                               _mm_mul_ps(dir[2], q[2])));
+  miss = _mm_or_ps(miss, _mm_or_ps(_mm_cmplt_ps(v, zero),
+                                   _mm_cmpgt_ps(_mm_add_ps(u, v), one)));
+
+  *dist    = _mm_mul_ps(inv_det,
+                        _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2[0], q[0]), _mm_mul_ps(e2[1], q[1])),
+                                   _mm_mul_ps(e2[2], q[2])));
+  *written = _mm_andnot_ps(miss, _mm_castsi128_ps(_mm_set1_epi32(-1)));
+
+  return _mm_movemask_ps(_mm_andnot_ps(miss, _mm_cmpgt_ps(*dist, eps)));
+}
+
+/* stores the lanes in written, leaves the rest of d alone */
+CGLM_INLINE
+void
+glmm_ray_store4(float *d, __m128 dist, __m128 written) {
+  _mm_storeu_ps(d, _mm_or_ps(_mm_and_ps(written, dist),
+                             _mm_andnot_ps(written, _mm_loadu_ps(d))));
+}
+
+#endif
+#endif /* cglm_ray_sse2_h */
@@ -0,0 +1,125 @@
+#ifndef ECS_H_
+#define ECS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "utils/pool.h"
+
+// Entities and their components, grouped by archetype (the exact set of
+// components an entity has). Each archetype keeps its entities in fixed-size
+// chunks, every component in its own array starting on a cache line, so a
+// query walks plain contiguous arrays chunk by chunk. Removing an entity moves
+// the archetype's last one into the hole, and adding or removing a component
+// moves the entity to the archetype next door.
+
+#define ECS_MAX_COMPONENTS 64
+#define ECS_CHUNK_SIZE (16 * 1024)
+// chunks come from the world's pool this many at a time
+#define ECS_CHUNKS_PER_BLOCK 16
+
+// index in the low 24 bits, a generation in the high 8 so stale handles are
+// caught; 0 is never a live entity
+typedef uint32_t ecs_entity;
+#define ECS_NULL ((ecs_entity)0)
+#define ECS_MAX_ENTITIES (1 << 24)
+
+typedef uint64_t ecs_mask;
+#define ECS_BIT(component) ((ecs_mask)1 << (component))
+
+typedef struct {
+  ecs_mask mask;
+  // byte offset of each component's array in a chunk, by component id
+  uint32_t offsets[ECS_MAX_COMPONENTS];
+  int chunk_capacity;
+  // every chunk in use is full except the last; one emptied chunk is kept
+  // and the rest go back to the world's pool
+  char **chunks;
+  int num_chunks;
+  int max_chunks;
+  int count;
+  // archetype reached by adding or removing each component, -1 if not known yet
+  int add_edge[ECS_MAX_COMPONENTS];
+  int remove_edge[ECS_MAX_COMPONENTS];
+} ecs_archetype;
+
+typedef struct {
+  // archetype and row while alive, next free index in row while not
+  int archetype;
+  int row;
+  uint8_t generation;
+} ecs_record;
+
+typedef struct {
+  size_t sizes[ECS_MAX_COMPONENTS];
+  int num_components;
+
+  ecs_archetype *archetypes;
+  int num_archetypes;
+  int max_archetypes;
+
+  ecs_record *records;
+  int num_records;
+  int max_records;
+  int free_head;
+
+  // every archetype's chunks
+  pool chunk_pool;
+
+  int count;
+} ecs_world;
+
+// One chunk at a time of every archetype that has all of mask. Entities may
+// not be created, destroyed or moved while a query is running.
+typedef struct {
+  ecs_world *world;
+  ecs_mask mask;
+  int archetype;
+  int chunk;
+
+  // the current chunk
+  int count;
+  ecs_entity *entities;
+  char *data;
+  const uint32_t *offsets;
+} ecs_query;
+
+int ecs_init(ecs_world *world);
+
+void ecs_free(ecs_world *world);
+
+// returns the new component's id, -1 if there are ECS_MAX_COMPONENTS already
+int ecs_register(ecs_world *world, size_t size);
+
+// an entity with the components in mask, all zeroed; ECS_NULL if out of memory
+ecs_entity ecs_create(ecs_world *world, ecs_mask mask);
+
+// count entities at once, returns how many were created
+int ecs_create_many(ecs_world *world, ecs_mask mask, int count, ecs_entity *out);
+
+void ecs_destroy(ecs_world *world, ecs_entity entity);
+
+int ecs_alive(const ecs_world *world, ecs_entity entity);
+
+ecs_mask ecs_components(const ecs_world *world, ecs_entity entity);
+
+// NULL if the entity is gone or lacks the component. Valid until the entity's
+// archetype next changes (any create, destroy, add or remove in it).
+void *ecs_get(const ecs_world *world, ecs_entity entity, int component);
+
+// the new component is zeroed; 0 on success or if it was already there, -1
+// if out of memory
+int ecs_add(ecs_world *world, ecs_entity entity, int component);
+
+int ecs_remove(ecs_world *world, ecs_entity entity, int component);
+
+void ecs_query_init(ecs_query *query, ecs_world *world, ecs_mask mask);
+
+// moves to the next non-empty chunk, 0 when there are no more
+int ecs_query_next(ecs_query *query);
+
+// the current chunk's array of a component in the query's mask
+static inline void *ecs_column(const ecs_query *query, int component) {
+  return query->data + query->offsets[component];
+}
+
+#endif // ECS_H_
@@ -1,17 +1,48 @@
 #ifndef ENGINE_H_
 #define ENGINE_H_
 
+#include "ecs.h"
+#include "render/cull.h"
+#include "render/render_queue.h"
+#include "render/ring_buffer.h"
+#include "render/program_cache.h"
+#include "render/shader_pipeline.h"
+#include "render/texture.h"
+#include "utils/jobs.h"
+
+// per frame, so three times this is allocated
+#define ENGINE_STREAM_FRAME_SIZE (16 * 1024 * 1024)
+
+#define ENGINE_PROGRAM_CACHE_DIR "build/shader_cache"
+
 enum engine_shader_type {
   ENGINE_VERT_SHADER,
   ENGINE_FRAG_SHADER
 };
 
-typedef struct {
+typedef struct engine_window engine_window;
 
+typedef struct {
+  // one worker per core, shared by culling, texture decoding and parallel_range()
+  job_system jobs;
+  // everything drawn in a frame goes through here, engine_draw() flushes it
+  render_queue queue;
+  // per-frame vertex and uniform data, recycled once the GPU is done with it
+  ring_buffer stream;
+  program_cache programs;
+  // builds programs in the background, polled by engine_draw()
+  shader_pipeline shaders;
+  // decoded on the job system, uploaded by engine_draw()
+  texture_manager textures;
+  cull_pool culler;
+  // everything in the scene, as entities with components
+  ecs_world world;
 } engine_state;
 
 int engine_init(engine_state *state);
 
+void engine_free(engine_state *state);
+
 void engine_window_init(engine_state *state, engine_window *window);
 
 int engine_add_shader(engine_state *state, int shader_type);
@@ -0,0 +1,42 @@
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include "cglm/cglm.h"
+
+// Batched versions of cglm functions, running on the kernels simd_init()
+// picked for this CPU. Results match the single cglm calls up to rounding
+// (FMA contracts some products). dest may not overlap the inputs, except that
+// the vector and bounds transforms can work in place. Arrays need no particular
+// alignment, though 32-byte aligned ones avoid loads split across cache lines.
+
+// dest[i] = a[i] * b[i]
+void batch_mat4_mul(mat4 *a, mat4 *b, mat4 *dest, int count);
+
+// dest[i] = inverse of m[i]
+void batch_mat4_inv(mat4 *m, mat4 *dest, int count);
+
+// dest[i] = m[i] * v[i]
+void batch_mat4_mulv(mat4 *m, vec4 *v, vec4 *dest, int count);
+
+// out[i] = m * in[i], for count packed vec4
+void batch_transform_vec4(mat4 m, const vec4 *in, vec4 *out, int count);
+
+// out[i] = (m * (in[i], 1)).xyz, positions (no perspective divide)
+void batch_transform_points(mat4 m, const vec3 *in, vec3 *out, int count);
+
+// out[i] = (m * (in[i], 0)).xyz, directions; use the inverse transpose for normals
+void batch_transform_dirs(mat4 m, const vec3 *in, vec3 *out, int count);
+
+// The same on separate x, y and z arrays: in[0] holds x, in[1] y and in[2] z.
+void batch_transform_points_soa(mat4 m, const float *const in[3], float *const out[3], int count);
+
+void batch_transform_dirs_soa(mat4 m, const float *const in[3], float *const out[3], int count);
+
+// dest[i] = boxes[i] moved by m[i], as glm_aabb_transform()
+void batch_aabb_transform(vec3 (*boxes)[2], mat4 *m, vec3 (*dest)[2], int count);
+
+// dest[i] = spheres[i] moved by m[i]. Unlike glm_sphere_transform() the radius
+// is scaled by the matrix's largest axis scale, so it stays a bound.
+void batch_sphere_transform(vec4 *spheres, mat4 *m, vec4 *dest, int count);
+
+#endif // BATCH_H_
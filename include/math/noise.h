@@ -0,0 +1,44 @@
+#ifndef NOISE_H_
+#define NOISE_H_
+
+#include "cglm/cglm.h"
+
+// Gradient noise for many points at once, on the kernels simd_init() picked.
+// Perlin agrees with glm_perlin_vec2/vec3 up to rounding; simplex is the
+// usual webgl-noise version. Both land roughly in [-1, 1]. Grids are split
+// into bands of rows across threads.
+
+typedef enum {
+  NOISE_PERLIN,
+  NOISE_SIMPLEX,
+} noise_type;
+
+typedef struct {
+  noise_type type;
+  // fBm: octave k is sampled at frequency * lacunarity^k and weighted by
+  // gain^k, with the weights scaled to sum to 1
+  int octaves;
+  float frequency;
+  float lacunarity;
+  float gain;
+} noise_params;
+
+// one octave at frequency 1, the plain noise function
+#define NOISE_PARAMS(type) ((noise_params){(type), 1, 1.0f, 2.0f, 0.5f})
+
+// out[i] = noise at points[i]
+void noise_points2(const noise_params *params, const vec2 *points, float *out, int count);
+
+void noise_points3(const noise_params *params, const vec3 *points, float *out, int count);
+
+// Fills out with a width x height grid (x fastest) sampled at
+// origin + (x, y) * spacing. num_threads 0 uses one per core, 1 keeps it all
+// on the calling thread.
+void noise_grid2(const noise_params *params, vec2 origin, float spacing, int width, int height, float *out,
+                 int num_threads);
+
+// the same for width x height x depth, x fastest, then y
+void noise_grid3(const noise_params *params, vec3 origin, float spacing, int width, int height, int depth, float *out,
+                 int num_threads);
+
+#endif // NOISE_H_
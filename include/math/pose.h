@@ -0,0 +1,46 @@
+#ifndef POSE_H_
+#define POSE_H_
+
+#include "cglm/cglm.h"
+
+// Bone transforms for many bones at once (every bone of every animated
+// character, say), each component in its own array so blends and matrix
+// builds run a vector of bones at a time on the kernels simd_init() picked.
+// Rotations are cglm quaternions, x y z w.
+
+#define POSE_BATCH 16
+
+typedef struct {
+  // 64-byte aligned, capacity is a multiple of POSE_BATCH and the bones past
+  // count are padding the kernels may read and write
+  float *rotation[4];
+  float *translation[3];
+  float *scale[3];
+  int count;
+  int capacity;
+} pose;
+
+typedef enum {
+  POSE_NLERP,  // as glm_quat_nlerp(): cheaper, the speed along the arc varies a little
+  POSE_SLERP,  // as glm_quat_slerp(), for t in [0, 1]
+} pose_blend_mode;
+
+// count bones, all at the identity
+int pose_init(pose *p, int count);
+
+void pose_free(pose *p);
+
+void pose_set(pose *p, int bone, versor rotation, vec3 translation, vec3 scale);
+
+void pose_get(const pose *p, int bone, versor rotation, vec3 translation, vec3 scale);
+
+// out = a blended towards b by t; translation and scale lerp, rotation as
+// mode says. All three have the same count, out may be a or b. num_threads 0
+// uses one per core, 1 keeps it on the calling thread.
+void pose_blend(const pose *a, const pose *b, float t, pose_blend_mode mode, pose *out, int num_threads);
+
+// dest[i] = translation * rotation * scale of bone i, as glm_translate,
+// glm_quat_mat4 and glm_scale would build it
+void pose_matrices(const pose *p, mat4 *dest, int num_threads);
+
+#endif // POSE_H_
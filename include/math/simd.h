@@ -0,0 +1,100 @@
+#ifndef SIMD_H_
+#define SIMD_H_
+
+#include <stdint.h>
+#include "cglm/cglm.h"
+#include "math/pose.h"
+#include "render/cull.h"
+
+// Runtime selection of the batch math kernels. cglm picks its SIMD path from
+// the compiler flags, so the files holding the kernels are compiled once per
+// instruction set (see src/Makefile.am), each copy with its own SIMD_SUFFIX,
+// and simd_init() points the table at the best copy the CPU can run.
+//
+// mat4 is 32-byte aligned in the AVX copies and 16-byte aligned everywhere
+// else, so kernels take matrices as plain float arrays, 16 floats each.
+
+#ifndef SIMD_SUFFIX
+#define SIMD_SUFFIX base
+#endif
+
+#define SIMD_CONCAT_(name, suffix) name##_##suffix
+#define SIMD_CONCAT(name, suffix) SIMD_CONCAT_(name, suffix)
+// name of this copy of a kernel, e.g. cull_range_avx2
+#define SIMD_VARIANT(name) SIMD_CONCAT(name, SIMD_SUFFIX)
+
+typedef enum {
+  SIMD_BASE,    // whatever the compiler targets by default, SSE2 on x86-64
+  SIMD_AVX,
+  SIMD_AVX2,    // with FMA
+  SIMD_AVX512,  // AVX-512F
+  SIMD_LEVELS
+} simd_level;
+
+typedef struct {
+  void (*mat4_mul)(const float *a, const float *b, float *dest, int count);
+  void (*mat4_inv)(const float *m, float *dest, int count);
+  void (*mat4_mulv)(const float *m, const float *v, float *dest, int count);
+  void (*transform3)(const float *m, const float *in, float *out, int count, float w);
+  void (*transform3_soa)(const float *m, const float *const in[3], float *const out[3], int count, float w);
+  void (*transform4)(const float *m, const float *in, float *out, int count);
+  void (*aabb_transform)(const float *boxes, const float *m, float *dest, int count);
+  void (*sphere_transform)(const float *spheres, const float *m, float *dest, int count);
+  // out[i] += amplitude * noise(frequency * (in[0][i], in[1][i], in[2][i]))
+  void (*noise_perlin2)(const float *const in[3], float *out, int count, float frequency, float amplitude);
+  void (*noise_perlin3)(const float *const in[3], float *out, int count, float frequency, float amplitude);
+  void (*noise_simplex2)(const float *const in[3], float *out, int count, float frequency, float amplitude);
+  void (*noise_simplex3)(const float *const in[3], float *out, int count, float frequency, float amplitude);
+  void (*pose_blend_range)(const pose *a, const pose *b, pose *out, int begin, int end, float t, int mode);
+  void (*pose_matrices_range)(const pose *p, float *dest, int begin, int end);
+  int (*cull_range)(const cull_bounds *bounds, vec4 planes[6], int begin, int end, uint32_t *out);
+} simd_kernels;
+
+#define SIMD_DECLARE_KERNELS(suffix) \
+  void SIMD_CONCAT(batch_mat4_mul, suffix)(const float *a, const float *b, float *dest, int count); \
+  void SIMD_CONCAT(batch_mat4_inv, suffix)(const float *m, float *dest, int count); \
+  void SIMD_CONCAT(batch_mat4_mulv, suffix)(const float *m, const float *v, float *dest, int count); \
+  void SIMD_CONCAT(batch_transform3, suffix)(const float *m, const float *in, float *out, int count, float w); \
+  void SIMD_CONCAT(batch_transform3_soa, suffix)(const float *m, const float *const in[3], float *const out[3], \
+                                                 int count, float w); \
+  void SIMD_CONCAT(batch_transform4, suffix)(const float *m, const float *in, float *out, int count); \
+  void SIMD_CONCAT(batch_aabb_transform, suffix)(const float *boxes, const float *m, float *dest, int count); \
+  void SIMD_CONCAT(batch_sphere_transform, suffix)(const float *spheres, const float *m, float *dest, int count); \
+  void SIMD_CONCAT(noise_perlin2, suffix)(const float *const in[3], float *out, int count, float frequency, \
+                                          float amplitude); \
+  void SIMD_CONCAT(noise_perlin3, suffix)(const float *const in[3], float *out, int count, float frequency, \
+                                          float amplitude); \
+  void SIMD_CONCAT(noise_simplex2, suffix)(const float *const in[3], float *out, int count, float frequency, \
+                                           float amplitude); \
+  void SIMD_CONCAT(noise_simplex3, suffix)(const float *const in[3], float *out, int count, float frequency, \
+                                           float amplitude); \
+  void SIMD_CONCAT(pose_blend_range, suffix)(const pose *a, const pose *b, pose *out, int begin, int end, float t, \
+                                             int mode); \
+  void SIMD_CONCAT(pose_matrices_range, suffix)(const pose *p, float *dest, int begin, int end); \
+  int SIMD_CONCAT(cull_range, suffix)(const cull_bounds *bounds, vec4 planes[6], int begin, int end, uint32_t *out);
+
+SIMD_DECLARE_KERNELS(base)
+#if defined(__x86_64__) || defined(__i386__)
+SIMD_DECLARE_KERNELS(avx)
+SIMD_DECLARE_KERNELS(avx2)
+SIMD_DECLARE_KERNELS(avx512)
+#endif
+
+// starts out on the base kernels, so it is usable before simd_init()
+extern simd_kernels simd;
+
+// best level this CPU and OS support
+simd_level simd_detect(void);
+
+// Picks the kernels for simd_detect(), or for GAME_SIMD=base|avx|avx2|avx512
+// from the environment if that is set and supported. Returns the level used.
+simd_level simd_init(void);
+
+// switches to the kernels for level, which must be simd_detect() or below
+void simd_use(simd_level level);
+
+simd_level simd_current(void);
+
+const char *simd_level_name(simd_level level);
+
+#endif // SIMD_H_
@@ -0,0 +1,234 @@
+#ifndef VFLOAT_H_
+#define VFLOAT_H_
+
+// A float vector as wide as the instruction set the including file is built
+// for: 8 lanes with AVX (the AVX-512 kernels use it too), 4 with SSE2, 1
+// without either. Lets the batch kernels be written once and compiled per
+// level (see math/simd.h). Loads and stores are unaligned unless they say so.
+// Kernels write short loops over vfloat arrays out by hand: gcc -O2 leaves
+// them rolled and keeps the arrays on the stack.
+
+#if defined(__AVX__)
+#include <immintrin.h>
+
+#define VF_WIDTH 8
+typedef __m256 vfloat;
+
+#define vf_load(p) _mm256_load_ps(p)
+#define vf_loadu(p) _mm256_loadu_ps(p)
+#define vf_store(p, a) _mm256_store_ps(p, a)
+#define vf_storeu(p, a) _mm256_storeu_ps(p, a)
+#define vf_set1(x) _mm256_set1_ps(x)
+#define vf_add(a, b) _mm256_add_ps(a, b)
+#define vf_sub(a, b) _mm256_sub_ps(a, b)
+#define vf_mul(a, b) _mm256_mul_ps(a, b)
+#define vf_min(a, b) _mm256_min_ps(a, b)
+#define vf_max(a, b) _mm256_max_ps(a, b)
+#define vf_sqrt(a) _mm256_sqrt_ps(a)
+#define vf_div(a, b) _mm256_div_ps(a, b)
+#define vf_abs(a) _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a)
+#define vf_floor(a) _mm256_floor_ps(a)
+#define vf_trunc(a) _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC)
+// 1 where x >= edge (or unordered), else 0, as glm_step()
+#define vf_step(edge, x) _mm256_and_ps(_mm256_cmp_ps(x, edge, _CMP_NLT_UQ), _mm256_set1_ps(1.0f))
+// masks from vf_cmplt are only meant for vf_select, which takes a where set
+#define vf_cmplt(a, b) _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define vf_select(mask, a, b) _mm256_blendv_ps(b, a, mask)
+#ifdef __FMA__
+#define vf_fmadd(a, b, c) _mm256_fmadd_ps(a, b, c)
+#else
+#define vf_fmadd(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#endif
+
+// 8 packed vec3 (24 floats) to x, y and z. The shuffles are the SSE2 ones
+// below, done for points 0-3 in the low half and 4-7 in the high half.
+static inline void vf_load3(const float *p, vfloat *x, vfloat *y, vfloat *z) {
+  __m256 a = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)), _mm_loadu_ps(p + 12), 1);
+  __m256 b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 4)), _mm_loadu_ps(p + 16), 1);
+  __m256 c = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 8)), _mm_loadu_ps(p + 20), 1);
+  __m256 t = _mm256_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+  *x = _mm256_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+  *y = _mm256_shuffle_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 2, 1)), t, _MM_SHUFFLE(3, 1, 2, 0));
+  *z = _mm256_shuffle_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+}
+
+static inline void vf_store3(float *p, vfloat x, vfloat y, vfloat z) {
+  __m256 a = _mm256_shuffle_ps(_mm256_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)),
+                               _mm256_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+  __m256 b = _mm256_shuffle_ps(_mm256_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)),
+                               _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+  __m256 c = _mm256_shuffle_ps(_mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)),
+                               _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+  _mm_storeu_ps(p, _mm256_castps256_ps128(a));
+  _mm_storeu_ps(p + 4, _mm256_castps256_ps128(b));
+  _mm_storeu_ps(p + 8, _mm256_castps256_ps128(c));
+  _mm_storeu_ps(p + 12, _mm256_extractf128_ps(a, 1));
+  _mm_storeu_ps(p + 16, _mm256_extractf128_ps(b, 1));
+  _mm_storeu_ps(p + 20, _mm256_extractf128_ps(c, 1));
+}
+
+// 4 floats at p + k * stride into lane k of v[0..3], for the 8 lanes k: a
+// 4x4 transpose per 128-bit half, items 0-3 low and 4-7 high
+static inline void vf_transpose4(__m256 v[4]) {
+  __m256 t0 = _mm256_unpacklo_ps(v[0], v[1]), t1 = _mm256_unpacklo_ps(v[2], v[3]);
+  __m256 t2 = _mm256_unpackhi_ps(v[0], v[1]), t3 = _mm256_unpackhi_ps(v[2], v[3]);
+  v[0] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+  v[1] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+  v[2] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  v[3] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+static inline void vf_load4t(const float *p, int stride, vfloat v[4]) {
+  v[0] = _mm256_loadu2_m128(p + 4 * stride, p);
+  v[1] = _mm256_loadu2_m128(p + 5 * stride, p + stride);
+  v[2] = _mm256_loadu2_m128(p + 6 * stride, p + 2 * stride);
+  v[3] = _mm256_loadu2_m128(p + 7 * stride, p + 3 * stride);
+  vf_transpose4(v);
+}
+
+// the reverse of vf_load4t
+static inline void vf_store4t(float *p, int stride, const vfloat v[4]) {
+  __m256 t[4] = {v[0], v[1], v[2], v[3]};
+  vf_transpose4(t);
+  _mm256_storeu2_m128(p + 4 * stride, p, t[0]);
+  _mm256_storeu2_m128(p + 5 * stride, p + stride, t[1]);
+  _mm256_storeu2_m128(p + 6 * stride, p + 2 * stride, t[2]);
+  _mm256_storeu2_m128(p + 7 * stride, p + 3 * stride, t[3]);
+}
+
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+
+#define VF_WIDTH 4
+typedef __m128 vfloat;
+
+#define vf_load(p) _mm_load_ps(p)
+#define vf_loadu(p) _mm_loadu_ps(p)
+#define vf_store(p, a) _mm_store_ps(p, a)
+#define vf_storeu(p, a) _mm_storeu_ps(p, a)
+#define vf_set1(x) _mm_set1_ps(x)
+#define vf_add(a, b) _mm_add_ps(a, b)
+#define vf_sub(a, b) _mm_sub_ps(a, b)
+#define vf_mul(a, b) _mm_mul_ps(a, b)
+#define vf_min(a, b) _mm_min_ps(a, b)
+#define vf_max(a, b) _mm_max_ps(a, b)
+#define vf_sqrt(a) _mm_sqrt_ps(a)
+#define vf_div(a, b) _mm_div_ps(a, b)
+#define vf_abs(a) _mm_andnot_ps(_mm_set1_ps(-0.0f), a)
+#define vf_step(edge, x) _mm_and_ps(_mm_cmpnlt_ps(x, edge), _mm_set1_ps(1.0f))
+#define vf_cmplt(a, b) _mm_cmplt_ps(a, b)
+#define vf_select(mask, a, b) _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b))
+
+// SSE2 has no rounding instruction: round through int32, leaving alone the
+// values of 2^23 and up, which are whole numbers already
+static inline __m128 vf_trunc(__m128 a) {
+  __m128 big = _mm_cmpge_ps(vf_abs(a), _mm_set1_ps(8388608.0f));
+  __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+  return _mm_or_ps(_mm_and_ps(big, a), _mm_andnot_ps(big, t));
+}
+
+static inline __m128 vf_floor(__m128 a) {
+  __m128 t = vf_trunc(a);
+  return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+}
+#define vf_fmadd(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+
+// 4 packed vec3 (12 floats) to x, y and z
+static inline void vf_load3(const float *p, vfloat *x, vfloat *y, vfloat *z) {
+  __m128 a = _mm_loadu_ps(p);      // x0 y0 z0 x1
+  __m128 b = _mm_loadu_ps(p + 4);  // y1 z1 x2 y2
+  __m128 c = _mm_loadu_ps(p + 8);  // z2 x3 y3 z3
+  __m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+  *x = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+  *y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 2, 1)), t, _MM_SHUFFLE(3, 1, 2, 0));
+  *z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+}
+
+static inline void vf_store3(float *p, vfloat x, vfloat y, vfloat z) {
+  _mm_storeu_ps(p, _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)),
+                                  _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+  _mm_storeu_ps(p + 4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)),
+                                      _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+  _mm_storeu_ps(p + 8, _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)),
+                                      _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+// 4 floats at p + k * stride into lane k of v[0..3]
+static inline void vf_load4t(const float *p, int stride, vfloat v[4]) {
+  v[0] = _mm_loadu_ps(p);
+  v[1] = _mm_loadu_ps(p + stride);
+  v[2] = _mm_loadu_ps(p + 2 * stride);
+  v[3] = _mm_loadu_ps(p + 3 * stride);
+  _MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+}
+
+static inline void vf_store4t(float *p, int stride, const vfloat v[4]) {
+  __m128 t0 = v[0], t1 = v[1], t2 = v[2], t3 = v[3];
+  _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+  _mm_storeu_ps(p, t0);
+  _mm_storeu_ps(p + stride, t1);
+  _mm_storeu_ps(p + 2 * stride, t2);
+  _mm_storeu_ps(p + 3 * stride, t3);
+}
+
+#else
+#include <math.h>
+
+#define VF_WIDTH 1
+typedef float vfloat;
+
+#define vf_load(p) (*(p))
+#define vf_loadu(p) (*(p))
+#define vf_store(p, a) (*(p) = (a))
+#define vf_storeu(p, a) (*(p) = (a))
+#define vf_set1(x) (x)
+#define vf_add(a, b) ((a) + (b))
+#define vf_sub(a, b) ((a) - (b))
+#define vf_mul(a, b) ((a) * (b))
+#define vf_min(a, b) fminf(a, b)
+#define vf_max(a, b) fmaxf(a, b)
+#define vf_sqrt(a) sqrtf(a)
+#define vf_div(a, b) ((a) / (b))
+#define vf_abs(a) fabsf(a)
+#define vf_floor(a) floorf(a)
+#define vf_trunc(a) truncf(a)
+#define vf_step(edge, x) ((x) < (edge) ? 0.0f : 1.0f)
+#define vf_cmplt(a, b) ((a) < (b) ? 1.0f : 0.0f)
+#define vf_select(mask, a, b) ((mask) != 0.0f ? (a) : (b))
+#define vf_fmadd(a, b, c) ((a) * (b) + (c))
+
+static inline void vf_load3(const float *p, vfloat *x, vfloat *y, vfloat *z) {
+  *x = p[0];
+  *y = p[1];
+  *z = p[2];
+}
+
+static inline void vf_store3(float *p, vfloat x, vfloat y, vfloat z) {
+  p[0] = x;
+  p[1] = y;
+  p[2] = z;
+}
+
+static inline void vf_load4t(const float *p, int stride, vfloat v[4]) {
+  (void)stride;
+  v[0] = p[0];
+  v[1] = p[1];
+  v[2] = p[2];
+  v[3] = p[3];
+}
+
+static inline void vf_store4t(float *p, int stride, const vfloat v[4]) {
+  (void)stride;
+  p[0] = v[0];
+  p[1] = v[1];
+  p[2] = v[2];
+  p[3] = v[3];
+}
+#endif
+
+// as glm_vec4_fract(), kept below 1 where rounding would reach it
+static inline vfloat vf_fract(vfloat a) {
+  return vf_min(vf_sub(a, vf_floor(a)), vf_set1(0.999999940395355224609375f));
+}
+
+#endif // VFLOAT_H_
@@ -0,0 +1,18 @@
+#ifndef HEADLESS_H_
+#define HEADLESS_H_
+
+// Offscreen GL 3.3 core context through EGL, for machines without a display.
+// Uses a surfaceless context when the driver supports it and falls back to a
+// 1x1 pbuffer otherwise. Frames are rendered into an FBO instead of a window.
+
+int headless_init(void);
+
+// for gladLoadGLLoader, only valid after headless_init()
+void *headless_get_proc_address(const char *name);
+
+// needs a loaded GL; (re)creates the render target and leaves it bound
+int headless_create_framebuffer(int width, int height);
+
+void headless_terminate(void);
+
+#endif // HEADLESS_H_
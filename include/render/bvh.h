@@ -0,0 +1,87 @@
+#ifndef BVH_H_
+#define BVH_H_
+
+#include <stdint.h>
+#include "cglm/cglm.h"
+
+// Bounding volume hierarchy over axis-aligned boxes, for visibility, picking
+// and broadphase queries. Nodes are four wide with their children's bounds
+// stored per axis, so one node is tested against a query with a single SSE
+// operation per component. bvh_build() does a binned SAH build; objects can
+// also be inserted and removed one at a time, and moved with bvh_update() (one
+// path) or bvh_set_box() followed by bvh_refit() (everything at once). Heavy
+// churn slowly degrades the tree, rebuild it now and then.
+
+#define BVH_WIDTH 4
+#define BVH_EMPTY -1
+// bins per axis for the SAH build
+#define BVH_BINS 16
+
+typedef struct {
+  // empty slots hold an inverted box
+  float min_x[BVH_WIDTH], min_y[BVH_WIDTH], min_z[BVH_WIDTH];
+  float max_x[BVH_WIDTH], max_y[BVH_WIDTH], max_z[BVH_WIDTH];
+  // a node index, BVH_EMPTY, or an item encoded as -2 - item
+  int32_t child[BVH_WIDTH];
+  int32_t parent;
+  int32_t parent_slot;  // next free node while on the free list
+  int32_t pad[2];
+} bvh_node;
+
+typedef struct {
+  vec3 box[2];
+  int node;  // -1 once removed
+  int slot;  // next free item once removed
+} bvh_item;
+
+typedef struct {
+  // node 0 is always the root, 64-byte aligned
+  bvh_node *nodes;
+  int num_nodes;
+  int node_capacity;
+  int free_node;
+
+  bvh_item *items;
+  int num_items;
+  int item_capacity;
+  int free_item;
+} bvh;
+
+// exact test for an item the ray's bounds hit. returns 1 and sets distance
+// (along dir) if the item really is hit.
+typedef int (*bvh_ray_test)(void *user, int item, vec3 origin, vec3 dir, float *distance);
+
+int bvh_init(bvh *tree);
+
+void bvh_free(bvh *tree);
+
+// replaces the contents of the tree, item i gets boxes[i]
+int bvh_build(bvh *tree, vec3 (*boxes)[2], int count);
+
+// returns the new item, -1 if out of memory
+int bvh_insert(bvh *tree, vec3 box[2]);
+
+void bvh_remove(bvh *tree, int item);
+
+// moves one item and refits the nodes above it
+void bvh_update(bvh *tree, int item, vec3 box[2]);
+
+// moves one item without touching the nodes, call bvh_refit() after a batch
+void bvh_set_box(bvh *tree, int item, vec3 box[2]);
+
+void bvh_refit(bvh *tree);
+
+// the queries write up to max_out items and return how many matched, which can
+// be more than max_out
+int bvh_query_frustum(const bvh *tree, vec4 planes[6], int *out, int max_out);
+
+int bvh_query_aabb(const bvh *tree, vec3 box[2], int *out, int max_out);
+
+int bvh_query_sphere(const bvh *tree, vec4 sphere, int *out, int max_out);
+
+// closest item along the ray within max_distance, or -1. with no test the
+// distance to the item's box is used.
+int bvh_raycast(const bvh *tree, vec3 origin, vec3 dir, float max_distance,
+                bvh_ray_test test, void *user, float *distance);
+
+#endif // BVH_H_
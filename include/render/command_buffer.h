@@ -0,0 +1,112 @@
+#ifndef COMMAND_BUFFER_H_
+#define COMMAND_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "glad/glad.h"
+
+// GL work recorded on any thread and replayed on the GL thread. A buffer is
+// one linear block of small POD commands packed back to back, each starting
+// with its type. Recording only appends and makes no GL calls. State a buffer
+// has already set is not recorded again. command_buffer_execute() is a plain
+// decode loop over gl_state, so it is the only part that needs the context.
+
+typedef enum {
+  COMMAND_SET_ENABLED,
+  COMMAND_BLEND_FUNC,
+  COMMAND_DEPTH_MASK,
+  COMMAND_USE_PROGRAM,
+  COMMAND_BIND_VERTEX_ARRAY,
+  COMMAND_BIND_TEXTURE,
+  COMMAND_UNIFORM_MATRIX4,
+  COMMAND_DRAW_ARRAYS
+} command_type;
+
+typedef struct {
+  uint32_t type;
+  GLenum cap;
+  GLint enabled;
+} set_enabled_command;
+
+typedef struct {
+  uint32_t type;
+  GLenum src, dst;
+} blend_func_command;
+
+typedef struct {
+  uint32_t type;
+  GLint mask;
+} depth_mask_command;
+
+typedef struct {
+  uint32_t type;
+  GLuint program;
+} use_program_command;
+
+typedef struct {
+  uint32_t type;
+  GLuint vao;
+} bind_vertex_array_command;
+
+typedef struct {
+  uint32_t type;
+  GLuint unit;
+  GLenum target;
+  GLuint texture;
+} bind_texture_command;
+
+typedef struct {
+  uint32_t type;
+  GLint location;
+  GLfloat value[16];
+} uniform_matrix4_command;
+
+typedef struct {
+  uint32_t type;
+  GLenum mode;
+  GLint first;
+  GLsizei count;
+  GLsizei instance_count;  // 0 for a plain glDrawArrays
+} draw_arrays_command;
+
+typedef struct {
+  char *data;
+  size_t size;
+  size_t capacity;
+  int commands;
+
+  // what the commands so far leave bound, all ones until something is
+  GLuint program, vao, texture;
+  GLenum blend_src, blend_dst;
+  int blend, depth_mask;
+} command_buffer;
+
+void command_buffer_init(command_buffer *buffer);
+
+void command_buffer_free(command_buffer *buffer);
+
+// empties the buffer but keeps its memory
+void command_buffer_reset(command_buffer *buffer);
+
+// each returns -1 if the buffer could not grow
+int command_buffer_set_enabled(command_buffer *buffer, GLenum cap, int enabled);
+
+int command_buffer_blend_func(command_buffer *buffer, GLenum src, GLenum dst);
+
+int command_buffer_depth_mask(command_buffer *buffer, int mask);
+
+int command_buffer_use_program(command_buffer *buffer, GLuint program);
+
+int command_buffer_bind_vertex_array(command_buffer *buffer, GLuint vao);
+
+int command_buffer_bind_texture(command_buffer *buffer, GLuint unit, GLenum target, GLuint texture);
+
+int command_buffer_uniform_matrix4(command_buffer *buffer, GLint location, const GLfloat *value);
+
+int command_buffer_draw_arrays(command_buffer *buffer, GLenum mode, GLint first, GLsizei count,
+                               GLsizei instance_count);
+
+// GL thread only
+void command_buffer_execute(const command_buffer *buffer);
+
+#endif // COMMAND_BUFFER_H_
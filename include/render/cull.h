@@ -0,0 +1,61 @@
+#ifndef CULL_H_
+#define CULL_H_
+
+#include <stdint.h>
+#include "cglm/cglm.h"
+#include "utils/jobs.h"
+
+// Frustum culling for large numbers of boxes. Bounds are kept as separate
+// min/max arrays per axis so the test runs on CULL_BATCH boxes at a time
+// (SSE2, AVX2 or AVX-512, whichever simd_init() picked), and big batches are
+// split across the job system's threads. Results agree with glm_aabb_frustum() up to
+// rounding.
+
+#define CULL_BATCH 16
+#define CULL_MAX_SLICES (JOBS_MAX_WORKERS + 1)
+// below this many boxes the calling thread does it all
+#define CULL_PARALLEL_THRESHOLD 32768
+
+typedef struct {
+  // 64-byte aligned, capacity is a multiple of CULL_BATCH
+  float *min_x, *min_y, *min_z;
+  float *max_x, *max_y, *max_z;
+  int count;
+  int capacity;
+} cull_bounds;
+
+typedef struct {
+  int tested;
+  int visible;
+  double ms;
+} cull_stats;
+
+typedef struct cull_slice cull_slice;
+
+typedef struct {
+  job_system *jobs;
+  cull_slice *slices;
+
+  cull_stats last_stats;
+} cull_pool;
+
+int cull_bounds_init(cull_bounds *bounds, int capacity);
+
+void cull_bounds_free(cull_bounds *bounds);
+
+// returns the index of the new box, -1 if out of memory
+int cull_bounds_add(cull_bounds *bounds, vec3 box[2]);
+
+void cull_bounds_set(cull_bounds *bounds, int index, vec3 box[2]);
+
+// big batches get one slice per thread of jobs, which must outlive the pool
+int cull_pool_init(cull_pool *pool, job_system *jobs);
+
+void cull_pool_free(cull_pool *pool);
+
+// writes the indices of the boxes inside or touching the frustum to visible (room
+// for bounds->count), in ascending order, and returns how many there are.
+// planes come from glm_frustum_planes().
+int cull_frustum(cull_pool *pool, const cull_bounds *bounds, vec4 planes[6], uint32_t *visible);
+
+#endif // CULL_H_
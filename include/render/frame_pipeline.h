@@ -0,0 +1,67 @@
+#ifndef FRAME_PIPELINE_H_
+#define FRAME_PIPELINE_H_
+
+#include <pthread.h>
+#include "cglm/cglm.h"
+#include "render/render_queue.h"
+#include "utils/arena.h"
+#include "utils/jobs.h"
+
+// Two-stage frames: a simulation thread fills in the render snapshot for frame
+// N + 1 (camera and draw packets, recorded into command buffers) while the GL
+// thread executes frame N from the one before. A snapshot is written only by
+// the simulation and, once handed over, only read by the GL thread until it is
+// released. latency is how many frames the simulation may run ahead; each one
+// costs a snapshot. Latency 0 simulates on the GL thread inside
+// frame_pipeline_acquire(), which gives the old strictly sequential frames.
+// Each snapshot carries its own frame arena, reset when the simulation starts
+// on it, so anything transient the frame needs lives exactly as long as the
+// snapshot and the default latency double buffers it.
+
+#define FRAME_PIPELINE_MAX_LATENCY 3
+
+typedef struct {
+  unsigned long frame;
+  mat4 view_projection;
+  // simulate pushes packets, the pipeline records them once it returns
+  render_queue queue;
+  // emptied before simulate runs
+  arena memory;
+} render_snapshot;
+
+// fills in snapshot for the next frame; it is empty apart from frame
+typedef void (*frame_simulate_fn)(void *context, render_snapshot *snapshot);
+
+typedef struct {
+  render_snapshot snapshots[FRAME_PIPELINE_MAX_LATENCY + 1];
+  int num_snapshots;
+  frame_simulate_fn simulate;
+  void *context;
+  job_system *jobs;
+
+  pthread_t thread;
+  int threaded;
+  pthread_mutex_t lock;
+  pthread_cond_t produced_cond, released_cond;
+  // frames simulated, and frames the GL thread is done with
+  unsigned long produced, released;
+  int quit;
+} frame_pipeline;
+
+// The simulation starts right away, so whatever simulate reads must be ready.
+// Snapshots are recorded across the threads of jobs, which may be NULL.
+// frame_memory is what each snapshot's arena starts with.
+int frame_pipeline_init(frame_pipeline *pipeline, int latency, size_t frame_memory, job_system *jobs,
+                        frame_simulate_fn simulate, void *context);
+
+// stops the simulation after the frame it is on
+void frame_pipeline_free(frame_pipeline *pipeline);
+
+// the oldest finished snapshot, waiting for it if need be. GL thread only;
+// executing its queue is the one change to it allowed before it is released.
+render_snapshot *frame_pipeline_acquire(frame_pipeline *pipeline);
+
+// hands the acquired snapshot back to be rewritten
+void frame_pipeline_release(frame_pipeline *pipeline);
+
+#endif // FRAME_PIPELINE_H_
@@ -0,0 +1,68 @@
+#ifndef GL_STATE_H_
+#define GL_STATE_H_
+
+#include "glad/glad.h"
+
+// Shadow copy of the GL state the engine touches, so binds and uniform uploads
+// that would not change anything never reach the driver. Everything starts out
+// unknown, so the first call for each piece of state is always issued.
+// Only valid while all changes to the tracked state go through these functions;
+// call gl_state_invalidate() once the context is current and again after anything
+// else touches it.
+
+#define GL_STATE_MAX_TEXTURE_UNITS 32
+
+typedef struct {
+  unsigned long issued;
+  unsigned long elided;
+} gl_state_counters;
+
+void gl_state_invalidate(void);
+
+// rolls the per-frame counters over, call once at the start of every frame
+void gl_state_begin_frame(void);
+
+gl_state_counters gl_state_last_frame(void);
+
+gl_state_counters gl_state_total(void);
+
+void gl_state_use_program(GLuint program);
+
+void gl_state_bind_vertex_array(GLuint vao);
+
+void gl_state_bind_buffer(GLenum target, GLuint buffer);
+
+void gl_state_bind_framebuffer(GLenum target, GLuint framebuffer);
+
+// also selects the unit, through the same cache
+void gl_state_bind_texture(GLuint unit, GLenum target, GLuint texture);
+
+void gl_state_set_enabled(GLenum cap, int enabled);
+
+void gl_state_blend_func(GLenum src, GLenum dst);
+
+void gl_state_depth_func(GLenum func);
+
+void gl_state_depth_mask(GLboolean mask);
+
+void gl_state_viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+// uniform values are cached per program and location; they apply to the current program
+void gl_state_uniform1i(GLint location, GLint value);
+
+void gl_state_uniform1f(GLint location, GLfloat value);
+
+void gl_state_uniform4fv(GLint location, const GLfloat *value);
+
+void gl_state_uniform_matrix4fv(GLint location, const GLfloat *value);
+
+// delete through these so stale names can't be mistaken for bound objects later
+void gl_state_delete_program(GLuint program);
+
+void gl_state_delete_vertex_arrays(GLsizei n, const GLuint *vaos);
+
+void gl_state_delete_buffers(GLsizei n, const GLuint *buffers);
+
+void gl_state_delete_textures(GLsizei n, const GLuint *textures);
+
+#endif // GL_STATE_H_
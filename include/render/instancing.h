@@ -0,0 +1,34 @@
+#ifndef INSTANCING_H_
+#define INSTANCING_H_
+
+#include "glad/glad.h"
+#include "cglm/cglm.h"
+#include "render/ring_buffer.h"
+
+// Per-instance model matrices fed to a VAO as an instanced mat4 attribute
+// (four consecutive vec4 locations with divisor 1), so any number of copies of
+// a mesh go out in a single instanced draw: a draw packet with the instance
+// buffer's VAO and instance_count set to its count. See shaders/instanced.vert.
+// The matrices are streamed through a ring buffer every frame. The VAO is the
+// instance buffer's own, so the mesh's plain VAO never has instanced arrays
+// enabled on it.
+
+#define INSTANCE_MODEL_ATTRIB 1
+
+typedef struct {
+  GLuint vao;
+  GLsizei count;
+} instance_buffer;
+
+// creates the VAO and leaves it bound for the caller to add the mesh's own
+// attributes to; the model attribute is only enabled once an upload points it
+// somewhere
+int instance_buffer_init(instance_buffer *instances);
+
+void instance_buffer_free(instance_buffer *instances);
+
+// writes this frame's matrices to ring and points the attribute at them;
+// returns -1 if the ring has no room left this frame
+int instance_buffer_upload(instance_buffer *instances, ring_buffer *ring, const mat4 *models, GLsizei count);
+
+#endif // INSTANCING_H_
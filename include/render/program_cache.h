@@ -0,0 +1,36 @@
+#ifndef PROGRAM_CACHE_H_
+#define PROGRAM_CACHE_H_
+
+#include <stdint.h>
+#include "glad/glad.h"
+
+// On-disk cache of linked program binaries (GL_ARB_get_program_binary), keyed
+// by a hash of the shader sources, the defines and the driver's vendor,
+// renderer and version strings. A binary the driver rejects is deleted and the
+// program is rebuilt from source, so a driver update only costs one slow start.
+
+typedef struct {
+  char dir[256];
+  int enabled;          // context supports it and offers at least one binary format
+  uint64_t driver_hash;
+
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long rejected;
+} program_cache;
+
+// dir is created if missing; without driver support every lookup just compiles
+int program_cache_init(program_cache *cache, const char *dir);
+
+uint64_t program_cache_key(const program_cache *cache, const char *vs_src, const char *fs_src, const char *defines);
+
+// returns a ready program, or 0 on a miss (a rejected binary counts as one)
+GLuint program_cache_load(program_cache *cache, uint64_t key);
+
+// program must be linked with the retrievable hint
+void program_cache_store(program_cache *cache, uint64_t key, GLuint program);
+
+// load, or compile + link + store; returns 0 if the sources don't compile or link
+GLuint program_cache_get(program_cache *cache, const char *vs_src, const char *fs_src, const char *defines);
+
+#endif // PROGRAM_CACHE_H_
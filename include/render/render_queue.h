@@ -0,0 +1,95 @@
+#ifndef RENDER_QUEUE_H_
+#define RENDER_QUEUE_H_
+
+#include <stdint.h>
+#include "glad/glad.h"
+#include "cglm/cglm.h"
+#include "render/command_buffer.h"
+#include "utils/jobs.h"
+
+// Draw packets are pushed in any order with a 64-bit sort key, radix sorted once
+// per frame and submitted so that packets sharing a program/material end up
+// next to each other. Submitting is split in two: recording turns the sorted
+// packets into command buffers, a range of them per thread and without any GL
+// calls, and executing replays the buffers in order on the GL thread.
+//
+// key layout, most significant bit first (the low byte is always zero, so the
+// sort skips it):
+//   opaque:      layer:4 | 0 | program:11 | material:16 | depth:24 (front to back) | 0:8
+//   translucent: layer:4 | 1 | depth:24 (back to front) | program:11 | material:16 | 0:8
+
+#define RENDER_QUEUE_MAX_LAYERS 16
+#define RENDER_QUEUE_MAX_BUFFERS (JOBS_MAX_WORKERS + 1)
+// packets per thread below which recording uses fewer threads
+#define RENDER_QUEUE_MIN_RECORD 4096
+
+typedef struct {
+  GLuint program;
+  GLuint vao;
+  GLuint texture;          // bound to unit 0, 0 for none
+  GLint transform_loc;     // -1 to leave the transform alone
+  GLenum mode;
+  GLint first;
+  GLsizei count;
+  GLsizei instance_count;  // 0 for a plain glDrawArrays
+  int translucent;         // alpha blended, without depth writes
+  mat4 transform;
+} draw_packet;
+
+typedef struct {
+  uint64_t key;
+  uint32_t packet;
+  uint32_t pad;
+} sort_item;
+
+typedef struct {
+  int packets;
+  // program/vao/texture switches in sorted order vs. in the order packets were pushed
+  int state_changes;
+  int unsorted_state_changes;
+  double sort_ms;
+  double record_ms;
+  // command buffers recorded, one per thread that took part
+  int buffers;
+} render_queue_stats;
+
+typedef struct {
+  draw_packet *packets;
+  sort_item *items;
+  sort_item *scratch;
+  int count;
+  int capacity;
+  int unsorted_state_changes;
+
+  // recorded and waiting to be executed, in order
+  command_buffer buffers[RENDER_QUEUE_MAX_BUFFERS];
+  int num_buffers;
+
+  render_queue_stats last_stats;
+} render_queue;
+
+// program and material are sort ids (GL names work), depth is normalized to [0, 1]
+uint64_t render_queue_make_key(unsigned layer, int translucent, unsigned program, unsigned material, float depth);
+
+int render_queue_init(render_queue *queue, int capacity);
+
+void render_queue_free(render_queue *queue);
+
+// the packet is copied; returns -1 if the queue could not grow
+int render_queue_push(render_queue *queue, uint64_t key, const draw_packet *packet);
+
+void render_queue_sort(render_queue *queue);
+
+// sorts, records every packet into command buffers and empties the queue.
+// The sorted packets are split across the threads of jobs, or all recorded
+// here if jobs is NULL. No GL calls, so it can run on any one thread.
+void render_queue_record(render_queue *queue, job_system *jobs);
+
+// replays what render_queue_record() recorded through gl_state and leaves
+// blending off and depth writes on; GL thread only
+void render_queue_execute(render_queue *queue);
+
+// record and execute in one go
+void render_queue_submit(render_queue *queue, job_system *jobs);
+
+#endif // RENDER_QUEUE_H_
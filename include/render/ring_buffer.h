@@ -0,0 +1,50 @@
+#ifndef RING_BUFFER_H_
+#define RING_BUFFER_H_
+
+#include "glad/glad.h"
+
+// Streaming buffer for per-frame vertex and uniform data. The buffer is split
+// into one region per frame in flight; allocations are mapped unsynchronized,
+// and a fence per region makes sure a region is only reused once the GPU has
+// finished the frame that last wrote it. Writes never orphan or stall unless
+// the GPU falls RING_BUFFER_FRAMES frames behind.
+
+#define RING_BUFFER_FRAMES 3
+
+typedef struct {
+  GLuint buffer;
+  GLenum target;
+  GLsizeiptr frame_size;
+  int frame;
+  GLsizeiptr head;
+  GLsync fences[RING_BUFFER_FRAMES];
+  int mapped;
+
+  GLsizeiptr high_water;  // most bytes used by any single frame
+  unsigned long waits;    // frames that had to wait on the GPU
+} ring_buffer;
+
+typedef struct {
+  void *ptr;
+  GLintptr offset;  // from the start of ring->buffer, for glVertexAttribPointer/glBindBufferRange
+  GLsizeiptr size;
+} ring_allocation;
+
+int ring_buffer_init(ring_buffer *ring, GLenum target, GLsizeiptr frame_size);
+
+void ring_buffer_free(ring_buffer *ring);
+
+// maps size bytes aligned to alignment (a power of two) from this frame's region;
+// ring_buffer_unmap() must be called before anything draws from it.
+// Returns -1 if the frame's region is full.
+int ring_buffer_alloc(ring_buffer *ring, GLsizeiptr size, GLsizeiptr alignment, ring_allocation *out);
+
+void ring_buffer_unmap(ring_buffer *ring);
+
+// alloc + copy + unmap; returns the offset or -1
+GLintptr ring_buffer_write(ring_buffer *ring, const void *data, GLsizeiptr size, GLsizeiptr alignment);
+
+// fences the frame's region once all its draws are submitted, and moves on to the next
+void ring_buffer_end_frame(ring_buffer *ring);
+
+#endif // RING_BUFFER_H_
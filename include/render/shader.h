@@ -0,0 +1,31 @@
+#ifndef SHADER_H_
+#define SHADER_H_
+
+#include "glad/glad.h"
+
+// The *_begin functions only hand work to the driver; the *_check functions
+// wait for it, print the info log and return 0 on failure. Keeping them apart
+// lets drivers with GL_KHR/ARB_parallel_shader_compile work in the background.
+
+// defines (may be NULL) is inserted right after the #version line, e.g.
+// "#define USE_FOG 1\n"
+GLuint shader_compile_begin(GLenum type, const char *src, const char *defines);
+
+int shader_compile_check(GLuint shader);
+
+// retrievable asks the driver to keep the binary around for glGetProgramBinary
+GLuint shader_link_begin(GLuint vert, GLuint frag, int retrievable);
+
+// also validates, and detaches the shaders
+int shader_link_check(GLuint program, GLuint vert, GLuint frag);
+
+// whether the driver is done with a shader or program, so checking won't block;
+// always 1 without parallel compile support
+int shader_is_complete(GLuint object, int is_program);
+
+// blocking versions, returning 0 on failure
+GLuint shader_compile(GLenum type, const char *src, const char *defines);
+
+GLuint shader_link(GLuint vert, GLuint frag, int retrievable);
+
+#endif // SHADER_H_
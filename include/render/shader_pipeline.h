@@ -0,0 +1,57 @@
+#ifndef SHADER_PIPELINE_H_
+#define SHADER_PIPELINE_H_
+
+#include "glad/glad.h"
+#include "render/program_cache.h"
+
+// Asynchronous program building. Everything is submitted up front and only
+// polled later, so drivers with GL_KHR/ARB_parallel_shader_compile compile on
+// their own threads while the frame loop runs with whatever is ready. Cache
+// hits are ready immediately. The pipeline owns the programs it builds.
+
+typedef enum {
+  PROGRAM_COMPILING,
+  PROGRAM_LINKING,
+  PROGRAM_READY,
+  PROGRAM_FAILED
+} program_status;
+
+typedef int program_handle;
+
+typedef struct {
+  program_status status;
+  GLuint program;
+  GLuint vert, frag;
+  uint64_t key;
+} program_request;
+
+typedef struct {
+  program_cache *cache;
+  program_request *requests;
+  int count;
+  int capacity;
+  int pending;
+  int parallel;  // the driver compiles in the background
+} shader_pipeline;
+
+int shader_pipeline_init(shader_pipeline *pipeline, program_cache *cache);
+
+// deletes every program it built
+void shader_pipeline_free(shader_pipeline *pipeline);
+
+// returns -1 if the request could not be stored
+program_handle shader_pipeline_submit(shader_pipeline *pipeline, const char *vs_src, const char *fs_src, const char *defines);
+
+// moves every request along as far as the driver allows without waiting, or
+// all the way with block; returns how many are still pending
+int shader_pipeline_poll(shader_pipeline *pipeline, int block);
+
+program_status shader_pipeline_status(const shader_pipeline *pipeline, program_handle handle);
+
+// 0 until the program is ready
+GLuint shader_pipeline_program(const shader_pipeline *pipeline, program_handle handle);
+
+// finishes just this request, returns 0 if it failed
+GLuint shader_pipeline_wait(shader_pipeline *pipeline, program_handle handle);
+
+#endif // SHADER_PIPELINE_H_
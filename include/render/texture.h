@@ -0,0 +1,71 @@
+#ifndef TEXTURE_H_
+#define TEXTURE_H_
+
+#include <pthread.h>
+#include "glad/glad.h"
+#include "utils/jobs.h"
+#include "utils/pool.h"
+
+// Background texture loading. texture_load() returns at once with a texture
+// that shows a placeholder; jobs decode the PNG and build the mip
+// chain straight into a mapped pixel buffer object, and texture_manager_update()
+// (GL thread, once per frame) issues the uploads from it. The GL name never
+// changes, so it can be used in draw packets right away.
+
+// limits how much pixel data is mapped at once and how much is uploaded per frame
+#define TEXTURE_MAX_MAPPED_UPLOADS 32
+#define TEXTURE_UPLOAD_BUDGET (32 * 1024 * 1024)
+
+typedef int texture_handle;
+
+typedef enum {
+  TEXTURE_LOADING,
+  TEXTURE_RESIDENT,
+  TEXTURE_FAILED
+} texture_status;
+
+typedef struct {
+  GLuint name;
+  texture_status status;
+  int width, height;
+} texture;
+
+typedef struct texture_job texture_job;
+
+typedef struct {
+  texture *textures;
+  int count;
+  int capacity;
+
+  job_system *jobs;
+  // loads being read or decoded on the job system
+  job_counter in_flight;
+
+  // loads waiting for the GL thread
+  pthread_mutex_t lock;
+  texture_job *gl_head, *gl_tail;
+
+  // waiting for a pixel buffer, kept on the GL thread while too many are mapped
+  texture_job *stalled;
+  int mapped_uploads;
+
+  // load jobs, allocated and freed on the GL thread
+  pool job_pool;
+} texture_manager;
+
+// jobs must outlive the manager
+int texture_manager_init(texture_manager *manager, job_system *jobs);
+
+void texture_manager_free(texture_manager *manager);
+
+// returns -1 only if the handle could not be allocated; a missing or broken file
+// shows up later as TEXTURE_FAILED
+texture_handle texture_load(texture_manager *manager, const char *path);
+
+void texture_manager_update(texture_manager *manager);
+
+GLuint texture_gl_name(const texture_manager *manager, texture_handle handle);
+
+texture_status texture_get_status(const texture_manager *manager, texture_handle handle);
+
+#endif // TEXTURE_H_
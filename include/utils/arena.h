@@ -0,0 +1,59 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stddef.h>
+
+// Linear allocators for memory that dies all at once. An allocation bumps an
+// offset and there is no per-allocation free; arena_reset() throws everything
+// away and arena_release() everything after a mark. When the current block is
+// full another one is chained on, and the next reset folds them back into one
+// block as large as all of them, so after a warm-up frame an arena that is
+// reset every frame never touches malloc again.
+
+typedef struct arena_block arena_block;
+
+typedef struct {
+  arena_block *block;  // the one being filled, older ones hang off it
+  size_t used;         // bytes taken in block
+  size_t allocated;    // bytes handed out since the last reset, padding included
+  size_t capacity;     // of every block together
+
+  size_t high_water;      // most allocated at once since init
+  size_t last_allocated;  // allocated when it was last reset
+  int grows;              // blocks chained on since init
+} arena;
+
+// where an arena was, for arena_release()
+typedef struct {
+  arena_block *block;
+  size_t used;
+  size_t allocated;
+} arena_mark;
+
+// Per-thread scratch arenas start this big. Keep the marks scoped: take one,
+// allocate, release it before returning.
+#define ARENA_SCRATCH_SIZE (256 * 1024)
+
+int arena_init(arena *a, size_t capacity);
+
+void arena_free(arena *a);
+
+// align is a power of two. NULL only if a new block could not be allocated.
+void *arena_alloc(arena *a, size_t size, size_t align);
+
+// forgets every allocation, keeping (and if need be merging) the memory
+void arena_reset(arena *a);
+
+arena_mark arena_get_mark(const arena *a);
+
+// forgets every allocation made since mark was taken
+void arena_release(arena *a, arena_mark mark);
+
+// the calling thread's scratch arena, created on first use and freed when the
+// thread exits. NULL if it could not be created.
+arena *arena_scratch(void);
+
+// frees the calling thread's scratch arena early, for threads main() returns on
+void arena_scratch_free(void);
+
+#endif // ARENA_H_
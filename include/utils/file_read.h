@@ -1,6 +1,32 @@
 #ifndef FILE_READ_H_
 #define FILE_READ_H_
 
-char *read_file(const char *path);
+#include <stddef.h>
 
-#endif // UTILS_H_
+enum file_error {
+  FILE_OK = 0,
+  FILE_ERROR_OPEN = -1,
+  FILE_ERROR_STAT = -2,
+  FILE_ERROR_MAP = -3,
+  FILE_ERROR_READ = -4,
+  FILE_ERROR_MEMORY = -5
+};
+
+// Read-only view of a whole file. Regular files are mmapped, so nothing is
+// copied until the pages are touched; pipes and other streams are read into a
+// heap buffer instead. data is always followed by a '\0', so text files can be
+// used as C strings directly.
+typedef struct {
+  const char *data;
+  size_t size;
+  int mapped;
+} file_view;
+
+// on failure the view is left empty and nothing is printed
+int file_map(const char *path, file_view *view);
+
+void file_release(file_view *view);
+
+const char *file_error_string(int error);
+
+#endif // FILE_READ_H_
@@ -0,0 +1,60 @@
+#ifndef FRAME_STATS_H_
+#define FRAME_STATS_H_
+
+#include "glad/glad.h"
+
+#define FRAME_STATS_MAX_PHASES 8
+// GL_TIME_ELAPSED results come back a few frames late, so queries are recycled from a ring
+#define FRAME_STATS_QUERY_RING 4
+
+// Per-frame CPU time (split into named phases) and GPU time, for --bench runs.
+typedef struct {
+  const char *phase_names[FRAME_STATS_MAX_PHASES];
+  int num_phases;
+
+  int num_frames;
+  int capacity;
+  double *cpu_ms;
+  double *gpu_ms;
+  double *phase_ms; // num_frames * FRAME_STATS_MAX_PHASES
+
+  double frame_start;
+  double last_mark;
+
+  GLuint queries[FRAME_STATS_QUERY_RING];
+  int query_frame[FRAME_STATS_QUERY_RING];
+} frame_stats;
+
+typedef struct {
+  double min, median, p95, p99, max, mean;
+} frame_stats_summary;
+
+double frame_stats_now_ms(void);
+
+int frame_stats_init(frame_stats *stats, int expected_frames);
+
+void frame_stats_free(frame_stats *stats);
+
+// returns the phase index to pass to frame_stats_mark, or -1 if there are too many
+int frame_stats_add_phase(frame_stats *stats, const char *name);
+
+// fails only when the sample arrays can't grow
+int frame_stats_begin_frame(frame_stats *stats);
+
+// charges the time since the last mark (or the frame start) to phase
+void frame_stats_mark(frame_stats *stats, int phase);
+
+int frame_stats_end_frame(frame_stats *stats);
+
+// waits for outstanding GPU timings, call before summarizing
+void frame_stats_finish(frame_stats *stats);
+
+// samples is strided, e.g. phase_ms + phase with stride FRAME_STATS_MAX_PHASES
+void frame_stats_summarize(const double *samples, int count, int stride, frame_stats_summary *out);
+
+void frame_stats_print(const frame_stats *stats);
+
+// format is picked from the extension: ".csv" writes CSV, anything else JSON
+int frame_stats_write(const frame_stats *stats, const char *path);
+
+#endif // FRAME_STATS_H_
@@ -0,0 +1,79 @@
+#ifndef JOBS_H_
+#define JOBS_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+// A work-stealing job system. There is one worker thread per core besides the
+// thread that called jobs_init(), and each of them has its own Chase-Lev deque.
+// A thread pushes and pops jobs at the bottom of its own deque, and idle threads
+// steal from the top of the others'. Jobs spawned by a job therefore mostly
+// stay on the core that spawned them. Any other thread (a loader thread, say)
+// hands its jobs over through a locked queue. Waiting on a counter runs other
+// jobs in the meantime instead of blocking, so the main thread helps out too.
+
+#define JOBS_MAX_WORKERS 63
+// per thread, a power of two; a full deque spills into the locked queue
+#define JOBS_DEQUE_SIZE 1024
+
+typedef void (*job_fn)(void *context);
+
+typedef void (*job_range_fn)(void *context, long begin, long end);
+
+// the number of unfinished jobs counting against it; start it at zero
+typedef atomic_int job_counter;
+
+typedef struct {
+  job_fn fn;
+  void *context;
+  // decremented once fn returns, may be NULL
+  job_counter *counter;
+  // fn only starts once this is zero, may be NULL
+  job_counter *dependency;
+} job;
+
+typedef struct job_deque job_deque;
+
+typedef struct {
+  pthread_t workers[JOBS_MAX_WORKERS];
+  int num_workers;
+  // num_workers + 1 of them, the last belongs to the thread that called jobs_init()
+  job_deque *deques;
+
+  // jobs from threads without a deque, those waiting on a dependency and spills
+  pthread_mutex_t lock;
+  job *injected;
+  int injected_head, num_injected, max_injected;
+  atomic_int has_injected;
+
+  // queued anywhere and not yet taken; idle workers sleep on wake while it is zero
+  atomic_int queued;
+  atomic_int sleeping;
+  pthread_cond_t wake;
+  atomic_int quit;
+} job_system;
+
+// num_workers 0 uses one per core besides the calling thread, and there is
+// always at least one
+int jobs_init(job_system *jobs, int num_workers);
+
+// every job must have finished
+void jobs_free(job_system *jobs);
+
+// queues fn(context), adding one to counter until it has run
+void jobs_run(job_system *jobs, job_fn fn, void *context, job_counter *counter);
+
+// as jobs_run(), but fn only starts once dependency reaches zero, so the jobs
+// it waits for must already have been queued
+void jobs_run_after(job_system *jobs, job_counter *dependency, job_fn fn, void *context, job_counter *counter);
+
+// runs queued jobs until counter reaches zero
+void jobs_wait(job_system *jobs, job_counter *counter);
+
+// Splits [0, count) into ranges that start on multiples of grain and runs fn
+// on them across every thread, the caller included. Ranges are halved
+// recursively, so an idle thread steals a large half rather than a sliver.
+// Returns once all of them are done.
+void jobs_parallel_for(job_system *jobs, long count, long grain, job_range_fn fn, void *context);
+
+#endif // JOBS_H_
@@ -0,0 +1,21 @@
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include "utils/jobs.h"
+
+#define PARALLEL_MAX_THREADS 16
+
+typedef void (*parallel_fn)(void *context, long begin, long end);
+
+// Splits [0, count) into one contiguous range per thread and runs fn on each,
+// the calling thread taking the first. Range boundaries are multiples of
+// grain, so SIMD kernels only see a partial vector at the very end.
+// num_threads 0 uses one per core. Returns once every range is done.
+// While a job system is set with parallel_use_jobs(), anything but
+// num_threads 1 goes to jobs_parallel_for() on it instead of new threads.
+void parallel_range(long count, long grain, int num_threads, parallel_fn fn, void *context);
+
+// NULL goes back to starting threads per call
+void parallel_use_jobs(job_system *jobs);
+
+#endif // PARALLEL_H_
@@ -0,0 +1,36 @@
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <stddef.h>
+
+// Fixed-size blocks carved out of big aligned chunks, with freed blocks kept
+// on an intrusive free list. Allocating and freeing are a pointer swap each,
+// chunks are only allocated when the free list runs dry and are never handed
+// back before pool_free(). Not thread-safe; guard it with the owner's lock.
+
+typedef struct {
+  size_t block_size;  // rounded up to align
+  size_t align;
+  int blocks_per_chunk;
+
+  char **chunks;
+  int num_chunks;
+  int max_chunks;
+  void *free_list;
+
+  int live;
+  int high_water;  // most live at once since init
+} pool;
+
+// align is a power of two and at least sizeof(void *)
+int pool_init(pool *p, size_t block_size, size_t align, int blocks_per_chunk);
+
+// every block goes with it, live or not
+void pool_free(pool *p);
+
+// NULL if a new chunk could not be allocated. The block is not cleared.
+void *pool_alloc(pool *p);
+
+void pool_release(pool *p, void *block);
+
+#endif // POOL_H_
@@ -0,0 +1,1072 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cglm/cglm.h"
+#include "cglm/version.h"
+#include "math/batch.h"
+#include "math/noise.h"
+#include "math/pose.h"
+#include "math/simd.h"
+#include "render/bvh.h"
+#include "utils/file_read.h"
+
+// Times the cglm functions the engine leans on. The same source is built once
+// per instruction set (see `make bench` in src/Makefile.am), BENCH_VARIANT
+// says which one this is.
+
+#ifndef BENCH_VARIANT
+#define BENCH_VARIANT "native"
+#endif
+
+// items per batch, about what a frame pushes through each function
+#define BENCH_BATCH 4096
+// each measurement runs for at least this long, the best of BENCH_RUNS is kept
+#define BENCH_MIN_MS 20.0
+#define BENCH_RUNS 5
+// slower than the baseline by more than this counts as a regression
+#define BENCH_TOLERANCE 0.15
+
+typedef struct {
+  const char *name;
+  void (*run)(int count);
+  double ns_per_op;
+} benchmark;
+
+CGLM_ALIGN_MAT mat4 matrices_a[BENCH_BATCH];
+CGLM_ALIGN_MAT mat4 matrices_b[BENCH_BATCH];
+CGLM_ALIGN_MAT mat4 matrices_out[BENCH_BATCH];
+CGLM_ALIGN(16) vec4 vectors[BENCH_BATCH];
+CGLM_ALIGN(16) vec4 vectors_out[BENCH_BATCH];
+CGLM_ALIGN(16) versor quats_a[BENCH_BATCH];
+CGLM_ALIGN(16) versor quats_b[BENCH_BATCH];
+CGLM_ALIGN(16) versor quats_out[BENCH_BATCH];
+vec3 boxes[BENCH_BATCH][2];
+vec3 boxes_out[BENCH_BATCH][2];
+vec4 planes[BENCH_BATCH][6];
+vec3 points[BENCH_BATCH];
+float triangles[BENCH_BATCH / 8][3][3][8];
+float results[BENCH_BATCH];
+
+// everything computed ends up in here so none of it can be optimized away
+volatile float sink;
+
+double now_ms() {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec * 1e3 + time.tv_nsec / 1e6;
+}
+
+float random_float(float min, float max) {
+  return min + (max - min) * (rand() / (float)RAND_MAX);
+}
+
+void random_quat(versor q) {
+  glm_quatv(q, random_float(-GLM_PIf, GLM_PIf),
+            (vec3){random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f), random_float(0.1f, 1.0f)});
+}
+
+void fill_inputs() {
+  srand(1);
+  for (int i = 0; i < BENCH_BATCH; i++) {
+    // invertible TRS matrices like real transforms, not noise
+    versor rotation;
+    random_quat(rotation);
+    glm_quat_mat4(rotation, matrices_a[i]);
+    glm_scale_uni(matrices_a[i], random_float(0.5f, 2.0f));
+    glm_translate(matrices_a[i], (vec3){random_float(-50, 50), random_float(-50, 50), random_float(-50, 50)});
+
+    mat4 projection, view;
+    glm_perspective(random_float(0.5f, 1.5f), random_float(1.0f, 2.0f), 0.1f, 500.0f, projection);
+    glm_lookat((vec3){random_float(-5, 5), 2.0f, random_float(-5, 5)}, GLM_VEC3_ZERO, GLM_YUP, view);
+    glm_mat4_mul(projection, view, matrices_b[i]);
+    glm_frustum_planes(matrices_b[i], planes[i]);
+
+    glm_vec4_copy((vec4){random_float(-10, 10), random_float(-10, 10), random_float(-10, 10), 1.0f}, vectors[i]);
+    random_quat(quats_a[i]);
+    random_quat(quats_b[i]);
+
+    vec3 center = {random_float(-100, 100), random_float(-100, 100), random_float(-100, 100)};
+    glm_vec3_subs(center, random_float(0.1f, 5.0f), boxes[i][0]);
+    glm_vec3_adds(center, random_float(0.1f, 5.0f), boxes[i][1]);
+
+    glm_vec3_copy((vec3){random_float(-8, 8), random_float(-8, 8), random_float(-8, 8)}, points[i]);
+  }
+
+  for (int t = 0; t < BENCH_BATCH / 8; t++) {
+    for (int v = 0; v < 3; v++) {
+      for (int axis = 0; axis < 3; axis++) {
+        for (int lane = 0; lane < 8; lane++) {
+          triangles[t][v][axis][lane] = random_float(-1.0f, 1.0f) + (axis == 2 ? 3.0f : 0.0f);
+        }
+      }
+    }
+  }
+}
+
+void run_mat4_mul(int count) {
+  for (int i = 0; i < count; i++) {
+    glm_mat4_mul(matrices_a[i], matrices_b[i], matrices_out[i]);
+  }
+  sink = matrices_out[count - 1][3][3];
+}
+
+// the pair functions are timed per item too, so they compare directly with the single ones
+void run_mat4_mul2(int count) {
+  for (int i = 0; i + 1 < count; i += 2) {
+    glm_mat4_mul2(&matrices_a[i], &matrices_b[i], &matrices_out[i]);
+  }
+  sink = matrices_out[count - 1][3][3];
+}
+
+void run_mat4_inv(int count) {
+  for (int i = 0; i < count; i++) {
+    glm_mat4_inv(matrices_a[i], matrices_out[i]);
+  }
+  sink = matrices_out[count - 1][3][3];
+}
+
+void run_mat4_inv2(int count) {
+  for (int i = 0; i + 1 < count; i += 2) {
+    glm_mat4_inv2(&matrices_a[i], &matrices_out[i]);
+  }
+  sink = matrices_out[count - 1][3][3];
+}
+
+void run_mat4_inv_fast(int count) {
+  for (int i = 0; i < count; i++) {
+    glm_mat4_inv_fast(matrices_a[i], matrices_out[i]);
+  }
+  sink = matrices_out[count - 1][3][3];
+}
+
+void run_mat4_mulv(int count) {
+  for (int i = 0; i < count; i++) {
+    glm_mat4_mulv(matrices_a[i], vectors[i], vectors_out[i]);
+  }
+  sink = vectors_out[count - 1][0];
+}
+
+void run_quat_mul(int count) {
+  for (int i = 0; i < count; i++) {
+    glm_quat_mul(quats_a[i], quats_b[i], quats_out[i]);
+  }
+  sink = quats_out[count - 1][3];
+}
+
+void run_quat_mul2(int count) {
+  for (int i = 0; i + 1 < count; i += 2) {
+    glm_quat_mul2(&quats_a[i], &quats_b[i], &quats_out[i]);
+  }
+  sink = quats_out[count - 1][3];
+}
+
+void run_quat_slerp(int count) {
+  for (int i = 0; i < count; i++) {
+    glm_quat_slerp(quats_a[i], quats_b[i], (i & 255) / 255.0f, quats_out[i]);
+  }
+  sink = quats_out[count - 1][3];
+}
+
+void run_frustum_planes(int count) {
+  vec4 out[6];
+  float sum = 0.0f;
+  for (int i = 0; i < count; i++) {
+    glm_frustum_planes(matrices_b[i], out);
+    sum += out[5][3];
+  }
+  sink = sum;
+}
+
+void run_aabb_frustum(int count) {
+  int visible = 0;
+  for (int i = 0; i < count; i++) {
+    visible += glm_aabb_frustum(boxes[i], planes[0]);
+  }
+  sink = visible;
+}
+
+void run_aabb_transform(int count) {
+  for (int i = 0; i < count; i++) {
+    glm_aabb_transform(boxes[i], matrices_a[i], boxes_out[i]);
+  }
+  sink = boxes_out[count - 1][1][2];
+}
+
+void run_perlin_vec3(int count) {
+  for (int i = 0; i < count; i++) {
+    results[i] = glm_perlin_vec3(points[i]);
+  }
+  sink = results[count - 1];
+}
+
+void run_ray_triangle(int count) {
+  vec3 origin = {0.0f, 0.0f, 0.0f};
+  int hits = 0;
+  for (int i = 0; i < count; i++) {
+    float (*t)[3][8] = triangles[(i / 8) % (BENCH_BATCH / 8)];
+    int lane = i % 8;
+    vec3 dir = {points[i][0] * 0.05f, points[i][1] * 0.05f, 1.0f};
+    vec3 v0 = {t[0][0][lane], t[0][1][lane], t[0][2][lane]};
+    vec3 v1 = {t[1][0][lane], t[1][1][lane], t[1][2][lane]};
+    vec3 v2 = {t[2][0][lane], t[2][1][lane], t[2][2][lane]};
+    hits += glm_ray_triangle(origin, dir, v0, v1, v2, &results[i]);
+  }
+  sink = hits;
+}
+
+// per triangle, so it compares directly with ray_triangle
+void run_ray_triangle8(int count) {
+  vec3 origin = {0.0f, 0.0f, 0.0f};
+  int hits = 0;
+  for (int i = 0; i < count; i += 8) {
+    float (*t)[3][8] = triangles[(i / 8) % (BENCH_BATCH / 8)];
+    vec3 dir = {points[i][0] * 0.05f, points[i][1] * 0.05f, 1.0f};
+    hits += __builtin_popcount(glm_ray_triangle8(origin, dir, t[0], t[1], t[2], &results[i]));
+  }
+  sink = hits;
+}
+
+benchmark benchmarks[] = {
+  {"mat4_mul", run_mat4_mul},
+  {"mat4_mul2", run_mat4_mul2},
+  {"mat4_inv", run_mat4_inv},
+  {"mat4_inv2", run_mat4_inv2},
+  {"mat4_inv_fast", run_mat4_inv_fast},
+  {"mat4_mulv", run_mat4_mulv},
+  {"quat_mul", run_quat_mul},
+  {"quat_mul2", run_quat_mul2},
+  {"quat_slerp", run_quat_slerp},
+  {"frustum_planes", run_frustum_planes},
+  {"aabb_frustum", run_aabb_frustum},
+  {"aabb_transform", run_aabb_transform},
+  {"perlin_vec3", run_perlin_vec3},
+  {"ray_triangle", run_ray_triangle},
+  {"ray_triangle8", run_ray_triangle8},
+};
+
+#define NUM_BENCHMARKS (int)(sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+// Scalar references in double precision for the functions with hand-written
+// SIMD paths. Errors are relative to the largest element of the reference
+// result, the limits leave room for FMA and for the reciprocal estimate in
+// glm_mat4_inv_fast.
+#define ACCURACY_EXACT 1e-5
+#define ACCURACY_INVERSE 1e-4
+#define ACCURACY_FAST_INVERSE 2e-3
+// absolute, noise is about [-1, 1]; FMA on either side moves it by a few ulps
+#define ACCURACY_NOISE 4e-6
+// sides of the noise grids checked, small enough to stay quick
+#define CHECK_GRID 24
+// odd, so the batched kernels' tails run too
+#define CHECK_BATCH (BENCH_BATCH - 3)
+// the BVH queries must give exactly what brute force does, so their error is
+// the number of queries that don't
+#define ACCURACY_MATCH 0.0
+#define CHECK_BVH_BOXES 100000
+#define CHECK_BVH_QUERIES 64
+#define CHECK_CULL_FRUSTUMS 16
+
+void reference_mat4_mul(mat4 a, mat4 b, double dest[4][4]) {
+  for (int c = 0; c < 4; c++) {
+    for (int r = 0; r < 4; r++) {
+      dest[c][r] = 0.0;
+      for (int k = 0; k < 4; k++) {
+        dest[c][r] += (double)a[k][r] * b[c][k];
+      }
+    }
+  }
+}
+
+// Gauss-Jordan with partial pivoting
+void reference_mat4_inv(mat4 m, double dest[4][4]) {
+  double a[4][8];
+  for (int r = 0; r < 4; r++) {
+    for (int c = 0; c < 4; c++) {
+      a[r][c] = m[c][r];
+      a[r][c + 4] = r == c;
+    }
+  }
+  for (int c = 0; c < 4; c++) {
+    int pivot = c;
+    for (int r = c + 1; r < 4; r++) {
+      if (fabs(a[r][c]) > fabs(a[pivot][c])) {
+        pivot = r;
+      }
+    }
+    for (int k = 0; k < 8; k++) {
+      double t = a[c][k];
+      a[c][k] = a[pivot][k];
+      a[pivot][k] = t;
+    }
+    double scale = 1.0 / a[c][c];
+    for (int k = 0; k < 8; k++) {
+      a[c][k] *= scale;
+    }
+    for (int r = 0; r < 4; r++) {
+      double f = a[r][c];
+      for (int k = 0; r != c && k < 8; k++) {
+        a[r][k] -= f * a[c][k];
+      }
+    }
+  }
+  for (int r = 0; r < 4; r++) {
+    for (int c = 0; c < 4; c++) {
+      dest[c][r] = a[r][c + 4];
+    }
+  }
+}
+
+void reference_quat_mul(versor p, versor q, double dest[4]) {
+  dest[0] = (double)p[3] * q[0] + (double)p[0] * q[3] + (double)p[1] * q[2] - (double)p[2] * q[1];
+  dest[1] = (double)p[3] * q[1] - (double)p[0] * q[2] + (double)p[1] * q[3] + (double)p[2] * q[0];
+  dest[2] = (double)p[3] * q[2] + (double)p[0] * q[1] - (double)p[1] * q[0] + (double)p[2] * q[3];
+  dest[3] = (double)p[3] * q[3] - (double)p[0] * q[0] - (double)p[1] * q[1] - (double)p[2] * q[2];
+}
+
+double relative_error(const float *result, const double *reference, int n) {
+  double largest = 0.0, error = 0.0;
+  for (int i = 0; i < n; i++) {
+    largest = fmax(largest, fabs(reference[i]));
+    error = fmax(error, fabs(result[i] - reference[i]));
+  }
+  return largest > 0.0 ? error / largest : error;
+}
+
+// a hit that differs counts as an infinite error, distances as relative ones
+double ray_error(int hits, int reference_hits, const float *d, const float *reference_d) {
+  if (hits != reference_hits) {
+    return INFINITY;
+  }
+  double reference[8];
+  for (int i = 0; i < 8; i++) {
+    reference[i] = reference_d[i];
+  }
+  return relative_error(d, reference, 8);
+}
+
+enum {
+  CHECK_MAT4_MUL, CHECK_MAT4_MUL2, CHECK_MAT4_INV, CHECK_MAT4_INV2, CHECK_MAT4_INV_FAST, CHECK_MAT4_INV_FAST2,
+  CHECK_MAT4_MULV, CHECK_QUAT_MUL, CHECK_QUAT_MUL2, CHECK_RAY_TRIANGLE8, CHECK_RAY8_TRIANGLE, CHECK_NOISE_POINTS2,
+  CHECK_NOISE_POINTS3, CHECK_NOISE_GRID2, CHECK_NOISE_GRID3, CHECK_POSE_NLERP, CHECK_POSE_SLERP, CHECK_POSE_MATRICES,
+  CHECK_BVH_FRUSTUM, CHECK_BVH_AABB, CHECK_BVH_SPHERE, CHECK_BVH_RAYCAST, CHECK_AABB_TRANSFORM,
+  CHECK_SPHERE_CENTER, CHECK_SPHERE_RADIUS, CHECK_BATCH_MULV, CHECK_TRANSFORM_VEC4, CHECK_TRANSFORM_POINTS,
+  CHECK_TRANSFORM_DIRS, CHECK_POINTS_SOA, CHECK_DIRS_SOA, CHECK_POINTS_IN_PLACE, CHECK_CULL_RANGE, NUM_CHECKS
+};
+
+double relative_error_float(const float *result, const float *reference, int n) {
+  double wide[16];
+  for (int i = 0; i < n; i++) {
+    wide[i] = reference[i];
+  }
+  return relative_error(result, wide, n);
+}
+
+double absolute_error(const float *result, const float *reference, int n) {
+  double error = 0.0;
+  for (int i = 0; i < n; i++) {
+    error = fmax(error, fabs((double)result[i] - reference[i]));
+  }
+  return error;
+}
+
+// noise_points and noise_grid with the current kernels against glm_perlin_vec2/vec3
+void check_noise(double *worst) {
+  static vec2 points2[BENCH_BATCH];
+  static float reference[BENCH_BATCH], out[BENCH_BATCH];
+  static float grid[CHECK_GRID * CHECK_GRID * CHECK_GRID], grid_reference[CHECK_GRID * CHECK_GRID * CHECK_GRID];
+  noise_params perlin = NOISE_PARAMS(NOISE_PERLIN);
+
+  for (int i = 0; i < BENCH_BATCH; i++) {
+    glm_vec2_copy(points[i], points2[i]);
+    reference[i] = glm_perlin_vec2(points2[i]);
+  }
+  noise_points2(&perlin, (const vec2 *)points2, out, BENCH_BATCH);
+  worst[CHECK_NOISE_POINTS2] = fmax(worst[CHECK_NOISE_POINTS2], absolute_error(out, reference, BENCH_BATCH));
+
+  for (int i = 0; i < BENCH_BATCH; i++) {
+    reference[i] = glm_perlin_vec3(points[i]);
+  }
+  noise_points3(&perlin, (const vec3 *)points, out, BENCH_BATCH);
+  worst[CHECK_NOISE_POINTS3] = fmax(worst[CHECK_NOISE_POINTS3], absolute_error(out, reference, BENCH_BATCH));
+
+  vec3 origin = {-3.7f, 1.3f, 0.4f};
+  float spacing = 0.37f;
+  int n = CHECK_GRID;
+  for (int y = 0; y < n; y++) {
+    for (int x = 0; x < n; x++) {
+      grid_reference[y * n + x] = glm_perlin_vec2((vec2){origin[0] + x * spacing, origin[1] + y * spacing});
+    }
+  }
+  noise_grid2(&perlin, origin, spacing, n, n, grid, 1);
+  worst[CHECK_NOISE_GRID2] = fmax(worst[CHECK_NOISE_GRID2], absolute_error(grid, grid_reference, n * n));
+
+  for (int z = 0; z < n; z++) {
+    for (int y = 0; y < n; y++) {
+      for (int x = 0; x < n; x++) {
+        vec3 p = {origin[0] + x * spacing, origin[1] + y * spacing, origin[2] + z * spacing};
+        grid_reference[(z * n + y) * n + x] = glm_perlin_vec3(p);
+      }
+    }
+  }
+  noise_grid3(&perlin, origin, spacing, n, n, n, grid, 1);
+  worst[CHECK_NOISE_GRID3] = fmax(worst[CHECK_NOISE_GRID3], absolute_error(grid, grid_reference, n * n * n));
+}
+
+// pose_blend with the current kernels against glm_quat_nlerp/slerp and vec3
+// lerps, pose_matrices against the same TRS built with cglm
+void check_pose(double *worst) {
+  static CGLM_ALIGN_MAT mat4 matrices[BENCH_BATCH];
+  const float ts[] = {0.0f, 0.3f, 0.5f, 0.85f, 1.0f};
+  pose a, b, out;
+  if (pose_init(&a, BENCH_BATCH) != 0 || pose_init(&b, BENCH_BATCH) != 0 || pose_init(&out, BENCH_BATCH) != 0) {
+    worst[CHECK_POSE_NLERP] = worst[CHECK_POSE_SLERP] = worst[CHECK_POSE_MATRICES] = INFINITY;
+    return;
+  }
+
+  for (int i = 0; i < BENCH_BATCH; i++) {
+    vec3 scale_a = {0.5f + fabsf(vectors[i][0]) * 0.1f, 0.5f + fabsf(vectors[i][1]) * 0.1f, 1.5f};
+    vec3 scale_b = {0.8f, 0.5f + fabsf(points[i][1]) * 0.1f, 0.5f + fabsf(points[i][2]) * 0.1f};
+    pose_set(&a, i, quats_a[i], points[i], scale_a);
+    pose_set(&b, i, quats_b[i], vectors[i], scale_b);
+  }
+
+  for (int mode = POSE_NLERP; mode <= POSE_SLERP; mode++) {
+    int check = mode == POSE_NLERP ? CHECK_POSE_NLERP : CHECK_POSE_SLERP;
+    for (int k = 0; k < (int)(sizeof(ts) / sizeof(ts[0])); k++) {
+      pose_blend(&a, &b, ts[k], mode, &out, 1);
+      for (int i = 0; i < BENCH_BATCH; i++) {
+        versor qa, qb, q, expected_q;
+        vec3 ta, tb, t, expected_t, sa, sb, s, expected_s;
+        pose_get(&a, i, qa, ta, sa);
+        pose_get(&b, i, qb, tb, sb);
+        pose_get(&out, i, q, t, s);
+        if (mode == POSE_NLERP) {
+          glm_quat_nlerp(qa, qb, ts[k], expected_q);
+        } else {
+          glm_quat_slerp(qa, qb, ts[k], expected_q);
+        }
+        glm_vec3_lerp(ta, tb, ts[k], expected_t);
+        glm_vec3_lerp(sa, sb, ts[k], expected_s);
+        worst[check] = fmax(worst[check], relative_error_float(q, expected_q, 4));
+        worst[check] = fmax(worst[check], relative_error_float(t, expected_t, 3));
+        worst[check] = fmax(worst[check], relative_error_float(s, expected_s, 3));
+      }
+    }
+  }
+
+  pose_matrices(&a, matrices, 1);
+  for (int i = 0; i < BENCH_BATCH; i++) {
+    versor q;
+    vec3 t, s;
+    CGLM_ALIGN_MAT mat4 expected, rotation;
+    pose_get(&a, i, q, t, s);
+    glm_translate_make(expected, t);
+    glm_quat_mat4(q, rotation);
+    glm_mat4_mul(expected, rotation, expected);
+    glm_scale(expected, s);
+    worst[CHECK_POSE_MATRICES] = fmax(worst[CHECK_POSE_MATRICES],
+                                      relative_error_float(matrices[i][0], expected[0], 16));
+  }
+
+  pose_free(&a);
+  pose_free(&b);
+  pose_free(&out);
+}
+
+void random_box(vec3 box[2], float extent, float max_half_size) {
+  vec3 center = {random_float(-extent, extent), random_float(-extent, extent), random_float(-extent, extent)};
+  for (int axis = 0; axis < 3; axis++) {
+    float half_size = random_float(0.1f, max_half_size);
+    box[0][axis] = center[axis] - half_size;
+    box[1][axis] = center[axis] + half_size;
+  }
+}
+
+int compare_ints(const void *a, const void *b) {
+  return *(const int *)a - *(const int *)b;
+}
+
+// 1 if the query found exactly the expected items, in any order
+int same_items(int *found, int count, int *expected, int expected_count) {
+  if (count != expected_count) {
+    return 0;
+  }
+  qsort(found, count, sizeof(int), compare_ints);
+  qsort(expected, count, sizeof(int), compare_ints);
+  return memcmp(found, expected, count * sizeof(int)) == 0;
+}
+
+// entry distance of a ray into a box, or -1 for a miss. A zero direction
+// component never crosses its slab, the ray is inside it or misses.
+float reference_ray_box(vec3 origin, vec3 dir, vec3 box[2], float max_distance) {
+  float enter = 0.0f, leave = max_distance;
+  for (int axis = 0; axis < 3; axis++) {
+    if (dir[axis] == 0.0f) {
+      if (origin[axis] < box[0][axis] || origin[axis] > box[1][axis]) {
+        return -1.0f;
+      }
+      continue;
+    }
+    float inv_dir = 1.0f / dir[axis];
+    float t1 = (box[0][axis] - origin[axis]) * inv_dir, t2 = (box[1][axis] - origin[axis]) * inv_dir;
+    enter = fmaxf(enter, fminf(t1, t2));
+    leave = fminf(leave, fmaxf(t1, t2));
+  }
+  return enter <= leave ? enter : -1.0f;
+}
+
+// every BVH query against a loop over all the boxes, after a build, single
+// updates, a batch refit, removals and inserts have all had their go at it
+void check_bvh(double *worst) {
+  enum { MAX_ITEMS = CHECK_BVH_BOXES + CHECK_BVH_BOXES / 20 };
+  static vec3 tree_boxes[MAX_ITEMS][2];
+  static char alive[MAX_ITEMS];
+  static int found[MAX_ITEMS], expected[MAX_ITEMS];
+  int num_items = CHECK_BVH_BOXES;
+  bvh tree;
+
+  srand(2);
+  for (int i = 0; i < num_items; i++) {
+    random_box(tree_boxes[i], 100.0f, 5.0f);
+    alive[i] = 1;
+  }
+  if (bvh_init(&tree) != 0 || bvh_build(&tree, tree_boxes, num_items) != 0) {
+    worst[CHECK_BVH_FRUSTUM] = worst[CHECK_BVH_AABB] = worst[CHECK_BVH_SPHERE] = worst[CHECK_BVH_RAYCAST] = INFINITY;
+    bvh_free(&tree);
+    return;
+  }
+
+  for (int k = 0; k < CHECK_BVH_BOXES / 100; k++) {
+    int i = rand() % num_items;
+    random_box(tree_boxes[i], 100.0f, 5.0f);
+    bvh_update(&tree, i, tree_boxes[i]);
+  }
+  for (int k = 0; k < CHECK_BVH_BOXES / 10; k++) {
+    int i = rand() % num_items;
+    random_box(tree_boxes[i], 100.0f, 5.0f);
+    bvh_set_box(&tree, i, tree_boxes[i]);
+  }
+  bvh_refit(&tree);
+  for (int k = 0; k < CHECK_BVH_BOXES / 20; k++) {
+    int i = rand() % num_items;
+    if (alive[i]) {
+      bvh_remove(&tree, i);
+      alive[i] = 0;
+    }
+  }
+  for (int k = 0; k < CHECK_BVH_BOXES / 20; k++) {
+    vec3 box[2];
+    random_box(box, 100.0f, 5.0f);
+    int i = bvh_insert(&tree, box);
+    if (i < 0 || i >= MAX_ITEMS) {
+      worst[CHECK_BVH_AABB] = INFINITY;
+      break;
+    }
+    glm_vec3_copy(box[0], tree_boxes[i][0]);
+    glm_vec3_copy(box[1], tree_boxes[i][1]);
+    alive[i] = 1;
+    num_items = i + 1 > num_items ? i + 1 : num_items;
+  }
+
+  for (int q = 0; q < CHECK_BVH_QUERIES; q++) {
+    int count = bvh_query_frustum(&tree, planes[q], found, MAX_ITEMS), expected_count = 0;
+    for (int i = 0; i < num_items; i++) {
+      if (alive[i] && glm_aabb_frustum(tree_boxes[i], planes[q])) {
+        expected[expected_count++] = i;
+      }
+    }
+    worst[CHECK_BVH_FRUSTUM] += !same_items(found, count, expected, expected_count);
+
+    vec3 box[2];
+    random_box(box, 100.0f, 20.0f);
+    count = bvh_query_aabb(&tree, box, found, MAX_ITEMS);
+    expected_count = 0;
+    for (int i = 0; i < num_items; i++) {
+      if (alive[i] && glm_aabb_aabb(tree_boxes[i], box)) {
+        expected[expected_count++] = i;
+      }
+    }
+    worst[CHECK_BVH_AABB] += !same_items(found, count, expected, expected_count);
+
+    // cglm's glm_aabb_sphere gets boxes below the center wrong, see bvh.c
+    vec4 sphere = {random_float(-100, 100), random_float(-100, 100), random_float(-100, 100), random_float(1, 30)};
+    count = bvh_query_sphere(&tree, sphere, found, MAX_ITEMS);
+    expected_count = 0;
+    for (int i = 0; i < num_items; i++) {
+      float dx = glm_clamp(sphere[0], tree_boxes[i][0][0], tree_boxes[i][1][0]) - sphere[0];
+      float dy = glm_clamp(sphere[1], tree_boxes[i][0][1], tree_boxes[i][1][1]) - sphere[1];
+      float dz = glm_clamp(sphere[2], tree_boxes[i][0][2], tree_boxes[i][1][2]) - sphere[2];
+      if (alive[i] && dx * dx + dy * dy + dz * dz <= sphere[3] * sphere[3]) {
+        expected[expected_count++] = i;
+      }
+    }
+    worst[CHECK_BVH_SPHERE] += !same_items(found, count, expected, expected_count);
+
+    // every other ray runs along an axis from inside a box, starting on two of
+    // its faces, which is where a zero direction component meets a slab plane
+    vec3 origin, dir;
+    if (q % 2 == 0) {
+      glm_vec3_copy((vec3){random_float(-120, 120), random_float(-120, 120), random_float(-120, 120)}, origin);
+      glm_vec3_copy((vec3){random_float(-1, 1), random_float(-1, 1), random_float(-1, 1)}, dir);
+    } else {
+      int i;
+      do {
+        i = rand() % num_items;
+      } while (!alive[i]);
+      int axis = q / 2 % 3;
+      glm_vec3_zero(dir);
+      dir[axis] = q % 4 == 1 ? 1.0f : -1.0f;
+      origin[axis] = (tree_boxes[i][0][axis] + tree_boxes[i][1][axis]) * 0.5f;
+      origin[(axis + 1) % 3] = tree_boxes[i][0][(axis + 1) % 3];
+      origin[(axis + 2) % 3] = tree_boxes[i][1][(axis + 2) % 3];
+    }
+    float distance = -1.0f, expected_distance = -1.0f;
+    int hit = bvh_raycast(&tree, origin, dir, 1000.0f, NULL, NULL, &distance);
+    for (int i = 0; i < num_items; i++) {
+      float t = alive[i] ? reference_ray_box(origin, dir, tree_boxes[i], 1000.0f) : -1.0f;
+      if (t >= 0.0f && (expected_distance < 0.0f || t < expected_distance)) {
+        expected_distance = t;
+      }
+    }
+    int ray_differs = (hit >= 0) != (expected_distance >= 0.0f) || (hit >= 0 && distance != expected_distance);
+    worst[CHECK_BVH_RAYCAST] += ray_differs;
+  }
+
+  bvh_free(&tree);
+}
+
+// cull_range with the current kernel against glm_aabb_frustum on every box,
+// over the whole batch and over a range that starts further in. The benchmark
+// frustums leave out most of the boxes, so the compaction really runs.
+void check_cull(double *worst) {
+  static uint32_t visible[BENCH_BATCH], expected[BENCH_BATCH];
+  cull_bounds bounds = {.count = CHECK_BATCH, .capacity = BENCH_BATCH};
+  float **axes[6] = {&bounds.min_x, &bounds.min_y, &bounds.min_z, &bounds.max_x, &bounds.max_y, &bounds.max_z};
+  int ok = 1;
+  for (int a = 0; a < 6; a++) {
+    *axes[a] = aligned_alloc(64, BENCH_BATCH * sizeof(float));
+    ok &= *axes[a] != NULL;
+  }
+  for (int i = 0; ok && i < CHECK_BATCH; i++) {
+    bounds.min_x[i] = boxes[i][0][0], bounds.min_y[i] = boxes[i][0][1], bounds.min_z[i] = boxes[i][0][2];
+    bounds.max_x[i] = boxes[i][1][0], bounds.max_y[i] = boxes[i][1][1], bounds.max_z[i] = boxes[i][1][2];
+  }
+
+  const int ranges[2][2] = {{0, CHECK_BATCH}, {3 * CULL_BATCH, CHECK_BATCH - 5}};
+  if (!ok) {
+    worst[CHECK_CULL_RANGE] = INFINITY;
+  }
+  for (int f = 0; ok && f < CHECK_CULL_FRUSTUMS; f++) {
+    for (int r = 0; r < 2; r++) {
+      int begin = ranges[r][0], end = ranges[r][1], expected_count = 0;
+      for (int i = begin; i < end; i++) {
+        if (glm_aabb_frustum(boxes[i], planes[f])) {
+          expected[expected_count++] = i;
+        }
+      }
+      int count = simd.cull_range(&bounds, planes[f], begin, end, visible);
+      worst[CHECK_CULL_RANGE] += count != expected_count || memcmp(visible, expected, count * sizeof(uint32_t)) != 0;
+    }
+  }
+
+  for (int a = 0; a < 6; a++) {
+    free(*axes[a]);
+  }
+}
+
+// the batched vector transforms with the current kernels against
+// glm_mat4_mulv and glm_mat4_mulv3, one of them in place
+void check_transforms(double *worst) {
+  static vec4 out4[BENCH_BATCH];
+  static vec3 out3[BENCH_BATCH];
+  static float soa[3][BENCH_BATCH], out_soa[3][BENCH_BATCH];
+  const float *const soa_in[3] = {soa[0], soa[1], soa[2]};
+  float *const soa_out[3] = {out_soa[0], out_soa[1], out_soa[2]};
+  vec4 *m = matrices_a[1];
+
+  batch_mat4_mulv(matrices_a, vectors, out4, CHECK_BATCH);
+  for (int i = 0; i < CHECK_BATCH; i++) {
+    vec4 expected;
+    glm_mat4_mulv(matrices_a[i], vectors[i], expected);
+    worst[CHECK_BATCH_MULV] = fmax(worst[CHECK_BATCH_MULV], relative_error_float(out4[i], expected, 4));
+  }
+
+  batch_transform_vec4(m, vectors, out4, CHECK_BATCH);
+  for (int i = 0; i < CHECK_BATCH; i++) {
+    vec4 expected;
+    glm_mat4_mulv(m, vectors[i], expected);
+    worst[CHECK_TRANSFORM_VEC4] = fmax(worst[CHECK_TRANSFORM_VEC4], relative_error_float(out4[i], expected, 4));
+  }
+
+  for (int w = 0; w <= 1; w++) {
+    int check = w ? CHECK_TRANSFORM_POINTS : CHECK_TRANSFORM_DIRS;
+    int soa_check = w ? CHECK_POINTS_SOA : CHECK_DIRS_SOA;
+    for (int i = 0; i < CHECK_BATCH; i++) {
+      for (int axis = 0; axis < 3; axis++) {
+        soa[axis][i] = points[i][axis];
+      }
+    }
+    if (w) {
+      batch_transform_points(m, (const vec3 *)points, out3, CHECK_BATCH);
+      batch_transform_points_soa(m, soa_in, soa_out, CHECK_BATCH);
+    } else {
+      batch_transform_dirs(m, (const vec3 *)points, out3, CHECK_BATCH);
+      batch_transform_dirs_soa(m, soa_in, soa_out, CHECK_BATCH);
+    }
+    for (int i = 0; i < CHECK_BATCH; i++) {
+      vec3 expected, from_soa = {out_soa[0][i], out_soa[1][i], out_soa[2][i]};
+      glm_mat4_mulv3(m, points[i], (float)w, expected);
+      worst[check] = fmax(worst[check], relative_error_float(out3[i], expected, 3));
+      worst[soa_check] = fmax(worst[soa_check], relative_error_float(from_soa, expected, 3));
+    }
+  }
+
+  for (int i = 0; i < CHECK_BATCH; i++) {
+    glm_vec3_copy(points[i], out3[i]);
+  }
+  batch_transform_points(m, (const vec3 *)out3, out3, CHECK_BATCH);
+  for (int i = 0; i < CHECK_BATCH; i++) {
+    vec3 expected;
+    glm_mat4_mulv3(m, points[i], 1.0f, expected);
+    worst[CHECK_POINTS_IN_PLACE] = fmax(worst[CHECK_POINTS_IN_PLACE], relative_error_float(out3[i], expected, 3));
+  }
+}
+
+// batch_aabb_transform and batch_sphere_transform with the current kernels
+// against glm_aabb_transform, glm_mat4_mulv3 and the largest axis scale
+void check_bounds(double *worst) {
+  static CGLM_ALIGN_MAT mat4 transforms[BENCH_BATCH];
+  static vec3 out_boxes[BENCH_BATCH][2];
+  static vec4 spheres[BENCH_BATCH], out_spheres[BENCH_BATCH];
+
+  for (int i = 0; i < CHECK_BATCH; i++) {
+    // non-uniform scale, so the largest axis matters
+    glm_mat4_copy(matrices_a[i], transforms[i]);
+    glm_scale(transforms[i], (vec3){0.5f + fabsf(vectors[i][0]) * 0.1f, 0.5f + fabsf(vectors[i][1]) * 0.1f, 1.2f});
+    glm_vec4_copy((vec4){points[i][0], points[i][1], points[i][2], 0.1f + fabsf(vectors[i][2])}, spheres[i]);
+  }
+
+  batch_aabb_transform(boxes, transforms, out_boxes, CHECK_BATCH);
+  batch_sphere_transform(spheres, transforms, out_spheres, CHECK_BATCH);
+  for (int i = 0; i < CHECK_BATCH; i++) {
+    vec3 expected_box[2], expected_center;
+    glm_aabb_transform(boxes[i], transforms[i], expected_box);
+    worst[CHECK_AABB_TRANSFORM] = fmax(worst[CHECK_AABB_TRANSFORM],
+                                       relative_error_float(out_boxes[i][0], expected_box[0], 6));
+
+    glm_mat4_mulv3(transforms[i], spheres[i], 1.0f, expected_center);
+    worst[CHECK_SPHERE_CENTER] = fmax(worst[CHECK_SPHERE_CENTER],
+                                      relative_error_float(out_spheres[i], expected_center, 3));
+    double scale = 0.0;
+    for (int c = 0; c < 3; c++) {
+      float *axis = transforms[i][c];
+      scale = fmax(scale, (double)axis[0] * axis[0] + (double)axis[1] * axis[1] + (double)axis[2] * axis[2]);
+    }
+    double radius = spheres[i][3] * sqrt(scale);
+    worst[CHECK_SPHERE_RADIUS] = fmax(worst[CHECK_SPHERE_RADIUS], relative_error(&out_spheres[i][3], &radius, 1));
+  }
+}
+
+// worst error of each function over the whole batch, returns how many are over their limit
+int check_accuracy() {
+  const char *names[NUM_CHECKS] = {"mat4_mul", "mat4_mul2", "mat4_inv", "mat4_inv2", "mat4_inv_fast",
+                                   "mat4_inv_fast2", "mat4_mulv", "quat_mul", "quat_mul2", "ray_triangle8",
+                                   "ray8_triangle", "noise_points2", "noise_points3", "noise_grid2", "noise_grid3",
+                                   "pose_nlerp", "pose_slerp", "pose_matrices", "bvh_frustum", "bvh_aabb",
+                                   "bvh_sphere", "bvh_raycast", "aabb_transform", "sphere_center",
+                                   "sphere_radius", "batch_mulv", "transform_vec4", "transform_points",
+                                   "transform_dirs", "points_soa", "dirs_soa", "points_in_place", "cull_range"};
+  const double limits[NUM_CHECKS] = {ACCURACY_EXACT, ACCURACY_EXACT, ACCURACY_INVERSE, ACCURACY_INVERSE,
+                                     ACCURACY_FAST_INVERSE, ACCURACY_FAST_INVERSE, ACCURACY_EXACT,
+                                     ACCURACY_EXACT, ACCURACY_EXACT, ACCURACY_EXACT, ACCURACY_EXACT,
+                                     ACCURACY_NOISE, ACCURACY_NOISE, ACCURACY_NOISE, ACCURACY_NOISE,
+                                     ACCURACY_EXACT, ACCURACY_EXACT, ACCURACY_EXACT, ACCURACY_MATCH, ACCURACY_MATCH,
+                                     ACCURACY_MATCH, ACCURACY_MATCH, ACCURACY_EXACT, ACCURACY_EXACT, ACCURACY_EXACT,
+                                     ACCURACY_EXACT, ACCURACY_EXACT, ACCURACY_EXACT, ACCURACY_EXACT, ACCURACY_EXACT,
+                                     ACCURACY_EXACT, ACCURACY_EXACT, ACCURACY_MATCH};
+  double worst[NUM_CHECKS] = {0};
+
+  for (int i = 0; i + 1 < BENCH_BATCH; i += 2) {
+    double product[2][4][4], inverse[2][4][4], vector[4], quat[2][4];
+    CGLM_ALIGN_MAT mat4 pair[2];
+    CGLM_ALIGN(16) versor quat_pair[2];
+
+    for (int k = 0; k < 2; k++) {
+      reference_mat4_mul(matrices_a[i + k], matrices_b[i + k], product[k]);
+      reference_mat4_inv(matrices_a[i + k], inverse[k]);
+      reference_quat_mul(quats_a[i + k], quats_b[i + k], quat[k]);
+    }
+
+    glm_mat4_mul(matrices_a[i], matrices_b[i], matrices_out[i]);
+    worst[CHECK_MAT4_MUL] = fmax(worst[CHECK_MAT4_MUL], relative_error(matrices_out[i][0], product[0][0], 16));
+    glm_mat4_inv(matrices_a[i], matrices_out[i]);
+    worst[CHECK_MAT4_INV] = fmax(worst[CHECK_MAT4_INV], relative_error(matrices_out[i][0], inverse[0][0], 16));
+    glm_mat4_inv_fast(matrices_a[i], matrices_out[i]);
+    worst[CHECK_MAT4_INV_FAST] = fmax(worst[CHECK_MAT4_INV_FAST], relative_error(matrices_out[i][0], inverse[0][0], 16));
+    glm_quat_mul(quats_a[i], quats_b[i], quats_out[i]);
+    worst[CHECK_QUAT_MUL] = fmax(worst[CHECK_QUAT_MUL], relative_error(quats_out[i], quat[0], 4));
+
+    glm_mat4_mul2(&matrices_a[i], &matrices_b[i], pair);
+    for (int k = 0; k < 2; k++) {
+      worst[CHECK_MAT4_MUL2] = fmax(worst[CHECK_MAT4_MUL2], relative_error(pair[k][0], product[k][0], 16));
+    }
+    glm_mat4_inv2(&matrices_a[i], pair);
+    for (int k = 0; k < 2; k++) {
+      worst[CHECK_MAT4_INV2] = fmax(worst[CHECK_MAT4_INV2], relative_error(pair[k][0], inverse[k][0], 16));
+    }
+    glm_mat4_inv_fast2(&matrices_a[i], pair);
+    for (int k = 0; k < 2; k++) {
+      worst[CHECK_MAT4_INV_FAST2] = fmax(worst[CHECK_MAT4_INV_FAST2], relative_error(pair[k][0], inverse[k][0], 16));
+    }
+    glm_quat_mul2(&quats_a[i], &quats_b[i], quat_pair);
+    for (int k = 0; k < 2; k++) {
+      worst[CHECK_QUAT_MUL2] = fmax(worst[CHECK_QUAT_MUL2], relative_error(quat_pair[k], quat[k], 4));
+    }
+
+    for (int r = 0; r < 4; r++) {
+      vector[r] = 0.0;
+      for (int k = 0; k < 4; k++) {
+        vector[r] += (double)matrices_a[i][k][r] * vectors[i][k];
+      }
+    }
+    glm_mat4_mulv(matrices_a[i], vectors[i], vectors_out[i]);
+    worst[CHECK_MAT4_MULV] = fmax(worst[CHECK_MAT4_MULV], relative_error(vectors_out[i], vector, 4));
+  }
+
+  // the rays of the ray_triangle benchmarks, against glm_ray_triangle() one pair at a time
+  vec3 origin = {0.0f, 0.0f, 0.0f};
+  for (int g = 0; g < BENCH_BATCH / 8; g++) {
+    float (*t)[3][8] = triangles[g];
+    float rays[3][8], origins[3][8] = {{0}};
+    float d[8] = {0}, reference_d[8] = {0};
+    int reference_hits = 0;
+
+    vec3 dir = {points[8 * g][0] * 0.05f, points[8 * g][1] * 0.05f, 1.0f};
+    for (int lane = 0; lane < 8; lane++) {
+      vec3 v0 = {t[0][0][lane], t[0][1][lane], t[0][2][lane]};
+      vec3 v1 = {t[1][0][lane], t[1][1][lane], t[1][2][lane]};
+      vec3 v2 = {t[2][0][lane], t[2][1][lane], t[2][2][lane]};
+      reference_hits |= glm_ray_triangle(origin, dir, v0, v1, v2, &reference_d[lane]) << lane;
+    }
+    int hits = glm_ray_triangle8(origin, dir, t[0], t[1], t[2], d);
+    worst[CHECK_RAY_TRIANGLE8] = fmax(worst[CHECK_RAY_TRIANGLE8], ray_error(hits, reference_hits, d, reference_d));
+
+    // eight rays at the group's first triangle
+    vec3 v0 = {t[0][0][0], t[0][1][0], t[0][2][0]};
+    vec3 v1 = {t[1][0][0], t[1][1][0], t[1][2][0]};
+    vec3 v2 = {t[2][0][0], t[2][1][0], t[2][2][0]};
+    reference_hits = 0;
+    for (int lane = 0; lane < 8; lane++) {
+      vec3 ray = {points[8 * g + lane][0] * 0.05f, points[8 * g + lane][1] * 0.05f, 1.0f};
+      for (int axis = 0; axis < 3; axis++) {
+        rays[axis][lane] = ray[axis];
+      }
+      d[lane] = reference_d[lane] = 0.0f;
+      reference_hits |= glm_ray_triangle(origin, ray, v0, v1, v2, &reference_d[lane]) << lane;
+    }
+    hits = glm_ray8_triangle(origins, rays, v0, v1, v2, d);
+    worst[CHECK_RAY8_TRIANGLE] = fmax(worst[CHECK_RAY8_TRIANGLE], ray_error(hits, reference_hits, d, reference_d));
+  }
+
+  check_bvh(worst);
+
+  // the runtime-dispatched kernels, worst over every level this CPU runs
+  simd_level best = simd_detect();
+  printf("kernel levels checked:");
+  for (int level = SIMD_BASE; level <= best; level++) {
+    printf(" %s", simd_level_name(level));
+    simd_use(level);
+    check_noise(worst);
+    check_pose(worst);
+    check_transforms(worst);
+    check_bounds(worst);
+    check_cull(worst);
+  }
+  printf("\n");
+  simd_use(best);
+
+  int failures = 0;
+  printf("%-16s %10s %10s\n", "accuracy", "error", "limit");
+  for (int i = 0; i < NUM_CHECKS; i++) {
+    int failed = !(worst[i] <= limits[i]);
+    failures += failed;
+    printf("%-16s %10.2e %10.2e%s\n", names[i], worst[i], limits[i], failed ? "  FAILED" : "");
+  }
+  printf("\n");
+  return failures;
+}
+
+// best time per item over BENCH_RUNS runs of at least BENCH_MIN_MS each
+double measure(benchmark *bench) {
+  // warm up and find how many batches fill a run
+  long batches = 1;
+  for (;;) {
+    double start = now_ms();
+    for (long b = 0; b < batches; b++) {
+      bench->run(BENCH_BATCH);
+    }
+    if (now_ms() - start >= BENCH_MIN_MS) {
+      break;
+    }
+    batches *= 2;
+  }
+
+  double best = -1.0;
+  for (int r = 0; r < BENCH_RUNS; r++) {
+    double start = now_ms();
+    for (long b = 0; b < batches; b++) {
+      bench->run(BENCH_BATCH);
+    }
+    double ns = (now_ms() - start) * 1e6 / ((double)batches * BENCH_BATCH);
+    if (best < 0.0 || ns < best) {
+      best = ns;
+    }
+  }
+  return best;
+}
+
+int write_results(const char *path) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    fprintf(stderr, "ERROR: could not open \"%s\" for writing.\n", path);
+    return -1;
+  }
+
+  fprintf(file, "{\n  \"variant\": \"%s\",\n  \"results\": {", BENCH_VARIANT);
+  const char *separator = "\n";
+  for (int i = 0; i < NUM_BENCHMARKS; i++) {
+    if (benchmarks[i].ns_per_op <= 0.0) {
+      continue;
+    }
+    fprintf(file, "%s    \"%s\": {\"ns_per_op\": %.4f, \"mops\": %.2f}", separator, benchmarks[i].name,
+            benchmarks[i].ns_per_op, 1e3 / benchmarks[i].ns_per_op);
+    separator = ",\n";
+  }
+  fprintf(file, "\n  }\n}\n");
+
+  if (fclose(file) != 0) {
+    fprintf(stderr, "ERROR: could not write \"%s\".\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+// the baseline is a file written by --out, benchmarks skipped by --filter are
+// left out of both. returns the number of regressions,
+// 0 if there is no baseline yet
+int compare_baseline(const char *path, double tolerance) {
+  file_view baseline;
+  int result = file_map(path, &baseline);
+  if (result == FILE_ERROR_OPEN) {
+    printf("No baseline at %s yet, run `make bench-baseline` to record one.\n", path);
+    return 0;
+  }
+  if (result != FILE_OK) {
+    fprintf(stderr, "ERROR: could not read baseline \"%s\": %s.\n", path, file_error_string(result));
+    return 1;
+  }
+
+  int regressions = 0;
+  printf("\n%-16s %10s %10s %8s\n", "vs baseline", "ns/op", "was", "change");
+  for (int i = 0; i < NUM_BENCHMARKS; i++) {
+    if (benchmarks[i].ns_per_op <= 0.0) {
+      continue;
+    }
+
+    char key[64];
+    snprintf(key, sizeof(key), "\"%s\"", benchmarks[i].name);
+    const char *entry = strstr(baseline.data, key);
+    const char *value = entry ? strstr(entry, "\"ns_per_op\":") : NULL;
+    if (!value) {
+      printf("%-16s %10.3f %10s\n", benchmarks[i].name, benchmarks[i].ns_per_op, "-");
+      continue;
+    }
+
+    double was = strtod(value + strlen("\"ns_per_op\":"), NULL);
+    double change = benchmarks[i].ns_per_op / was - 1.0;
+    int regressed = change > tolerance;
+    regressions += regressed;
+    printf("%-16s %10.3f %10.3f %+7.1f%%%s\n", benchmarks[i].name, benchmarks[i].ns_per_op, was,
+           change * 100.0, regressed ? "  REGRESSION" : "");
+  }
+
+  file_release(&baseline);
+  return regressions;
+}
+
+void usage(const char *program) {
+  fprintf(stderr, "usage: %s [--out FILE.json] [--baseline FILE.json] [--tolerance FRACTION] [--filter NAME]\n", program);
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  const char *out = NULL;
+  const char *baseline = NULL;
+  const char *filter = NULL;
+  double tolerance = BENCH_TOLERANCE;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      out = argv[++i];
+    } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+      baseline = argv[++i];
+    } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+      tolerance = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else {
+      usage(argv[0]);
+    }
+  }
+
+#if defined(__AVX2__)
+  // built for AVX2 and FMA, which this machine may not have
+  __builtin_cpu_init();
+  if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+    printf("Skipping the %s benchmarks, this CPU has no AVX2 and FMA.\n", BENCH_VARIANT);
+    return 0;
+  }
+#elif defined(__AVX__)
+  // built for AVX, which this machine may not have
+  __builtin_cpu_init();
+  if (!__builtin_cpu_supports("avx")) {
+    printf("Skipping the %s benchmarks, this CPU has no AVX.\n", BENCH_VARIANT);
+    return 0;
+  }
+#endif
+
+  fill_inputs();
+
+  printf("cglm %d.%d.%d, %s build, batches of %i\n", CGLM_VERSION_MAJOR, CGLM_VERSION_MINOR, CGLM_VERSION_PATCH,
+         BENCH_VARIANT, BENCH_BATCH);
+  if (check_accuracy() != 0) {
+    printf("Results differ from the scalar reference.\n");
+    return 1;
+  }
+
+  printf("%-16s %10s %10s\n", "", "ns/op", "Mops/s");
+  for (int i = 0; i < NUM_BENCHMARKS; i++) {
+    if (filter && !strstr(benchmarks[i].name, filter)) {
+      continue;
+    }
+    benchmarks[i].ns_per_op = measure(&benchmarks[i]);
+    printf("%-16s %10.3f %10.2f\n", benchmarks[i].name, benchmarks[i].ns_per_op, 1e3 / benchmarks[i].ns_per_op);
+  }
+
+  if (out && write_results(out) != 0) {
+    return 1;
+  }
+
+  if (baseline) {
+    int regressions = compare_baseline(baseline, tolerance);
+    if (regressions > 0) {
+      printf("%i regression%s beyond %.0f%%.\n", regressions, regressions == 1 ? "" : "s", tolerance * 100.0);
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,371 @@
+#include "ecs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INDEX_BITS 24
+#define ALIGN_LINE(size) (((size) + 63) & ~(size_t)63)
+
+// each component id set in mask, lowest first
+#define FOR_EACH_COMPONENT(c, mask) \
+  for (ecs_mask bits_ = (mask), c = 0; bits_ && ((c = __builtin_ctzll(bits_)), 1); bits_ &= bits_ - 1)
+
+
+static inline int entity_index(ecs_entity entity) {
+  return entity & (ECS_MAX_ENTITIES - 1);
+}
+
+static inline ecs_entity make_entity(int index, uint8_t generation) {
+  return (ecs_entity)index | (ecs_entity)generation << INDEX_BITS;
+}
+
+static inline char *row_address(const ecs_archetype *archetype, int row, int *index) {
+  *index = row % archetype->chunk_capacity;
+  return archetype->chunks[row / archetype->chunk_capacity];
+}
+
+int ecs_init(ecs_world *world) {
+  memset(world, 0, sizeof(*world));
+  world->free_head = -1;
+  return pool_init(&world->chunk_pool, ECS_CHUNK_SIZE, 64, ECS_CHUNKS_PER_BLOCK);
+}
+
+void ecs_free(ecs_world *world) {
+  for (int i = 0; i < world->num_archetypes; i++) {
+    free(world->archetypes[i].chunks);
+  }
+  free(world->archetypes);
+  free(world->records);
+  pool_free(&world->chunk_pool);
+  memset(world, 0, sizeof(*world));
+  world->free_head = -1;
+}
+
+int ecs_register(ecs_world *world, size_t size) {
+  if (world->num_components == ECS_MAX_COMPONENTS) {
+    fprintf(stderr, "ERROR: too many ECS component types, the limit is %i.\n", ECS_MAX_COMPONENTS);
+    return -1;
+  }
+  world->sizes[world->num_components] = size;
+  return world->num_components++;
+}
+
+// the entity ids first, then each component's array on its own cache line:
+// start from the fit without padding and shrink until the padding fits too
+static int layout_chunk(const ecs_world *world, ecs_archetype *archetype) {
+  size_t row_size = sizeof(ecs_entity);
+  FOR_EACH_COMPONENT(c, archetype->mask) {
+    row_size += world->sizes[c];
+  }
+
+  int capacity = ECS_CHUNK_SIZE / row_size;
+  for (; capacity > 0; capacity--) {
+    size_t offset = ALIGN_LINE(capacity * sizeof(ecs_entity));
+    FOR_EACH_COMPONENT(c, archetype->mask) {
+      archetype->offsets[c] = offset;
+      offset = ALIGN_LINE(offset + capacity * world->sizes[c]);
+    }
+    if (offset <= ECS_CHUNK_SIZE) {
+      break;
+    }
+  }
+
+  archetype->chunk_capacity = capacity;
+  return capacity > 0 ? 0 : -1;
+}
+
+static int find_archetype(ecs_world *world, ecs_mask mask) {
+  for (int i = 0; i < world->num_archetypes; i++) {
+    if (world->archetypes[i].mask == mask) {
+      return i;
+    }
+  }
+
+  if (world->num_archetypes == world->max_archetypes) {
+    int max = world->max_archetypes ? world->max_archetypes * 2 : 16;
+    ecs_archetype *archetypes = realloc(world->archetypes, max * sizeof(ecs_archetype));
+    if (!archetypes) {
+      fprintf(stderr, "ERROR: could not allocate memory for %i ECS archetypes.\n", max);
+      return -1;
+    }
+    world->archetypes = archetypes;
+    world->max_archetypes = max;
+  }
+
+  ecs_archetype *archetype = &world->archetypes[world->num_archetypes];
+  memset(archetype, 0, sizeof(*archetype));
+  archetype->mask = mask;
+  memset(archetype->add_edge, -1, sizeof(archetype->add_edge));
+  memset(archetype->remove_edge, -1, sizeof(archetype->remove_edge));
+  if (layout_chunk(world, archetype) != 0) {
+    fprintf(stderr, "ERROR: ECS components too large to fit in a %i byte chunk.\n", ECS_CHUNK_SIZE);
+    return -1;
+  }
+  return world->num_archetypes++;
+}
+
+// the archetype one component away, found once and then remembered
+static int neighbour(ecs_world *world, int from, int component, int add) {
+  ecs_archetype *archetype = &world->archetypes[from];
+  int to = add ? archetype->add_edge[component] : archetype->remove_edge[component];
+  if (to >= 0) {
+    return to;
+  }
+
+  ecs_mask mask = add ? archetype->mask | ECS_BIT(component) : archetype->mask & ~ECS_BIT(component);
+  to = find_archetype(world, mask);
+  if (to < 0) {
+    return -1;
+  }
+  // find_archetype() may have moved the array
+  archetype = &world->archetypes[from];
+  if (add) {
+    archetype->add_edge[component] = to;
+  } else {
+    archetype->remove_edge[component] = to;
+  }
+  return to;
+}
+
+// a zeroed row at the end of the archetype, -1 if out of memory
+static int append_row(ecs_world *world, int archetype_index, ecs_entity entity) {
+  ecs_archetype *archetype = &world->archetypes[archetype_index];
+
+  if (archetype->count == archetype->num_chunks * archetype->chunk_capacity) {
+    if (archetype->num_chunks == archetype->max_chunks) {
+      int max = archetype->max_chunks ? archetype->max_chunks * 2 : 4;
+      char **chunks = realloc(archetype->chunks, max * sizeof(char *));
+      if (!chunks) {
+        fprintf(stderr, "ERROR: could not allocate memory for %i ECS chunks.\n", max);
+        return -1;
+      }
+      archetype->chunks = chunks;
+      archetype->max_chunks = max;
+    }
+
+    char *chunk = pool_alloc(&world->chunk_pool);
+    if (!chunk) {
+      return -1;
+    }
+    archetype->chunks[archetype->num_chunks++] = chunk;
+  }
+
+  int row = archetype->count++, index;
+  char *chunk = row_address(archetype, row, &index);
+  ((ecs_entity *)chunk)[index] = entity;
+  FOR_EACH_COMPONENT(c, archetype->mask) {
+    memset(chunk + archetype->offsets[c] + index * world->sizes[c], 0, world->sizes[c]);
+  }
+  return row;
+}
+
+// the archetype's last row fills the hole
+static void remove_row(ecs_world *world, int archetype_index, int row) {
+  ecs_archetype *archetype = &world->archetypes[archetype_index];
+  int last = --archetype->count;
+
+  // a second empty chunk at the end goes back to the pool
+  int needed = (archetype->count + archetype->chunk_capacity - 1) / archetype->chunk_capacity;
+  if (archetype->num_chunks > needed + 1) {
+    pool_release(&world->chunk_pool, archetype->chunks[--archetype->num_chunks]);
+  }
+
+  if (row == last) {
+    return;
+  }
+
+  int to, from;
+  char *dest = row_address(archetype, row, &to);
+  char *src = row_address(archetype, last, &from);
+  FOR_EACH_COMPONENT(c, archetype->mask) {
+    size_t size = world->sizes[c];
+    memcpy(dest + archetype->offsets[c] + to * size, src + archetype->offsets[c] + from * size, size);
+  }
+
+  ecs_entity moved = ((ecs_entity *)src)[from];
+  ((ecs_entity *)dest)[to] = moved;
+  world->records[entity_index(moved)].row = row;
+}
+
+static ecs_entity create_in(ecs_world *world, int archetype) {
+  int index;
+  if (world->free_head >= 0) {
+    index = world->free_head;
+  } else {
+    if (world->num_records == ECS_MAX_ENTITIES) {
+      fprintf(stderr, "ERROR: out of ECS entities, the limit is %i.\n", ECS_MAX_ENTITIES);
+      return ECS_NULL;
+    }
+    if (world->num_records == world->max_records) {
+      int max = world->max_records ? world->max_records * 2 : 1024;
+      ecs_record *records = realloc(world->records, max * sizeof(ecs_record));
+      if (!records) {
+        fprintf(stderr, "ERROR: could not allocate memory for %i ECS entities.\n", max);
+        return ECS_NULL;
+      }
+      world->records = records;
+      world->max_records = max;
+    }
+    index = world->num_records;
+    world->records[index] = (ecs_record){-1, -1, 1};
+  }
+
+  ecs_record *record = &world->records[index];
+  ecs_entity entity = make_entity(index, record->generation);
+  int row = append_row(world, archetype, entity);
+  if (row < 0) {
+    return ECS_NULL;
+  }
+
+  if (index == world->free_head) {
+    world->free_head = record->row;
+  } else {
+    world->num_records++;
+  }
+  record->archetype = archetype;
+  record->row = row;
+  world->count++;
+  return entity;
+}
+
+ecs_entity ecs_create(ecs_world *world, ecs_mask mask) {
+  int archetype = find_archetype(world, mask);
+  return archetype >= 0 ? create_in(world, archetype) : ECS_NULL;
+}
+
+int ecs_create_many(ecs_world *world, ecs_mask mask, int count, ecs_entity *out) {
+  int archetype = find_archetype(world, mask);
+  if (archetype < 0) {
+    return 0;
+  }
+  for (int i = 0; i < count; i++) {
+    out[i] = create_in(world, archetype);
+    if (out[i] == ECS_NULL) {
+      return i;
+    }
+  }
+  return count;
+}
+
+int ecs_alive(const ecs_world *world, ecs_entity entity) {
+  int index = entity_index(entity);
+  return index < world->num_records && world->records[index].archetype >= 0 &&
+         world->records[index].generation == (uint8_t)(entity >> INDEX_BITS);
+}
+
+void ecs_destroy(ecs_world *world, ecs_entity entity) {
+  if (!ecs_alive(world, entity)) {
+    return;
+  }
+
+  int index = entity_index(entity);
+  ecs_record *record = &world->records[index];
+  remove_row(world, record->archetype, record->row);
+
+  // generation 0 is skipped so ECS_NULL never comes back to life
+  record->generation = record->generation == 255 ? 1 : record->generation + 1;
+  record->archetype = -1;
+  record->row = world->free_head;
+  world->free_head = index;
+  world->count--;
+}
+
+ecs_mask ecs_components(const ecs_world *world, ecs_entity entity) {
+  if (!ecs_alive(world, entity)) {
+    return 0;
+  }
+  return world->archetypes[world->records[entity_index(entity)].archetype].mask;
+}
+
+void *ecs_get(const ecs_world *world, ecs_entity entity, int component) {
+  if (!ecs_alive(world, entity)) {
+    return NULL;
+  }
+
+  const ecs_record *record = &world->records[entity_index(entity)];
+  const ecs_archetype *archetype = &world->archetypes[record->archetype];
+  if (!(archetype->mask & ECS_BIT(component))) {
+    return NULL;
+  }
+
+  int index;
+  char *chunk = row_address(archetype, record->row, &index);
+  return chunk + archetype->offsets[component] + index * world->sizes[component];
+}
+
+// to a neighbouring archetype, carrying over the components both have
+static int move_entity(ecs_world *world, ecs_entity entity, int to) {
+  ecs_record *record = &world->records[entity_index(entity)];
+  int from = record->archetype, old_row = record->row;
+  int row = append_row(world, to, entity);
+  if (row < 0) {
+    return -1;
+  }
+
+  const ecs_archetype *src = &world->archetypes[from], *dest = &world->archetypes[to];
+  int from_index, to_index;
+  char *src_chunk = row_address(src, old_row, &from_index);
+  char *dest_chunk = row_address(dest, row, &to_index);
+  FOR_EACH_COMPONENT(c, src->mask & dest->mask) {
+    size_t size = world->sizes[c];
+    memcpy(dest_chunk + dest->offsets[c] + to_index * size, src_chunk + src->offsets[c] + from_index * size, size);
+  }
+
+  remove_row(world, from, old_row);
+  record->archetype = to;
+  record->row = row;
+  return 0;
+}
+
+int ecs_add(ecs_world *world, ecs_entity entity, int component) {
+  if (!ecs_alive(world, entity)) {
+    return -1;
+  }
+  int from = world->records[entity_index(entity)].archetype;
+  if (world->archetypes[from].mask & ECS_BIT(component)) {
+    return 0;
+  }
+  int to = neighbour(world, from, component, 1);
+  return to >= 0 ? move_entity(world, entity, to) : -1;
+}
+
+int ecs_remove(ecs_world *world, ecs_entity entity, int component) {
+  if (!ecs_alive(world, entity)) {
+    return -1;
+  }
+  int from = world->records[entity_index(entity)].archetype;
+  if (!(world->archetypes[from].mask & ECS_BIT(component))) {
+    return 0;
+  }
+  int to = neighbour(world, from, component, 0);
+  return to >= 0 ? move_entity(world, entity, to) : -1;
+}
+
+void ecs_query_init(ecs_query *query, ecs_world *world, ecs_mask mask) {
+  memset(query, 0, sizeof(*query));
+  query->world = world;
+  query->mask = mask;
+  query->chunk = -1;
+}
+
+int ecs_query_next(ecs_query *query) {
+  const ecs_world *world = query->world;
+  for (; query->archetype < world->num_archetypes; query->archetype++, query->chunk = -1) {
+    const ecs_archetype *archetype = &world->archetypes[query->archetype];
+    if ((archetype->mask & query->mask) != query->mask) {
+      continue;
+    }
+
+    int capacity = archetype->chunk_capacity;
+    int used = (archetype->count + capacity - 1) / capacity;
+    if (++query->chunk < used) {
+      query->data = archetype->chunks[query->chunk];
+      query->entities = (ecs_entity *)query->data;
+      query->offsets = archetype->offsets;
+      query->count = query->chunk == used - 1 ? archetype->count - query->chunk * capacity : capacity;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include "engine.h"
+
+#include <string.h>
+#include "math/simd.h"
+#include "utils/parallel.h"
+
+
+int engine_init(engine_state *state) {
+  memset(state, 0, sizeof(*state));
+
+  // before anything that might start worker threads running the kernels
+  simd_init();
+
+  if (jobs_init(&state->jobs, 0) != 0) {
+    return -1;
+  }
+  parallel_use_jobs(&state->jobs);
+
+  if (render_queue_init(&state->queue, 0) != 0) {
+    goto fail_queue;
+  }
+  if (ring_buffer_init(&state->stream, GL_ARRAY_BUFFER, ENGINE_STREAM_FRAME_SIZE) != 0) {
+    goto fail_stream;
+  }
+
+  // a cache that can't be used only makes startup slower, it isn't fatal
+  program_cache_init(&state->programs, ENGINE_PROGRAM_CACHE_DIR);
+  shader_pipeline_init(&state->shaders, &state->programs);
+
+  if (texture_manager_init(&state->textures, &state->jobs) != 0) {
+    goto fail_textures;
+  }
+  if (cull_pool_init(&state->culler, &state->jobs) != 0) {
+    goto fail_culler;
+  }
+  if (ecs_init(&state->world) != 0) {
+    goto fail_world;
+  }
+  return 0;
+
+  // each label undoes the steps before the one that failed, newest first
+fail_world:
+  cull_pool_free(&state->culler);
+fail_culler:
+  texture_manager_free(&state->textures);
+fail_textures:
+  shader_pipeline_free(&state->shaders);
+  ring_buffer_free(&state->stream);
+fail_stream:
+  render_queue_free(&state->queue);
+fail_queue:
+  parallel_use_jobs(NULL);
+  jobs_free(&state->jobs);
+  return -1;
+}
+
+void engine_free(engine_state *state) {
+  ecs_free(&state->world);
+  cull_pool_free(&state->culler);
+  texture_manager_free(&state->textures);
+  shader_pipeline_free(&state->shaders);
+  ring_buffer_free(&state->stream);
+  render_queue_free(&state->queue);
+  parallel_use_jobs(NULL);
+  jobs_free(&state->jobs);
+}
+
+int engine_draw(engine_state *state) {
+  shader_pipeline_poll(&state->shaders, 0);
+  texture_manager_update(&state->textures);
+
+  ring_buffer_unmap(&state->stream);
+  render_queue_submit(&state->queue, &state->jobs);
+  ring_buffer_end_frame(&state->stream);
+  return 0;
+}
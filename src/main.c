@@ -1,10 +1,22 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <signal.h>
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
 
 #include "cglm/cglm.h"
+#include "engine.h"
+#include "math/batch.h"
+#include "math/simd.h"
+#include "utils/arena.h"
 #include "utils/file_read.h"
+#include "utils/frame_stats.h"
+#include "render/gl_state.h"
+#include "render/bvh.h"
+#include "render/frame_pipeline.h"
+#include "render/instancing.h"
+#include "platform/headless.h"
 
 
 // IMPORTANT: the framebuffer is measured in pixels, but the window is measured in screen coordinates
@@ -19,23 +31,87 @@ GLFWmonitor *monitor = NULL;
 int window_width = 800;
 int window_height = 600;
 GLFWwindow *window;
+int headless = 0;
+volatile sig_atomic_t headless_should_close = 0;
 double cursor_x, cursor_y;
-GLuint vao, vbo, vs, fs, shader_program;
-char *vs_src, *fs_src;
+GLuint vao, vbo, shader_program;
+file_view vs_file, fs_file;
+
+// --instances N draws N copies of the triangle with one instanced call instead
+int num_instances = 0;
+GLuint instanced_program;
+GLint view_projection_loc = -1;
+program_handle instanced_handle = -1;
+file_view instanced_vs_file;
+instance_buffer instances;
+mat4 *instance_models;
+
+// --draws N submits N separately transformed triangles through the render queue instead
+int num_draws = 0;
+// one entity per draw, in draw order so cull and bvh indices map straight to them
+ecs_entity *draw_entities;
+int draw_model_component, draw_mvp_component;
+// world space bounds of the draws, only the visible ones are pushed each frame
+cull_bounds draw_bounds;
+// for picking them with the mouse
+bvh draw_tree;
+int mouse_was_pressed = 0;
+int pick_requested = 0;
+
+engine_state engine;
+
+// what the simulation builds its snapshots from, fixed once the pipeline starts
+typedef struct {
+  mat4 view_projection;
+  mat4 mvp;
+  // everything but the transform
+  draw_packet packet;
+} scene;
+
+scene sim_scene;
+// --latency N lets the simulation run up to N frames ahead of the GL thread
+int pipeline_latency = 1;
+frame_pipeline pipeline;
+// the snapshot queue's, kept for the report since snapshots are reused
+render_queue_stats scene_queue_stats;
+// and the snapshots' frame arenas
+size_t frame_memory_used, frame_memory_high_water;
+// what each snapshot's frame arena starts with, on top of the draws' visible list
+#define FRAME_MEMORY (64 * 1024)
+
+// frames rendered before --bench starts recording, so driver warm-up and shader
+// compilation don't end up in the numbers.
+#define BENCH_WARMUP_FRAMES 30
+
+int bench_frames = 0;
+double bench_seconds = 0.0;
+const char *bench_out = NULL;
+int benchmarking = 0;
+int bench_warmup = BENCH_WARMUP_FRAMES;
+double bench_start_ms;
+frame_stats bench_stats;
+int phase_events, phase_snapshot, phase_draw, phase_swap;
 
-// pretty sure I can detach and delete the shaders once the shader program has been made.
 void die(int exit_code) {
-  glDisableVertexAttribArray(0);
-  glDetachShader(shader_program, vs);
-  glDetachShader(shader_program, fs);
-  glDeleteProgram(shader_program);
-  glDeleteShader(vs);
-  glDeleteShader(fs);
+  // the simulation uses the engine too
+  frame_pipeline_free(&pipeline);
+  engine_free(&engine);
+  arena_scratch_free();
+  free(draw_entities);
+  cull_bounds_free(&draw_bounds);
+  bvh_free(&draw_tree);
+  free(instance_models);
   glDeleteBuffers(1, &vbo);
+  instance_buffer_free(&instances);
   glDeleteVertexArrays(1, &vao);
-  free(vs_src);
-  free(fs_src);
-  glfwTerminate();
+  file_release(&vs_file);
+  file_release(&fs_file);
+  file_release(&instanced_vs_file);
+  if (headless) {
+    headless_terminate();
+  } else {
+    glfwTerminate();
+  }
   exit(exit_code);
 }
 
@@ -45,26 +121,12 @@ void error_callback_glfw(int error, const char *msg) {
   die(1);
 }
 
-GLuint compile_shader(const char *shader_src, GLenum shader_type) {
-  GLuint shader = glCreateShader(shader_type);
-  glShaderSource(shader, 1, &shader_src, NULL);
-  glCompileShader(shader);
-
-  int is_compiled = 0;
-  glGetShaderiv(shader, GL_COMPILE_STATUS, &is_compiled);
-
-  if (is_compiled == GL_FALSE) {
-    int max_len = 2048;
-    char log[max_len];
-
-    glGetShaderInfoLog(shader, max_len, NULL, log);
-
-    fprintf(stderr, "ERROR: compile shader index %i did not compile.\n%s\n", shader, log);
-
+void load_source(const char *path, file_view *view) {
+  int result = file_map(path, view);
+  if (result != FILE_OK) {
+    fprintf(stderr, "ERROR: could not load \"%s\": %s.\n", path, file_error_string(result));
     die(1);
   }
-
-  return shader;
 }
 
 void print_vec3(vec3 v) {
@@ -83,7 +145,65 @@ void print_mat4(mat4 m) {
   }
 }
 
-void init() {
+void handle_signal_headless(int sig) {
+  headless_should_close = 1;
+}
+
+// there is no window to close in headless mode, so the loop runs until the process is told to stop.
+int should_close() {
+  if (headless) {
+    return headless_should_close;
+  }
+  return glfwWindowShouldClose(window);
+}
+
+void poll_events() {
+  if (headless) {
+    return;
+  }
+  glfwPollEvents();
+  if (GLFW_PRESS == glfwGetKey(window, GLFW_KEY_ESCAPE)) {
+    glfwSetWindowShouldClose(window, 1);
+  }
+  glfwGetFramebufferSize(window, &window_width, &window_height);
+
+  int pressed = GLFW_PRESS == glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT);
+  if (pressed && !mouse_was_pressed) {
+    glfwGetCursorPos(window, &cursor_x, &cursor_y);
+    pick_requested = 1;
+  }
+  mouse_was_pressed = pressed;
+}
+
+void swap_buffers() {
+  if (headless) {
+    glFlush();
+    return;
+  }
+  glfwSwapBuffers(window);
+}
+
+void init_headless() {
+  if (headless_init() != 0) {
+    exit(1);
+  }
+
+  signal(SIGINT, handle_signal_headless);
+  signal(SIGTERM, handle_signal_headless);
+
+  if (!gladLoadGLLoader((GLADloadproc)headless_get_proc_address)) {
+    fprintf(stderr, "ERROR: Failed to initialize OpenGL context.\n");
+    headless_terminate();
+    exit(1);
+  }
+
+  if (headless_create_framebuffer(window_width, window_height) != 0) {
+    headless_terminate();
+    exit(1);
+  }
+}
+
+void init_window() {
   printf("Starting GLFW %s. \n", glfwGetVersionString());
 
   glfwSetErrorCallback(error_callback_glfw);
@@ -109,14 +229,295 @@ void init() {
     glfwTerminate();
     exit(1);
   }
+}
+
+void bench_init() {
+  if (frame_stats_init(&bench_stats, bench_frames) != 0) {
+    die(1);
+  }
+
+  phase_events = frame_stats_add_phase(&bench_stats, "events");
+  phase_snapshot = frame_stats_add_phase(&bench_stats, "snapshot");
+  phase_draw = frame_stats_add_phase(&bench_stats, "draw");
+  phase_swap = frame_stats_add_phase(&bench_stats, "swap");
+
+  // vsync would turn every number into the refresh interval
+  if (!headless) {
+    glfwSwapInterval(0);
+  }
+
+  printf("Benchmarking %s after %i warm-up frames.\n", bench_frames > 0 ? "a fixed frame count" : "for a time budget", bench_warmup);
+}
+
+void bench_begin_frame() {
+  if (!benchmarking || bench_warmup > 0) {
+    return;
+  }
+  if (bench_stats.num_frames == 0) {
+    bench_start_ms = frame_stats_now_ms();
+  }
+  if (frame_stats_begin_frame(&bench_stats) != 0) {
+    die(1);
+  }
+}
+
+void bench_mark(int phase) {
+  if (!benchmarking || bench_warmup > 0) {
+    return;
+  }
+  frame_stats_mark(&bench_stats, phase);
+}
+
+// returns 1 once the requested number of frames or time budget has been recorded
+int bench_end_frame() {
+  if (!benchmarking) {
+    return 0;
+  }
+  if (bench_warmup > 0) {
+    bench_warmup--;
+    return 0;
+  }
+
+  int frames = frame_stats_end_frame(&bench_stats);
+  if (bench_frames > 0) {
+    return frames >= bench_frames;
+  }
+  return frame_stats_now_ms() - bench_start_ms >= bench_seconds * 1e3;
+}
+
+void bench_report() {
+  frame_stats_finish(&bench_stats);
+  frame_stats_print(&bench_stats);
+
+  gl_state_counters gl_calls = gl_state_last_frame();
+  printf("GL state calls last frame: %lu issued, %lu elided\n", gl_calls.issued, gl_calls.elided);
+
+  // the instanced draw goes straight to the engine's queue, everything else through the snapshots
+  render_queue_stats *queue = instanced_program ? &engine.queue.last_stats : &scene_queue_stats;
+  printf("Render queue last frame: %i packets sorted in %.3f ms, recorded in %.3f ms into %i buffers, "
+         "%i state changes (%i unsorted)\n", queue->packets, queue->sort_ms, queue->record_ms, queue->buffers,
+         queue->state_changes, queue->unsorted_state_changes);
+
+  if (num_draws > 0) {
+    cull_stats *cull = &engine.culler.last_stats;
+    printf("Culling last frame: %i of %i boxes visible in %.3f ms\n", cull->visible, cull->tested, cull->ms);
+  }
+
+  printf("Stream buffer: %li bytes high water per frame, %lu frames waited on the GPU\n",
+         (long)engine.stream.high_water, engine.stream.waits);
+
+  printf("Frame arena: %zu bytes last frame, %zu high water\n", frame_memory_used, frame_memory_high_water);
+  printf("ECS chunk pool: %i chunks live, %i high water\n", engine.world.chunk_pool.live,
+         engine.world.chunk_pool.high_water);
+
+  int result = 0;
+  if (bench_out) {
+    result = frame_stats_write(&bench_stats, bench_out);
+  }
+
+  frame_stats_free(&bench_stats);
+
+  if (result != 0) {
+    die(1);
+  }
+}
+
+// lays the instances out on a square grid in the plane the camera looks at
+void fill_instance_grid(mat4 *models, int count) {
+  int side = 1;
+  while (side * side < count) {
+    side++;
+  }
+
+  float scale = 1.0f / side;
+  for (int i = 0; i < count; i++) {
+    float y = -1.0f + (2 * (i / side) + 1) * scale;
+    float z = -1.0f + (2 * (i % side) + 1) * scale;
+
+    glm_translate_make(models[i], (vec3){0.0f, y, z});
+    glm_scale_uni(models[i], scale);
+  }
+}
+
+void init_instances() {
+  load_source("src/shaders/instanced.vert", &instanced_vs_file);
+  instanced_handle = shader_pipeline_submit(&engine.shaders, instanced_vs_file.data, fs_file.data, NULL);
+  if (instanced_handle < 0) {
+    die(1);
+  }
+
+  if (instance_buffer_init(&instances) != 0) {
+    die(1);
+  }
+  // the same triangle as the plain VAO
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, vbo);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, NULL);
+
+  instance_models = malloc(num_instances * sizeof(mat4));
+  if (!instance_models) {
+    fprintf(stderr, "ERROR: could not allocate %i instance matrices.\n", num_instances);
+    die(1);
+  }
+
+  fill_instance_grid(instance_models, num_instances);
+}
+
+// picks up the instanced program once the pipeline has finished building it
+void check_instanced_program() {
+  program_status status = shader_pipeline_status(&engine.shaders, instanced_handle);
+  if (status == PROGRAM_FAILED) {
+    die(1);
+  }
+  if (status != PROGRAM_READY) {
+    return;
+  }
+
+  instanced_program = shader_pipeline_program(&engine.shaders, instanced_handle);
+  view_projection_loc = glGetUniformLocation(instanced_program, "view_projection");
+  if (view_projection_loc == -1) {
+    fprintf(stderr, "ERROR: failed to find a shader uniform.\n");
+    die(1);
+  }
+}
+
+void init_draws(mat4 view_projection) {
+  draw_model_component = ecs_register(&engine.world, sizeof(mat4));
+  draw_mvp_component = ecs_register(&engine.world, sizeof(mat4));
+  ecs_mask mask = ECS_BIT(draw_model_component) | ECS_BIT(draw_mvp_component);
+
+  draw_entities = malloc(num_draws * sizeof(ecs_entity));
+  if (!draw_entities || ecs_create_many(&engine.world, mask, num_draws, draw_entities) != num_draws) {
+    fprintf(stderr, "ERROR: could not allocate %i draw entities.\n", num_draws);
+    die(1);
+  }
+
+  // only needed until the bounds and the tree are built
+  arena *scratch = arena_scratch();
+  if (!scratch) {
+    die(1);
+  }
+  arena_mark mark = arena_get_mark(scratch);
+  mat4 *models = arena_alloc(scratch, num_draws * sizeof(mat4), 64);
+  vec3 (*world)[2] = arena_alloc(scratch, num_draws * sizeof(*world), 64);
+  if (!models || !world || cull_bounds_init(&draw_bounds, num_draws) != 0) {
+    fprintf(stderr, "ERROR: could not allocate %i draw bounds.\n", num_draws);
+    arena_release(scratch, mark);
+    die(1);
+  }
+
+  // the triangle's own bounds
+  vec3 local[2] = {{-1.0f, -1.0f, 0.0f}, {1.0f, 1.0f, 0.0f}};
+
+  fill_instance_grid(models, num_draws);
+  for (int i = 0; i < num_draws; i++) {
+    memcpy(world[i], local, sizeof(local));
+    glm_mat4_copy(models[i], *(mat4 *)ecs_get(&engine.world, draw_entities[i], draw_model_component));
+  }
+  batch_aabb_transform(world, models, world, num_draws);
+  for (int i = 0; i < num_draws; i++) {
+    cull_bounds_add(&draw_bounds, world[i]);
+  }
+
+  ecs_query query;
+  ecs_query_init(&query, &engine.world, mask);
+  while (ecs_query_next(&query)) {
+    mat4 *model = ecs_column(&query, draw_model_component);
+    mat4 *mvp = ecs_column(&query, draw_mvp_component);
+    for (int i = 0; i < query.count; i++) {
+      glm_mat4_mul(view_projection, model[i], mvp[i]);
+    }
+  }
+
+  int result = bvh_init(&draw_tree) == 0 ? bvh_build(&draw_tree, world, num_draws) : -1;
+  arena_release(scratch, mark);
+  if (result != 0) {
+    die(1);
+  }
+}
+
+int pick_test(void *user, int draw, vec3 origin, vec3 dir, float *distance) {
+  mat4 *model = ecs_get(&engine.world, draw_entities[draw], draw_model_component);
+  vec3 corners[3] = {{-1.0f, -1.0f, 0.0f}, {1.0f, -1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}};
+  for (int i = 0; i < 3; i++) {
+    glm_mat4_mulv3(*model, corners[i], 1.0f, corners[i]);
+  }
+  return glm_ray_triangle(origin, dir, corners[0], corners[1], corners[2], distance);
+}
+
+// runs on the simulation thread (the GL thread with --latency 0), so no GL in here
+void simulate_frame(void *context, render_snapshot *snapshot) {
+  scene *current = context;
+  glm_mat4_copy(current->view_projection, snapshot->view_projection);
+  draw_packet packet = current->packet;
+
+  if (num_draws == 0) {
+    glm_mat4_copy(current->mvp, packet.transform);
+    render_queue_push(&snapshot->queue, render_queue_make_key(0, 0, packet.program, 0, 0.0f), &packet);
+    return;
+  }
+
+  uint32_t *draw_visible = arena_alloc(&snapshot->memory, num_draws * sizeof(uint32_t), 64);
+  if (!draw_visible) {
+    return;
+  }
+
+  vec4 planes[6];
+  glm_frustum_planes(snapshot->view_projection, planes);
+  int visible = cull_frustum(&engine.culler, &draw_bounds, planes, draw_visible);
+
+  for (int v = 0; v < visible; v++) {
+    mat4 *draw_mvp = ecs_get(&engine.world, draw_entities[draw_visible[v]], draw_mvp_component);
+    glm_mat4_copy(*draw_mvp, packet.transform);
+    // clip space depth of the triangle's origin
+    float depth = 0.5f + 0.5f * (*draw_mvp)[3][2] / (*draw_mvp)[3][3];
+    if (render_queue_push(&snapshot->queue, render_queue_make_key(0, 0, packet.program, 0, depth), &packet) != 0) {
+      return;
+    }
+  }
+}
+
+// casts a ray from the cursor through the scene and reports the draw it hits first
+void pick_draw(mat4 view_projection) {
+  // the cursor is in screen coordinates, the viewport in pixels
+  int width, height;
+  glfwGetWindowSize(window, &width, &height);
+  float x = cursor_x * window_width / width;
+  float y = window_height - cursor_y * window_height / height;
+
+  vec4 viewport = {0.0f, 0.0f, window_width, window_height};
+  vec3 near_point, far_point, dir;
+  glm_unproject((vec3){x, y, 0.0f}, view_projection, viewport, near_point);
+  glm_unproject((vec3){x, y, 1.0f}, view_projection, viewport, far_point);
+  glm_vec3_sub(far_point, near_point, dir);
+  float length = glm_vec3_norm(dir);
+  glm_vec3_scale(dir, 1.0f / length, dir);
+
+  float distance;
+  int draw = bvh_raycast(&draw_tree, near_point, dir, length, pick_test, NULL, &distance);
+  if (draw >= 0) {
+    printf("Picked draw %i at distance %f.\n", draw, distance);
+  } else {
+    printf("Nothing under the cursor.\n");
+  }
+}
+
+void init() {
+  if (headless) {
+    init_headless();
+  } else {
+    init_window();
+  }
 
   printf("Renderer: %s.\n", glGetString(GL_RENDERER));
   printf("OpenGL version supported %s.\n", glGetString(GL_VERSION));
 
+  gl_state_invalidate();
+
   glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
   glGenVertexArrays(1, &vao);
-  glBindVertexArray(vao);
+  gl_state_bind_vertex_array(vao);
 
   float points[] = {
     -1.0f, -1.0f, 0.0f,
@@ -125,58 +526,82 @@ void init() {
   };
 
   glGenBuffers(1, &vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, sizeof(points), points, GL_STATIC_DRAW);
 
-  vs_src = read_file("src/shaders/main.vert");
-  fs_src = read_file("src/shaders/main.frag");
-
-  vs = compile_shader(vs_src, GL_VERTEX_SHADER);
-  fs = compile_shader(fs_src, GL_FRAGMENT_SHADER);
-
-  shader_program = glCreateProgram();
+  // the VAO remembers this, so it never has to be set again
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, NULL);
 
-  glAttachShader(shader_program, vs);
-  glAttachShader(shader_program, fs);
+  if (engine_init(&engine) != 0) {
+    die(1);
+  }
 
-  glLinkProgram(shader_program);
+  printf("Math kernels: %s.\n", simd_level_name(simd_current()));
 
-  int is_linked = 0;
-  glGetProgramiv(shader_program, GL_LINK_STATUS, &is_linked);
-  if (is_linked == GL_FALSE) {
-    int max_len = 2048;
-    char log[max_len];
+  load_source("src/shaders/main.vert", &vs_file);
+  load_source("src/shaders/main.frag", &fs_file);
 
-    glGetProgramInfoLog(shader_program, max_len, NULL, log);
+  // everything is submitted before anything is waited on
+  program_handle main_handle = shader_pipeline_submit(&engine.shaders, vs_file.data, fs_file.data, NULL);
 
-    printf("ERROR: could not link shader program.\n%s\n", log);
+  if (num_instances > 0) {
+    init_instances();
+  }
 
+  // the plain program is the fallback for everything else, so it has to exist
+  // before the first frame
+  shader_program = shader_pipeline_wait(&engine.shaders, main_handle);
+  if (!shader_program) {
     die(1);
   }
 
-  glValidateProgram(shader_program);
+  program_cache *programs = &engine.programs;
+  printf("Shader programs: %lu from cache, %lu compiled, %lu stale binaries rejected.\n",
+         programs->hits, programs->misses, programs->rejected);
 
-  int is_validated = 0;
-  glGetProgramiv(shader_program, GL_VALIDATE_STATUS, &is_validated);
+  gl_state_use_program(shader_program);
 
-  if (is_validated == GL_FALSE) {
-    int max_len = 2048;
-    char log[max_len];
-
-    glGetProgramInfoLog(shader_program, max_len, NULL, log);
+  if (benchmarking) {
+    bench_init();
+  }
+}
 
-    printf("ERROR: validation of shader program failed.\n%s\n", log);
+void usage(const char *program) {
+  fprintf(stderr, "usage: %s [--headless] [--bench FRAMES | --bench-time SECONDS] [--bench-out FILE.json|FILE.csv] [--instances N | --draws N] [--latency FRAMES]\n", program);
+  exit(1);
+}
 
-    die(1);
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--headless") == 0) {
+      headless = 1;
+    } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+      bench_frames = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--bench-time") == 0 && i + 1 < argc) {
+      bench_seconds = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--bench-out") == 0 && i + 1 < argc) {
+      bench_out = argv[++i];
+    } else if (strcmp(argv[i], "--instances") == 0 && i + 1 < argc) {
+      num_instances = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--draws") == 0 && i + 1 < argc) {
+      num_draws = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc) {
+      pipeline_latency = atoi(argv[++i]);
+    } else {
+      usage(argv[0]);
+    }
   }
 
-  glUseProgram(shader_program);
-}
+  if (bench_frames < 0 || bench_seconds < 0.0 || num_instances < 0 || num_draws < 0 ||
+      pipeline_latency < 0 || pipeline_latency > FRAME_PIPELINE_MAX_LATENCY || (bench_out && !bench_frames && !bench_seconds)) {
+    usage(argv[0]);
+  }
+  benchmarking = bench_frames > 0 || bench_seconds > 0.0;
 
-int main() {
   init();
 
-  mat4 projection, view, model, mvp;
+  mat4 projection, view, model, mvp, view_projection;
   vec3 pos, target, up;
 
   glm_vec3_make((float []){-3.0f, 0.0f, 1.0f}, pos);
@@ -188,6 +613,7 @@ int main() {
   glm_mat4_identity(model);
 
   glm_mat4_mulN((mat4 *[]){&projection, &view, &model}, 3, mvp);
+  glm_mat4_mul(projection, view, view_projection);
 
   print_mat4(view);
   printf("\n");
@@ -202,30 +628,85 @@ int main() {
     die(1);
   }
 
-  while (!glfwWindowShouldClose(window)) {
-    glfwPollEvents();
-    if (GLFW_PRESS == glfwGetKey(window, GLFW_KEY_ESCAPE)) {
-      glfwSetWindowShouldClose(window, 1);
-    }
+  if (num_draws > 0) {
+    init_draws(view_projection);
+  }
+
+  // shows the placeholder until the workers are done with it
+  texture_handle albedo = texture_load(&engine.textures, "assets/dev_texture.png");
+
+  glm_mat4_copy(view_projection, sim_scene.view_projection);
+  glm_mat4_copy(mvp, sim_scene.mvp);
+  sim_scene.packet = (draw_packet){
+    .program = shader_program,
+    .vao = vao,
+    // the GL name stays the same once the image arrives
+    .texture = texture_gl_name(&engine.textures, albedo),
+    .transform_loc = mvp_loc,
+    .mode = GL_TRIANGLES,
+    .count = 3
+  };
+  size_t frame_memory = FRAME_MEMORY + num_draws * sizeof(uint32_t);
+  if (frame_pipeline_init(&pipeline, pipeline_latency, frame_memory, &engine.jobs, simulate_frame, &sim_scene) != 0) {
+    die(1);
+  }
 
-    glfwGetFramebufferSize(window, &window_width, &window_height);
-    glViewport(0, 0, window_width, window_height);
+  while (!should_close()) {
+    bench_begin_frame();
+    gl_state_begin_frame();
 
-    glClear(GL_COLOR_BUFFER_BIT);
+    poll_events();
+    bench_mark(phase_events);
+
+    render_snapshot *snapshot = frame_pipeline_acquire(&pipeline);
+    frame_memory_used = snapshot->memory.allocated;
+    if (snapshot->memory.high_water > frame_memory_high_water) {
+      frame_memory_high_water = snapshot->memory.high_water;
+    }
+    if (pick_requested && num_draws > 0) {
+      pick_draw(snapshot->view_projection);
+    }
+    pick_requested = 0;
+    bench_mark(phase_snapshot);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    gl_state_viewport(0, 0, window_width, window_height);
 
-    glEnableVertexAttribArray(0);
+    glClear(GL_COLOR_BUFFER_BIT);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, NULL);
+    if (num_instances > 0 && !instanced_program) {
+      check_instanced_program();
+    }
 
-    glUniformMatrix4fv(mvp_loc, 1, GL_FALSE, &mvp[0][0]);
+    if (instanced_program) {
+      // re-sent every frame like any moving props would be
+      if (instance_buffer_upload(&instances, &engine.stream, instance_models, num_instances) != 0) {
+        die(1);
+      }
+      draw_packet packet = sim_scene.packet;
+      packet.program = instanced_program;
+      packet.vao = instances.vao;
+      packet.transform_loc = view_projection_loc;
+      packet.instance_count = instances.count;
+      glm_mat4_copy(snapshot->view_projection, packet.transform);
+      render_queue_push(&engine.queue, render_queue_make_key(0, 0, instanced_program, 0, 0.0f), &packet);
+    } else {
+      render_queue_execute(&snapshot->queue);
+      scene_queue_stats = snapshot->queue.last_stats;
+    }
+    frame_pipeline_release(&pipeline);
 
-    glDrawArrays(GL_TRIANGLES, 0, 3);
+    engine_draw(&engine);
+    bench_mark(phase_draw);
 
-    glDisableVertexAttribArray(0);
+    swap_buffers();
+    bench_mark(phase_swap);
 
-    glfwSwapBuffers(window);
+    if (bench_end_frame()) {
+      // stopped first, since the report reads stats the simulation writes
+      frame_pipeline_free(&pipeline);
+      bench_report();
+      break;
+    }
   }
 
   die(0);
@@ -0,0 +1,44 @@
+#include "math/batch.h"
+
+#include "math/simd.h"
+
+
+void batch_mat4_mul(mat4 *a, mat4 *b, mat4 *dest, int count) {
+  simd.mat4_mul((const float *)a, (const float *)b, (float *)dest, count);
+}
+
+void batch_mat4_inv(mat4 *m, mat4 *dest, int count) {
+  simd.mat4_inv((const float *)m, (float *)dest, count);
+}
+
+void batch_mat4_mulv(mat4 *m, vec4 *v, vec4 *dest, int count) {
+  simd.mat4_mulv((const float *)m, (const float *)v, (float *)dest, count);
+}
+
+void batch_transform_vec4(mat4 m, const vec4 *in, vec4 *out, int count) {
+  simd.transform4((const float *)m, (const float *)in, (float *)out, count);
+}
+
+void batch_transform_points(mat4 m, const vec3 *in, vec3 *out, int count) {
+  simd.transform3((const float *)m, (const float *)in, (float *)out, count, 1.0f);
+}
+
+void batch_transform_dirs(mat4 m, const vec3 *in, vec3 *out, int count) {
+  simd.transform3((const float *)m, (const float *)in, (float *)out, count, 0.0f);
+}
+
+void batch_transform_points_soa(mat4 m, const float *const in[3], float *const out[3], int count) {
+  simd.transform3_soa((const float *)m, in, out, count, 1.0f);
+}
+
+void batch_transform_dirs_soa(mat4 m, const float *const in[3], float *const out[3], int count) {
+  simd.transform3_soa((const float *)m, in, out, count, 0.0f);
+}
+
+void batch_aabb_transform(vec3 (*boxes)[2], mat4 *m, vec3 (*dest)[2], int count) {
+  simd.aabb_transform((const float *)boxes, (const float *)m, (float *)dest, count);
+}
+
+void batch_sphere_transform(vec4 *spheres, mat4 *m, vec4 *dest, int count) {
+  simd.sphere_transform((const float *)spheres, (const float *)m, (float *)dest, count);
+}
@@ -0,0 +1,40 @@
+#include "math/simd.h"
+
+#include <string.h>
+
+// Built once per instruction set, see math/simd.h. The local copies give the
+// matrices the alignment this copy's mat4 type promises. Pairs go through the
+// two-at-a-time cglm functions, which use the full AVX width.
+
+
+void SIMD_VARIANT(batch_mat4_mul)(const float *a, const float *b, float *dest, int count) {
+  mat4 ma[2], mb[2], md[2];
+  int i = 0;
+  for (; i + 2 <= count; i += 2) {
+    memcpy(ma, a + 16 * i, sizeof(ma));
+    memcpy(mb, b + 16 * i, sizeof(mb));
+    glm_mat4_mul2(ma, mb, md);
+    memcpy(dest + 16 * i, md, sizeof(md));
+  }
+  if (i < count) {
+    memcpy(ma[0], a + 16 * i, sizeof(mat4));
+    memcpy(mb[0], b + 16 * i, sizeof(mat4));
+    glm_mat4_mul(ma[0], mb[0], md[0]);
+    memcpy(dest + 16 * i, md[0], sizeof(mat4));
+  }
+}
+
+void SIMD_VARIANT(batch_mat4_inv)(const float *m, float *dest, int count) {
+  mat4 mm[2], md[2];
+  int i = 0;
+  for (; i + 2 <= count; i += 2) {
+    memcpy(mm, m + 16 * i, sizeof(mm));
+    glm_mat4_inv2(mm, md);
+    memcpy(dest + 16 * i, md, sizeof(md));
+  }
+  if (i < count) {
+    memcpy(mm[0], m + 16 * i, sizeof(mat4));
+    glm_mat4_inv(mm[0], md[0]);
+    memcpy(dest + 16 * i, md[0], sizeof(mat4));
+  }
+}
@@ -0,0 +1,118 @@
+#include <math.h>
+
+#include "math/simd.h"
+
+#include "math/vfloat.h"
+
+// Bulk bounding volume transforms, one copy per SIMD level. Each lane handles
+// one volume and its own matrix, both transposed in with vf_load4t. Matrices
+// are 16 floats, boxes 6 (min then max) and spheres 4 (center then radius).
+
+
+// Arvo's method, as glm_aabb_transform(): each world axis starts at the
+// translation and adds the smaller (or larger) of the two products per column
+static inline void aabb_scalar(const float *box, const float *m, float *dest) {
+  float out[6];
+  for (int r = 0; r < 3; r++) {
+    float lo = m[12 + r], hi = m[12 + r];
+    for (int c = 0; c < 3; c++) {
+      float a = m[4 * c + r] * box[c], b = m[4 * c + r] * box[3 + c];
+      lo += fminf(a, b);
+      hi += fmaxf(a, b);
+    }
+    out[r] = lo;
+    out[3 + r] = hi;
+  }
+  for (int k = 0; k < 6; k++) {
+    dest[k] = out[k];
+  }
+}
+
+// one column's contribution to a world axis: the smaller and larger of the
+// column element times the box's min and max along that column's axis
+static inline void arvo_term(vfloat m, vfloat box_min, vfloat box_max, vfloat *lo, vfloat *hi) {
+  vfloat a = vf_mul(m, box_min), b = vf_mul(m, box_max);
+  *lo = vf_add(*lo, vf_min(a, b));
+  *hi = vf_add(*hi, vf_max(a, b));
+}
+
+// written out rather than looped, see math/vfloat.h
+void SIMD_VARIANT(batch_aabb_transform)(const float *boxes, const float *m, float *dest, int count) {
+  int i = 0;
+  for (; i + VF_WIDTH <= count; i += VF_WIDTH) {
+    const float *mat = m + 16 * i;
+    vfloat c0[4], c1[4], c2[4], c3[4], a[4], b[4];
+    vf_load4t(mat, 16, c0);
+    vf_load4t(mat + 4, 16, c1);
+    vf_load4t(mat + 8, 16, c2);
+    vf_load4t(mat + 12, 16, c3);
+    // min x y z, max x, then min z, max x y z
+    vf_load4t(boxes + 6 * i, 6, a);
+    vf_load4t(boxes + 6 * i + 2, 6, b);
+
+    vfloat lo_x = c3[0], hi_x = c3[0], lo_y = c3[1], hi_y = c3[1], lo_z = c3[2], hi_z = c3[2];
+    arvo_term(c0[0], a[0], b[1], &lo_x, &hi_x);
+    arvo_term(c1[0], a[1], b[2], &lo_x, &hi_x);
+    arvo_term(c2[0], a[2], b[3], &lo_x, &hi_x);
+    arvo_term(c0[1], a[0], b[1], &lo_y, &hi_y);
+    arvo_term(c1[1], a[1], b[2], &lo_y, &hi_y);
+    arvo_term(c2[1], a[2], b[3], &lo_y, &hi_y);
+    arvo_term(c0[2], a[0], b[1], &lo_z, &hi_z);
+    arvo_term(c1[2], a[1], b[2], &lo_z, &hi_z);
+    arvo_term(c2[2], a[2], b[3], &lo_z, &hi_z);
+
+    // the two stores overlap on min z and max x, which both write the same
+    float *d = dest + 6 * i;
+    vf_store4t(d, 6, (vfloat[4]){lo_x, lo_y, lo_z, hi_x});
+    vf_store4t(d + 2, 6, (vfloat[4]){lo_z, hi_x, hi_y, hi_z});
+  }
+
+  for (; i < count; i++) {
+    aabb_scalar(boxes + 6 * i, m + 16 * i, dest + 6 * i);
+  }
+}
+
+// the center goes through the matrix, the radius scales by the longest of the
+// three axes so the sphere still holds the object under non-uniform scale
+static inline void sphere_scalar(const float *s, const float *m, float *dest) {
+  float x = s[0], y = s[1], z = s[2], scale = 0.0f;
+  for (int c = 0; c < 3; c++) {
+    const float *axis = m + 4 * c;
+    scale = fmaxf(scale, axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+  }
+  float radius = s[3] * sqrtf(scale);
+  for (int r = 0; r < 3; r++) {
+    dest[r] = m[r] * x + m[4 + r] * y + m[8 + r] * z + m[12 + r];
+  }
+  dest[3] = radius;
+}
+
+static inline vfloat length2(const vfloat c[4]) {
+  return vf_fmadd(c[2], c[2], vf_fmadd(c[1], c[1], vf_mul(c[0], c[0])));
+}
+
+void SIMD_VARIANT(batch_sphere_transform)(const float *spheres, const float *m, float *dest, int count) {
+  int i = 0;
+  for (; i + VF_WIDTH <= count; i += VF_WIDTH) {
+    const float *mat = m + 16 * i;
+    vfloat c0[4], c1[4], c2[4], c3[4], s[4];
+    vf_load4t(mat, 16, c0);
+    vf_load4t(mat + 4, 16, c1);
+    vf_load4t(mat + 8, 16, c2);
+    vf_load4t(mat + 12, 16, c3);
+    vf_load4t(spheres + 4 * i, 4, s);
+
+    vfloat scale = vf_max(length2(c0), vf_max(length2(c1), length2(c2)));
+    vfloat out[4] = {
+      vf_fmadd(c2[0], s[2], vf_fmadd(c1[0], s[1], vf_fmadd(c0[0], s[0], c3[0]))),
+      vf_fmadd(c2[1], s[2], vf_fmadd(c1[1], s[1], vf_fmadd(c0[1], s[0], c3[1]))),
+      vf_fmadd(c2[2], s[2], vf_fmadd(c1[2], s[1], vf_fmadd(c0[2], s[0], c3[2]))),
+      vf_mul(s[3], vf_sqrt(scale)),
+    };
+    vf_store4t(dest + 4 * i, 4, out);
+  }
+
+  for (; i < count; i++) {
+    sphere_scalar(spheres + 4 * i, m + 16 * i, dest + 4 * i);
+  }
+}
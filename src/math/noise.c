@@ -0,0 +1,107 @@
+#include "math/noise.h"
+
+#include <string.h>
+#include "math/simd.h"
+#include "utils/parallel.h"
+
+// points go through the kernels this many at a time, split into x, y and z
+// arrays on the stack
+#define NOISE_CHUNK 256
+
+typedef void (*noise_kernel)(const float *const in[3], float *out, int count, float frequency, float amplitude);
+
+typedef struct {
+  const noise_params *params;
+  int dims;
+  float origin[3];
+  float spacing;
+  int width, height;
+  float *out;
+} noise_grid;
+
+
+static noise_kernel pick_kernel(noise_type type, int dims) {
+  if (type == NOISE_SIMPLEX) {
+    return dims == 2 ? simd.noise_simplex2 : simd.noise_simplex3;
+  }
+  return dims == 2 ? simd.noise_perlin2 : simd.noise_perlin3;
+}
+
+// out = every octave summed, one kernel pass each
+static void fbm(const noise_params *params, int dims, const float *const in[3], float *out, int count) {
+  noise_kernel kernel = pick_kernel(params->type, dims);
+  int octaves = params->octaves > 0 ? params->octaves : 1;
+
+  float total = 0.0f, weight = 1.0f;
+  for (int k = 0; k < octaves; k++) {
+    total += weight;
+    weight *= params->gain;
+  }
+
+  memset(out, 0, count * sizeof(float));
+  float frequency = params->frequency, amplitude = 1.0f / total;
+  for (int k = 0; k < octaves; k++) {
+    kernel(in, out, count, frequency, amplitude);
+    frequency *= params->lacunarity;
+    amplitude *= params->gain;
+  }
+}
+
+void noise_points2(const noise_params *params, const vec2 *points, float *out, int count) {
+  float x[NOISE_CHUNK], y[NOISE_CHUNK];
+  const float *const in[3] = {x, y, y};
+  for (int begin = 0; begin < count; begin += NOISE_CHUNK) {
+    int n = count - begin < NOISE_CHUNK ? count - begin : NOISE_CHUNK;
+    for (int i = 0; i < n; i++) {
+      x[i] = points[begin + i][0];
+      y[i] = points[begin + i][1];
+    }
+    fbm(params, 2, in, out + begin, n);
+  }
+}
+
+void noise_points3(const noise_params *params, const vec3 *points, float *out, int count) {
+  float x[NOISE_CHUNK], y[NOISE_CHUNK], z[NOISE_CHUNK];
+  const float *const in[3] = {x, y, z};
+  for (int begin = 0; begin < count; begin += NOISE_CHUNK) {
+    int n = count - begin < NOISE_CHUNK ? count - begin : NOISE_CHUNK;
+    for (int i = 0; i < n; i++) {
+      x[i] = points[begin + i][0];
+      y[i] = points[begin + i][1];
+      z[i] = points[begin + i][2];
+    }
+    fbm(params, 3, in, out + begin, n);
+  }
+}
+
+// rows begin to end, numbered through every slice of a 3D grid
+static void fill_rows(void *context, long begin, long end) {
+  const noise_grid *grid = context;
+  float x[NOISE_CHUNK], y[NOISE_CHUNK], z[NOISE_CHUNK];
+  const float *const in[3] = {x, y, z};
+  for (long row = begin; row < end; row++) {
+    float row_y = grid->origin[1] + (row % grid->height) * grid->spacing;
+    float row_z = grid->origin[2] + (row / grid->height) * grid->spacing;
+    for (int first = 0; first < grid->width; first += NOISE_CHUNK) {
+      int n = grid->width - first < NOISE_CHUNK ? grid->width - first : NOISE_CHUNK;
+      for (int i = 0; i < n; i++) {
+        x[i] = grid->origin[0] + (first + i) * grid->spacing;
+        y[i] = row_y;
+        z[i] = row_z;
+      }
+      fbm(grid->params, grid->dims, in, grid->out + row * grid->width + first, n);
+    }
+  }
+}
+
+void noise_grid2(const noise_params *params, vec2 origin, float spacing, int width, int height, float *out,
+                 int num_threads) {
+  noise_grid grid = {params, 2, {origin[0], origin[1], 0.0f}, spacing, width, height, out};
+  parallel_range(height, 1, num_threads, fill_rows, &grid);
+}
+
+void noise_grid3(const noise_params *params, vec3 origin, float spacing, int width, int height, int depth, float *out,
+                 int num_threads) {
+  noise_grid grid = {params, 3, {origin[0], origin[1], origin[2]}, spacing, width, height, out};
+  parallel_range((long)height * depth, 1, num_threads, fill_rows, &grid);
+}
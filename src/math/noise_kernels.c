@@ -0,0 +1,262 @@
+#include <string.h>
+
+#include "math/simd.h"
+
+#include "math/vfloat.h"
+
+// Gradient noise, one point per lane and one copy per SIMD level. Perlin
+// repeats glm_perlin_vec2/vec3 operation for operation so the results agree
+// up to FMA rounding; simplex is the webgl-noise version by Ashima Arts and
+// Stefan Gustavson, built from the same permutation polynomial. Each kernel
+// adds amplitude * noise(frequency * p) to out, which is how fBm stacks
+// octaves. Everything is written out per corner (see math/vfloat.h).
+
+typedef void (*noise_kernel)(vfloat x, vfloat y, vfloat z, vfloat *out);
+
+
+// glm__noiseDetail_mod289: floor based, so negative inputs wrap to 0..288
+static inline vfloat mod289(vfloat x) {
+  return vf_sub(x, vf_mul(vf_floor(vf_mul(x, vf_set1(1.0f / 289.0f))), vf_set1(289.0f)));
+}
+
+// glm_vec3_mods(), which is fmodf and keeps the sign. Exact for whole numbers
+// below 2^23.
+static inline vfloat fmod289(vfloat x) {
+  return vf_sub(x, vf_mul(vf_trunc(vf_div(x, vf_set1(289.0f))), vf_set1(289.0f)));
+}
+
+static inline vfloat permute(vfloat x) {
+  return mod289(vf_mul(vf_add(vf_mul(x, vf_set1(34.0f)), vf_set1(1.0f)), x));
+}
+
+static inline vfloat fade(vfloat t) {
+  vfloat cube = vf_mul(vf_mul(t, t), t);
+  vfloat d = vf_sub(vf_mul(t, vf_set1(6.0f)), vf_set1(15.0f));
+  return vf_mul(cube, vf_add(vf_mul(t, d), vf_set1(10.0f)));
+}
+
+static inline vfloat taylor_inv_sqrt(vfloat x) {
+  return vf_sub(vf_set1(1.79284291400159f), vf_mul(x, vf_set1(0.85373472095314f)));
+}
+
+static inline vfloat lerp(vfloat from, vfloat to, vfloat t) {
+  return vf_add(from, vf_mul(t, vf_sub(to, from)));
+}
+
+// glm__noiseDetail_i2gxy for one corner, then gradNorm and the dot product
+static inline vfloat perlin2_corner(vfloat i, vfloat fx, vfloat fy) {
+  vfloat gx = vf_sub(vf_mul(vf_fract(vf_div(i, vf_set1(41.0f))), vf_set1(2.0f)), vf_set1(1.0f));
+  vfloat gy = vf_sub(vf_abs(gx), vf_set1(0.5f));
+  gx = vf_sub(gx, vf_floor(vf_add(gx, vf_set1(0.5f))));
+
+  vfloat norm = taylor_inv_sqrt(vf_add(vf_mul(gx, gx), vf_mul(gy, gy)));
+  return vf_add(vf_mul(vf_mul(gx, norm), fx), vf_mul(vf_mul(gy, norm), fy));
+}
+
+static void perlin2(vfloat x, vfloat y, vfloat z, vfloat *out) {
+  (void)z;
+  vfloat i0x = vf_floor(x), i0y = vf_floor(y);
+  vfloat i1x = fmod289(vf_add(i0x, vf_set1(1.0f))), i1y = fmod289(vf_add(i0y, vf_set1(1.0f)));
+  i0x = fmod289(i0x);
+  i0y = fmod289(i0y);
+  vfloat f0x = vf_fract(x), f0y = vf_fract(y);
+  vfloat f1x = vf_sub(f0x, vf_set1(1.0f)), f1y = vf_sub(f0y, vf_set1(1.0f));
+
+  vfloat px0 = permute(i0x), px1 = permute(i1x);
+  vfloat n00 = perlin2_corner(permute(vf_add(px0, i0y)), f0x, f0y);
+  vfloat n10 = perlin2_corner(permute(vf_add(px1, i0y)), f1x, f0y);
+  vfloat n01 = perlin2_corner(permute(vf_add(px0, i1y)), f0x, f1y);
+  vfloat n11 = perlin2_corner(permute(vf_add(px1, i1y)), f1x, f1y);
+
+  vfloat fade_x = fade(f0x), fade_y = fade(f0y);
+  vfloat n = lerp(lerp(n00, n10, fade_x), lerp(n01, n11, fade_x), fade_y);
+  *out = vf_mul(n, vf_set1(2.3f));
+}
+
+// glm__noiseDetail_i2gxyz for one corner, then gradNorm and the dot product
+static inline vfloat perlin3_corner(vfloat i, vfloat fx, vfloat fy, vfloat fz) {
+  vfloat gx = vf_mul(i, vf_set1(1.0f / 7.0f));
+  vfloat gy = vf_sub(vf_fract(vf_mul(vf_floor(gx), vf_set1(1.0f / 7.0f))), vf_set1(0.5f));
+  gx = vf_fract(gx);
+  vfloat gz = vf_sub(vf_sub(vf_set1(0.5f), vf_abs(gx)), vf_abs(gy));
+
+  vfloat zero = vf_set1(0.0f), half = vf_set1(0.5f);
+  vfloat sz = vf_step(gz, zero);
+  gx = vf_sub(gx, vf_mul(sz, vf_sub(vf_step(zero, gx), half)));
+  gy = vf_sub(gy, vf_mul(sz, vf_sub(vf_step(zero, gy), half)));
+
+  vfloat norm = taylor_inv_sqrt(vf_add(vf_add(vf_mul(gx, gx), vf_mul(gy, gy)), vf_mul(gz, gz)));
+  vfloat n = vf_mul(vf_mul(gx, norm), fx);
+  n = vf_add(n, vf_mul(vf_mul(gy, norm), fy));
+  return vf_add(n, vf_mul(vf_mul(gz, norm), fz));
+}
+
+static void perlin3(vfloat x, vfloat y, vfloat z, vfloat *out) {
+  vfloat i0x = vf_floor(x), i0y = vf_floor(y), i0z = vf_floor(z);
+  vfloat i1x = fmod289(vf_add(i0x, vf_set1(1.0f)));
+  vfloat i1y = fmod289(vf_add(i0y, vf_set1(1.0f)));
+  vfloat i1z = fmod289(vf_add(i0z, vf_set1(1.0f)));
+  i0x = fmod289(i0x);
+  i0y = fmod289(i0y);
+  i0z = fmod289(i0z);
+  vfloat f0x = vf_fract(x), f0y = vf_fract(y), f0z = vf_fract(z);
+  vfloat f1x = vf_sub(f0x, vf_set1(1.0f)), f1y = vf_sub(f0y, vf_set1(1.0f)), f1z = vf_sub(f0z, vf_set1(1.0f));
+
+  vfloat px0 = permute(i0x), px1 = permute(i1x);
+  vfloat h00 = permute(vf_add(px0, i0y)), h10 = permute(vf_add(px1, i0y));
+  vfloat h01 = permute(vf_add(px0, i1y)), h11 = permute(vf_add(px1, i1y));
+
+  vfloat n000 = perlin3_corner(permute(vf_add(h00, i0z)), f0x, f0y, f0z);
+  vfloat n100 = perlin3_corner(permute(vf_add(h10, i0z)), f1x, f0y, f0z);
+  vfloat n010 = perlin3_corner(permute(vf_add(h01, i0z)), f0x, f1y, f0z);
+  vfloat n110 = perlin3_corner(permute(vf_add(h11, i0z)), f1x, f1y, f0z);
+  vfloat n001 = perlin3_corner(permute(vf_add(h00, i1z)), f0x, f0y, f1z);
+  vfloat n101 = perlin3_corner(permute(vf_add(h10, i1z)), f1x, f0y, f1z);
+  vfloat n011 = perlin3_corner(permute(vf_add(h01, i1z)), f0x, f1y, f1z);
+  vfloat n111 = perlin3_corner(permute(vf_add(h11, i1z)), f1x, f1y, f1z);
+
+  vfloat fade_x = fade(f0x), fade_y = fade(f0y), fade_z = fade(f0z);
+  vfloat n00 = lerp(n000, n001, fade_z), n10 = lerp(n100, n101, fade_z);
+  vfloat n01 = lerp(n010, n011, fade_z), n11 = lerp(n110, n111, fade_z);
+  // z, then y, then x, the order glm_perlin_vec3 uses
+  vfloat n = lerp(lerp(n00, n01, fade_y), lerp(n10, n11, fade_y), fade_x);
+  *out = vf_mul(n, vf_set1(2.2f));
+}
+
+// one simplex corner: m^4 * dot(gradient, offset), the gradient from 41
+// points on a line folded into a diamond
+static inline vfloat simplex2_corner(vfloat p, vfloat dx, vfloat dy) {
+  vfloat m = vf_max(vf_sub(vf_set1(0.5f), vf_add(vf_mul(dx, dx), vf_mul(dy, dy))), vf_set1(0.0f));
+  m = vf_mul(m, m);
+  m = vf_mul(m, m);
+
+  vfloat x = vf_sub(vf_mul(vf_fract(vf_mul(p, vf_set1(1.0f / 41.0f))), vf_set1(2.0f)), vf_set1(1.0f));
+  vfloat h = vf_sub(vf_abs(x), vf_set1(0.5f));
+  vfloat a = vf_sub(x, vf_floor(vf_add(x, vf_set1(0.5f))));
+  m = vf_mul(m, taylor_inv_sqrt(vf_add(vf_mul(a, a), vf_mul(h, h))));
+  return vf_mul(m, vf_add(vf_mul(a, dx), vf_mul(h, dy)));
+}
+
+static void simplex2(vfloat x, vfloat y, vfloat z, vfloat *out) {
+  (void)z;
+  const float skew = 0.366025403784439f, unskew = 0.211324865405187f;
+  vfloat s = vf_mul(vf_add(x, y), vf_set1(skew));
+  vfloat ix = vf_floor(vf_add(x, s)), iy = vf_floor(vf_add(y, s));
+  vfloat t = vf_mul(vf_add(ix, iy), vf_set1(unskew));
+  vfloat x0 = vf_add(vf_sub(x, ix), t), y0 = vf_add(vf_sub(y, iy), t);
+
+  // the middle corner steps along x in the lower triangle, y in the upper
+  vfloat one = vf_set1(1.0f);
+  vfloat i1x = vf_sub(one, vf_step(x0, y0)), i1y = vf_sub(one, i1x);
+  vfloat x1 = vf_sub(vf_add(x0, vf_set1(unskew)), i1x), y1 = vf_sub(vf_add(y0, vf_set1(unskew)), i1y);
+  vfloat x2 = vf_add(x0, vf_set1(-0.577350269189626f)), y2 = vf_add(y0, vf_set1(-0.577350269189626f));
+
+  ix = mod289(ix);
+  iy = mod289(iy);
+  vfloat p0 = permute(vf_add(permute(iy), ix));
+  vfloat p1 = permute(vf_add(vf_add(permute(vf_add(iy, i1y)), ix), i1x));
+  vfloat p2 = permute(vf_add(vf_add(permute(vf_add(iy, one)), ix), one));
+
+  vfloat n = vf_add(vf_add(simplex2_corner(p0, x0, y0), simplex2_corner(p1, x1, y1)), simplex2_corner(p2, x2, y2));
+  *out = vf_mul(n, vf_set1(130.0f));
+}
+
+// one simplex corner: the gradient from a 7x7 grid on an octahedron's faces
+static inline vfloat simplex3_corner(vfloat p, vfloat dx, vfloat dy, vfloat dz) {
+  vfloat j = vf_sub(p, vf_mul(vf_set1(49.0f), vf_floor(vf_mul(p, vf_set1(1.0f / 49.0f)))));
+  vfloat gx = vf_floor(vf_mul(j, vf_set1(1.0f / 7.0f)));
+  vfloat gy = vf_floor(vf_sub(j, vf_mul(vf_set1(7.0f), gx)));
+  gx = vf_add(vf_mul(gx, vf_set1(2.0f / 7.0f)), vf_set1(0.5f / 7.0f - 1.0f));
+  gy = vf_add(vf_mul(gy, vf_set1(2.0f / 7.0f)), vf_set1(0.5f / 7.0f - 1.0f));
+  vfloat gz = vf_sub(vf_sub(vf_set1(1.0f), vf_abs(gx)), vf_abs(gy));
+
+  // below the equator fold x and y back towards the nearest edge
+  vfloat zero = vf_set1(0.0f), one = vf_set1(1.0f), two = vf_set1(2.0f);
+  vfloat below = vf_step(gz, zero);
+  gx = vf_sub(gx, vf_mul(vf_add(vf_mul(vf_floor(gx), two), one), below));
+  gy = vf_sub(gy, vf_mul(vf_add(vf_mul(vf_floor(gy), two), one), below));
+
+  vfloat norm = taylor_inv_sqrt(vf_add(vf_add(vf_mul(gx, gx), vf_mul(gy, gy)), vf_mul(gz, gz)));
+  vfloat m = vf_sub(vf_set1(0.6f), vf_add(vf_add(vf_mul(dx, dx), vf_mul(dy, dy)), vf_mul(dz, dz)));
+  m = vf_max(m, zero);
+  m = vf_mul(m, m);
+  m = vf_mul(m, m);
+  vfloat d = vf_add(vf_add(vf_mul(gx, dx), vf_mul(gy, dy)), vf_mul(gz, dz));
+  return vf_mul(m, vf_mul(d, norm));
+}
+
+static void simplex3(vfloat x, vfloat y, vfloat z, vfloat *out) {
+  const float skew = 1.0f / 3.0f, unskew = 1.0f / 6.0f;
+  vfloat s = vf_mul(vf_add(vf_add(x, y), z), vf_set1(skew));
+  vfloat ix = vf_floor(vf_add(x, s)), iy = vf_floor(vf_add(y, s)), iz = vf_floor(vf_add(z, s));
+  vfloat t = vf_mul(vf_add(vf_add(ix, iy), iz), vf_set1(unskew));
+  vfloat x0 = vf_add(vf_sub(x, ix), t), y0 = vf_add(vf_sub(y, iy), t), z0 = vf_add(vf_sub(z, iz), t);
+
+  // which of the six tetrahedra: i1 steps along the largest offset, i2 along
+  // the two largest
+  vfloat one = vf_set1(1.0f);
+  vfloat gx = vf_step(y0, x0), gy = vf_step(z0, y0), gz = vf_step(x0, z0);
+  vfloat lx = vf_sub(one, gx), ly = vf_sub(one, gy), lz = vf_sub(one, gz);
+  vfloat i1x = vf_min(gx, lz), i1y = vf_min(gy, lx), i1z = vf_min(gz, ly);
+  vfloat i2x = vf_max(gx, lz), i2y = vf_max(gy, lx), i2z = vf_max(gz, ly);
+
+  vfloat c1 = vf_set1(unskew), c2 = vf_set1(skew), c3 = vf_set1(0.5f);
+  vfloat x1 = vf_add(vf_sub(x0, i1x), c1), y1 = vf_add(vf_sub(y0, i1y), c1), z1 = vf_add(vf_sub(z0, i1z), c1);
+  vfloat x2 = vf_add(vf_sub(x0, i2x), c2), y2 = vf_add(vf_sub(y0, i2y), c2), z2 = vf_add(vf_sub(z0, i2z), c2);
+  vfloat x3 = vf_sub(x0, c3), y3 = vf_sub(y0, c3), z3 = vf_sub(z0, c3);
+
+  ix = mod289(ix);
+  iy = mod289(iy);
+  iz = mod289(iz);
+  vfloat p0 = permute(vf_add(permute(vf_add(permute(iz), iy)), ix));
+  vfloat p1 = permute(vf_add(vf_add(permute(vf_add(vf_add(permute(vf_add(iz, i1z)), iy), i1y)), ix), i1x));
+  vfloat p2 = permute(vf_add(vf_add(permute(vf_add(vf_add(permute(vf_add(iz, i2z)), iy), i2y)), ix), i2x));
+  vfloat p3 = permute(vf_add(vf_add(permute(vf_add(vf_add(permute(vf_add(iz, one)), iy), one)), ix), one));
+
+  vfloat n = vf_add(simplex3_corner(p0, x0, y0, z0), simplex3_corner(p1, x1, y1, z1));
+  n = vf_add(n, vf_add(simplex3_corner(p2, x2, y2, z2), simplex3_corner(p3, x3, y3, z3)));
+  *out = vf_mul(n, vf_set1(42.0f));
+}
+
+// in[0..2] hold x, y and z (in[2] unused in 2D); the last partial vector goes
+// through zero padded copies so every lane runs the same code
+static inline void noise_run(noise_kernel kernel, const float *const in[3], float *out, int count, float frequency,
+                             float amplitude, int dims) {
+  vfloat f = vf_set1(frequency), a = vf_set1(amplitude), zero = vf_set1(0.0f);
+  int i = 0;
+  for (; i + VF_WIDTH <= count; i += VF_WIDTH) {
+    vfloat n;
+    kernel(vf_mul(vf_loadu(in[0] + i), f), vf_mul(vf_loadu(in[1] + i), f),
+           dims == 3 ? vf_mul(vf_loadu(in[2] + i), f) : zero, &n);
+    vf_storeu(out + i, vf_fmadd(n, a, vf_loadu(out + i)));
+  }
+
+  if (i < count) {
+    float pad[4][VF_WIDTH] = {{0.0f}};
+    int rest = count - i;
+    for (int k = 0; k < dims; k++) {
+      memcpy(pad[k], in[k] + i, rest * sizeof(float));
+    }
+    memcpy(pad[3], out + i, rest * sizeof(float));
+    vfloat n;
+    kernel(vf_mul(vf_loadu(pad[0]), f), vf_mul(vf_loadu(pad[1]), f), vf_mul(vf_loadu(pad[2]), f), &n);
+    vf_storeu(pad[3], vf_fmadd(n, a, vf_loadu(pad[3])));
+    memcpy(out + i, pad[3], rest * sizeof(float));
+  }
+}
+
+void SIMD_VARIANT(noise_perlin2)(const float *const in[3], float *out, int count, float frequency, float amplitude) {
+  noise_run(perlin2, in, out, count, frequency, amplitude, 2);
+}
+
+void SIMD_VARIANT(noise_perlin3)(const float *const in[3], float *out, int count, float frequency, float amplitude) {
+  noise_run(perlin3, in, out, count, frequency, amplitude, 3);
+}
+
+void SIMD_VARIANT(noise_simplex2)(const float *const in[3], float *out, int count, float frequency, float amplitude) {
+  noise_run(simplex2, in, out, count, frequency, amplitude, 2);
+}
+
+void SIMD_VARIANT(noise_simplex3)(const float *const in[3], float *out, int count, float frequency, float amplitude) {
+  noise_run(simplex3, in, out, count, frequency, amplitude, 3);
+}
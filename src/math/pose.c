@@ -0,0 +1,96 @@
+#include "math/pose.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "math/simd.h"
+#include "utils/parallel.h"
+
+typedef struct {
+  const pose *a, *b;
+  pose *out;
+  float t;
+  pose_blend_mode mode;
+} blend_job;
+
+typedef struct {
+  const pose *p;
+  mat4 *dest;
+} matrices_job;
+
+
+int pose_init(pose *p, int count) {
+  memset(p, 0, sizeof(*p));
+
+  int capacity = (count + POSE_BATCH - 1) / POSE_BATCH * POSE_BATCH;
+  if (capacity < POSE_BATCH) {
+    capacity = POSE_BATCH;
+  }
+
+  // one block for all ten arrays, each starting on a cache line
+  float *data = aligned_alloc(64, 10 * capacity * sizeof(float));
+  if (!data) {
+    fprintf(stderr, "ERROR: could not allocate memory for %i pose bones.\n", count);
+    return -1;
+  }
+
+  for (int k = 0; k < 4; k++) {
+    p->rotation[k] = data + k * capacity;
+  }
+  for (int k = 0; k < 3; k++) {
+    p->translation[k] = data + (4 + k) * capacity;
+    p->scale[k] = data + (7 + k) * capacity;
+  }
+  p->count = count;
+  p->capacity = capacity;
+
+  for (int i = 0; i < capacity; i++) {
+    pose_set(p, i, GLM_QUAT_IDENTITY, GLM_VEC3_ZERO, GLM_VEC3_ONE);
+  }
+  return 0;
+}
+
+void pose_free(pose *p) {
+  free(p->rotation[0]);
+  memset(p, 0, sizeof(*p));
+}
+
+void pose_set(pose *p, int bone, versor rotation, vec3 translation, vec3 scale) {
+  for (int k = 0; k < 4; k++) {
+    p->rotation[k][bone] = rotation[k];
+  }
+  for (int k = 0; k < 3; k++) {
+    p->translation[k][bone] = translation[k];
+    p->scale[k][bone] = scale[k];
+  }
+}
+
+void pose_get(const pose *p, int bone, versor rotation, vec3 translation, vec3 scale) {
+  for (int k = 0; k < 4; k++) {
+    rotation[k] = p->rotation[k][bone];
+  }
+  for (int k = 0; k < 3; k++) {
+    translation[k] = p->translation[k][bone];
+    scale[k] = p->scale[k][bone];
+  }
+}
+
+static void blend_range(void *context, long begin, long end) {
+  const blend_job *job = context;
+  simd.pose_blend_range(job->a, job->b, job->out, begin, end, job->t, job->mode);
+}
+
+void pose_blend(const pose *a, const pose *b, float t, pose_blend_mode mode, pose *out, int num_threads) {
+  blend_job job = {a, b, out, t, mode};
+  parallel_range(out->count, POSE_BATCH, num_threads, blend_range, &job);
+}
+
+static void matrices_range(void *context, long begin, long end) {
+  const matrices_job *job = context;
+  simd.pose_matrices_range(job->p, (float *)job->dest, begin, end);
+}
+
+void pose_matrices(const pose *p, mat4 *dest, int num_threads) {
+  matrices_job job = {p, dest};
+  parallel_range(p->count, POSE_BATCH, num_threads, matrices_range, &job);
+}
@@ -0,0 +1,153 @@
+#include <string.h>
+
+#include "math/simd.h"
+
+#include "math/vfloat.h"
+
+// Pose blending and matrix building, one bone per lane and one copy per SIMD
+// level. Ranges start on a POSE_BATCH boundary and may run on into a pose's
+// padding, so only the matrix output (a plain mat4 array) needs a tail.
+
+
+// Abramowitz and Stegun 4.4.46, within 2e-8 on [0, 1]
+static inline vfloat acos_unit(vfloat x) {
+  vfloat p = vf_set1(-0.0012624911f);
+  p = vf_fmadd(p, x, vf_set1(0.0066700901f));
+  p = vf_fmadd(p, x, vf_set1(-0.0170881256f));
+  p = vf_fmadd(p, x, vf_set1(0.0308918810f));
+  p = vf_fmadd(p, x, vf_set1(-0.0501743046f));
+  p = vf_fmadd(p, x, vf_set1(0.0889789874f));
+  p = vf_fmadd(p, x, vf_set1(-0.2145988016f));
+  p = vf_fmadd(p, x, vf_set1(1.5707963050f));
+  return vf_mul(p, vf_sqrt(vf_sub(vf_set1(1.0f), x)));
+}
+
+// Taylor series to x^11, within 4e-8 on [0, pi / 2]
+static inline vfloat sin_quadrant(vfloat x) {
+  vfloat x2 = vf_mul(x, x);
+  vfloat p = vf_set1(-1.0f / 39916800.0f);
+  p = vf_fmadd(p, x2, vf_set1(1.0f / 362880.0f));
+  p = vf_fmadd(p, x2, vf_set1(-1.0f / 5040.0f));
+  p = vf_fmadd(p, x2, vf_set1(1.0f / 120.0f));
+  p = vf_fmadd(p, x2, vf_set1(-1.0f / 6.0f));
+  p = vf_fmadd(p, x2, vf_set1(1.0f));
+  return vf_mul(p, x);
+}
+
+static inline vfloat lerp(vfloat from, vfloat to, vfloat t) {
+  return vf_add(from, vf_mul(t, vf_sub(to, from)));
+}
+
+// glm_quat_nlerp: lerp towards whichever of b and -b is nearer, normalize
+static inline void nlerp(const vfloat a[4], const vfloat b[4], vfloat t, vfloat dot, vfloat q[4]) {
+  vfloat zero = vf_set1(0.0f);
+  vfloat sign = vf_select(vf_cmplt(dot, zero), vf_set1(-1.0f), vf_set1(1.0f));
+  q[0] = lerp(a[0], vf_mul(b[0], sign), t);
+  q[1] = lerp(a[1], vf_mul(b[1], sign), t);
+  q[2] = lerp(a[2], vf_mul(b[2], sign), t);
+  q[3] = lerp(a[3], vf_mul(b[3], sign), t);
+
+  // a zero length result becomes the identity, as in glm_quat_normalize
+  vfloat norm2 = vf_add(vf_add(vf_mul(q[0], q[0]), vf_mul(q[1], q[1])),
+                        vf_add(vf_mul(q[2], q[2]), vf_mul(q[3], q[3])));
+  vfloat valid = vf_cmplt(zero, norm2), norm = vf_sqrt(norm2);
+  q[0] = vf_select(valid, vf_div(q[0], norm), zero);
+  q[1] = vf_select(valid, vf_div(q[1], norm), zero);
+  q[2] = vf_select(valid, vf_div(q[2], norm), zero);
+  q[3] = vf_select(valid, vf_div(q[3], norm), vf_set1(1.0f));
+}
+
+static inline vfloat slerp_pick(vfloat a, vfloat b, vfloat t, vfloat wa, vfloat wb, vfloat scale, vfloat distinct,
+                                vfloat apart) {
+  vfloat s = vf_mul(vf_add(vf_mul(a, wa), vf_mul(b, wb)), scale);
+  return vf_select(distinct, vf_select(apart, s, lerp(a, b, t)), a);
+}
+
+// glm_quat_slerp with its special cases: a itself when the two are equal or
+// opposite, a plain lerp when they are too close to divide by the sine
+static inline void slerp(const vfloat a[4], const vfloat b[4], vfloat t, vfloat dot, vfloat q[4]) {
+  vfloat one = vf_set1(1.0f);
+  vfloat cos_theta = vf_abs(dot);
+  vfloat sign = vf_select(vf_cmplt(dot, vf_set1(0.0f)), vf_set1(-1.0f), one);
+  vfloat sin_theta = vf_sqrt(vf_sub(one, vf_mul(cos_theta, cos_theta)));
+  vfloat angle = acos_unit(cos_theta);
+  vfloat wa = vf_mul(sin_quadrant(vf_mul(vf_sub(one, t), angle)), sign);
+  vfloat wb = sin_quadrant(vf_mul(t, angle));
+  vfloat scale = vf_div(one, sin_theta);
+
+  vfloat distinct = vf_cmplt(cos_theta, one), apart = vf_cmplt(vf_set1(0.001f), sin_theta);
+  q[0] = slerp_pick(a[0], b[0], t, wa, wb, scale, distinct, apart);
+  q[1] = slerp_pick(a[1], b[1], t, wa, wb, scale, distinct, apart);
+  q[2] = slerp_pick(a[2], b[2], t, wa, wb, scale, distinct, apart);
+  q[3] = slerp_pick(a[3], b[3], t, wa, wb, scale, distinct, apart);
+}
+
+void SIMD_VARIANT(pose_blend_range)(const pose *a, const pose *b, pose *out, int begin, int end, float t, int mode) {
+  vfloat tv = vf_set1(t);
+  for (int i = begin; i < end; i += VF_WIDTH) {
+    vfloat qa[4] = {vf_load(a->rotation[0] + i), vf_load(a->rotation[1] + i), vf_load(a->rotation[2] + i),
+                    vf_load(a->rotation[3] + i)};
+    vfloat qb[4] = {vf_load(b->rotation[0] + i), vf_load(b->rotation[1] + i), vf_load(b->rotation[2] + i),
+                    vf_load(b->rotation[3] + i)};
+    vfloat dot = vf_add(vf_add(vf_mul(qa[0], qb[0]), vf_mul(qa[1], qb[1])),
+                        vf_add(vf_mul(qa[2], qb[2]), vf_mul(qa[3], qb[3])));
+    vfloat q[4];
+    if (mode == POSE_SLERP) {
+      slerp(qa, qb, tv, dot, q);
+    } else {
+      nlerp(qa, qb, tv, dot, q);
+    }
+    vf_store(out->rotation[0] + i, q[0]);
+    vf_store(out->rotation[1] + i, q[1]);
+    vf_store(out->rotation[2] + i, q[2]);
+    vf_store(out->rotation[3] + i, q[3]);
+
+    for (int k = 0; k < 3; k++) {
+      vf_store(out->translation[k] + i, lerp(vf_load(a->translation[k] + i), vf_load(b->translation[k] + i), tv));
+      vf_store(out->scale[k] + i, lerp(vf_load(a->scale[k] + i), vf_load(b->scale[k] + i), tv));
+    }
+  }
+}
+
+// bones i to i + VF_WIDTH - 1 as column-major matrices at dest
+static inline void trs_matrices(const pose *p, int i, float *dest) {
+  vfloat x = vf_load(p->rotation[0] + i), y = vf_load(p->rotation[1] + i);
+  vfloat z = vf_load(p->rotation[2] + i), w = vf_load(p->rotation[3] + i);
+
+  // glm_quat_mat4 scales by 2 / |q|, not 2 / |q|^2; the same for unit quaternions
+  vfloat zero = vf_set1(0.0f), one = vf_set1(1.0f);
+  vfloat norm = vf_sqrt(vf_add(vf_add(vf_mul(x, x), vf_mul(y, y)), vf_add(vf_mul(z, z), vf_mul(w, w))));
+  vfloat s = vf_select(vf_cmplt(zero, norm), vf_div(vf_set1(2.0f), norm), zero);
+  vfloat sx = vf_mul(s, x), sy = vf_mul(s, y), sw = vf_mul(s, w);
+  vfloat xx = vf_mul(sx, x), xy = vf_mul(sx, y), wx = vf_mul(sw, x);
+  vfloat yy = vf_mul(sy, y), yz = vf_mul(sy, z), wy = vf_mul(sw, y);
+  vfloat zz = vf_mul(vf_mul(s, z), z), xz = vf_mul(sx, z), wz = vf_mul(sw, z);
+
+  vfloat scale_x = vf_load(p->scale[0] + i), scale_y = vf_load(p->scale[1] + i), scale_z = vf_load(p->scale[2] + i);
+  vfloat c0[4] = {vf_mul(vf_sub(vf_sub(one, yy), zz), scale_x), vf_mul(vf_add(xy, wz), scale_x),
+                  vf_mul(vf_sub(xz, wy), scale_x), zero};
+  vfloat c1[4] = {vf_mul(vf_sub(xy, wz), scale_y), vf_mul(vf_sub(vf_sub(one, xx), zz), scale_y),
+                  vf_mul(vf_add(yz, wx), scale_y), zero};
+  vfloat c2[4] = {vf_mul(vf_add(xz, wy), scale_z), vf_mul(vf_sub(yz, wx), scale_z),
+                  vf_mul(vf_sub(vf_sub(one, xx), yy), scale_z), zero};
+  vfloat c3[4] = {vf_load(p->translation[0] + i), vf_load(p->translation[1] + i), vf_load(p->translation[2] + i),
+                  one};
+  vf_store4t(dest, 16, c0);
+  vf_store4t(dest + 4, 16, c1);
+  vf_store4t(dest + 8, 16, c2);
+  vf_store4t(dest + 12, 16, c3);
+}
+
+void SIMD_VARIANT(pose_matrices_range)(const pose *p, float *dest, int begin, int end) {
+  int i = begin;
+  for (; i + VF_WIDTH <= end; i += VF_WIDTH) {
+    trs_matrices(p, i, dest + 16 * i);
+  }
+
+  // the padding bones fill the rest of the last vector
+  if (i < end) {
+    float rest[16 * VF_WIDTH];
+    trs_matrices(p, i, rest);
+    memcpy(dest + 16 * i, rest, (end - i) * 16 * sizeof(float));
+  }
+}
@@ -0,0 +1,94 @@
+#include "math/simd.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char *level_names[SIMD_LEVELS] = {"base", "avx", "avx2", "avx512"};
+
+#define KERNEL_TABLE(suffix) {                                       \
+    .mat4_mul = SIMD_CONCAT(batch_mat4_mul, suffix),                 \
+    .mat4_inv = SIMD_CONCAT(batch_mat4_inv, suffix),                 \
+    .mat4_mulv = SIMD_CONCAT(batch_mat4_mulv, suffix),               \
+    .transform3 = SIMD_CONCAT(batch_transform3, suffix),             \
+    .transform3_soa = SIMD_CONCAT(batch_transform3_soa, suffix),     \
+    .transform4 = SIMD_CONCAT(batch_transform4, suffix),             \
+    .aabb_transform = SIMD_CONCAT(batch_aabb_transform, suffix),     \
+    .sphere_transform = SIMD_CONCAT(batch_sphere_transform, suffix), \
+    .noise_perlin2 = SIMD_CONCAT(noise_perlin2, suffix),             \
+    .noise_perlin3 = SIMD_CONCAT(noise_perlin3, suffix),             \
+    .noise_simplex2 = SIMD_CONCAT(noise_simplex2, suffix),           \
+    .noise_simplex3 = SIMD_CONCAT(noise_simplex3, suffix),           \
+    .pose_blend_range = SIMD_CONCAT(pose_blend_range, suffix),       \
+    .pose_matrices_range = SIMD_CONCAT(pose_matrices_range, suffix), \
+    .cull_range = SIMD_CONCAT(cull_range, suffix),                   \
+  }
+
+static const simd_kernels kernels[SIMD_LEVELS] = {
+  KERNEL_TABLE(base),
+#if defined(__x86_64__) || defined(__i386__)
+  KERNEL_TABLE(avx),
+  KERNEL_TABLE(avx2),
+  KERNEL_TABLE(avx512),
+#endif
+};
+
+simd_kernels simd = KERNEL_TABLE(base);
+
+static simd_level current = SIMD_BASE;
+
+simd_level simd_detect(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  // libgcc also checks that the OS saves the wider registers (XGETBV)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return SIMD_AVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return SIMD_AVX2;
+  }
+  if (__builtin_cpu_supports("avx")) {
+    return SIMD_AVX;
+  }
+#endif
+  return SIMD_BASE;
+}
+
+simd_level simd_init(void) {
+  simd_level level = simd_detect();
+
+  const char *forced = getenv("GAME_SIMD");
+  if (forced && *forced) {
+    int found = 0;
+    for (int i = 0; i < SIMD_LEVELS; i++) {
+      if (strcmp(forced, level_names[i]) == 0) {
+        found = 1;
+        if ((simd_level)i > level) {
+          fprintf(stderr, "ERROR: GAME_SIMD=%s is not supported by this CPU, using %s\n", forced, level_names[level]);
+        } else {
+          level = i;
+        }
+      }
+    }
+    if (!found) {
+      fprintf(stderr, "ERROR: Unknown GAME_SIMD=%s, using %s\n", forced, level_names[level]);
+    }
+  }
+
+  simd_use(level);
+  return level;
+}
+
+void simd_use(simd_level level) {
+  simd = kernels[level];
+  current = level;
+}
+
+simd_level simd_current(void) {
+  return current;
+}
+
+const char *simd_level_name(simd_level level) {
+  return level >= 0 && level < SIMD_LEVELS ? level_names[level] : "unknown";
+}
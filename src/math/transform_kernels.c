@@ -0,0 +1,129 @@
+#include "math/simd.h"
+
+#include "math/vfloat.h"
+
+// Bulk vector transforms, one copy per SIMD level. m is a column-major mat4 as
+// 16 floats, read without alignment assumptions like the vectors.
+
+
+// in and out are count packed vec3, w is 1 for points and 0 for directions
+void SIMD_VARIANT(batch_transform3)(const float *m, const float *in, float *out, int count, float w) {
+  vfloat m00 = vf_set1(m[0]), m01 = vf_set1(m[1]), m02 = vf_set1(m[2]);
+  vfloat m10 = vf_set1(m[4]), m11 = vf_set1(m[5]), m12 = vf_set1(m[6]);
+  vfloat m20 = vf_set1(m[8]), m21 = vf_set1(m[9]), m22 = vf_set1(m[10]);
+  vfloat t0 = vf_set1(m[12] * w), t1 = vf_set1(m[13] * w), t2 = vf_set1(m[14] * w);
+
+  int i = 0;
+  for (; i + VF_WIDTH <= count; i += VF_WIDTH) {
+    vfloat x, y, z;
+    vf_load3(in + 3 * i, &x, &y, &z);
+    vf_store3(out + 3 * i,
+              vf_fmadd(m20, z, vf_fmadd(m10, y, vf_fmadd(m00, x, t0))),
+              vf_fmadd(m21, z, vf_fmadd(m11, y, vf_fmadd(m01, x, t1))),
+              vf_fmadd(m22, z, vf_fmadd(m12, y, vf_fmadd(m02, x, t2))));
+  }
+
+  for (; i < count; i++) {
+    const float *v = in + 3 * i;
+    float x = v[0], y = v[1], z = v[2];
+    out[3 * i + 0] = m[0] * x + m[4] * y + m[8] * z + m[12] * w;
+    out[3 * i + 1] = m[1] * x + m[5] * y + m[9] * z + m[13] * w;
+    out[3 * i + 2] = m[2] * x + m[6] * y + m[10] * z + m[14] * w;
+  }
+}
+
+void SIMD_VARIANT(batch_transform3_soa)(const float *m, const float *const in[3], float *const out[3], int count,
+                                        float w) {
+  vfloat m00 = vf_set1(m[0]), m01 = vf_set1(m[1]), m02 = vf_set1(m[2]);
+  vfloat m10 = vf_set1(m[4]), m11 = vf_set1(m[5]), m12 = vf_set1(m[6]);
+  vfloat m20 = vf_set1(m[8]), m21 = vf_set1(m[9]), m22 = vf_set1(m[10]);
+  vfloat t0 = vf_set1(m[12] * w), t1 = vf_set1(m[13] * w), t2 = vf_set1(m[14] * w);
+  const float *in_x = in[0], *in_y = in[1], *in_z = in[2];
+  float *out_x = out[0], *out_y = out[1], *out_z = out[2];
+
+  int i = 0;
+  for (; i + VF_WIDTH <= count; i += VF_WIDTH) {
+    vfloat x = vf_loadu(in_x + i), y = vf_loadu(in_y + i), z = vf_loadu(in_z + i);
+    vf_storeu(out_x + i, vf_fmadd(m20, z, vf_fmadd(m10, y, vf_fmadd(m00, x, t0))));
+    vf_storeu(out_y + i, vf_fmadd(m21, z, vf_fmadd(m11, y, vf_fmadd(m01, x, t1))));
+    vf_storeu(out_z + i, vf_fmadd(m22, z, vf_fmadd(m12, y, vf_fmadd(m02, x, t2))));
+  }
+
+  for (; i < count; i++) {
+    float x = in_x[i], y = in_y[i], z = in_z[i];
+    out_x[i] = m[0] * x + m[4] * y + m[8] * z + m[12] * w;
+    out_y[i] = m[1] * x + m[5] * y + m[9] * z + m[13] * w;
+    out_z[i] = m[2] * x + m[6] * y + m[10] * z + m[14] * w;
+  }
+}
+
+static inline void mulv_scalar(const float *m, const float *v, float *dest) {
+  float x = v[0], y = v[1], z = v[2], w = v[3];
+  for (int r = 0; r < 4; r++) {
+    dest[r] = m[r] * x + m[4 + r] * y + m[8 + r] * z + m[12 + r] * w;
+  }
+}
+
+// one matrix, count packed vec4
+void SIMD_VARIANT(batch_transform4)(const float *m, const float *in, float *out, int count) {
+  int i = 0;
+#if defined(__AVX__)
+  // two vectors per register, each against the same columns
+  __m256 c0 = _mm256_broadcast_ps((const __m128 *)m);
+  __m256 c1 = _mm256_broadcast_ps((const __m128 *)(m + 4));
+  __m256 c2 = _mm256_broadcast_ps((const __m128 *)(m + 8));
+  __m256 c3 = _mm256_broadcast_ps((const __m128 *)(m + 12));
+  for (; i + 2 <= count; i += 2) {
+    __m256 v = _mm256_loadu_ps(in + 4 * i);
+    __m256 r = _mm256_mul_ps(c0, _mm256_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0)));
+    r = vf_fmadd(c1, _mm256_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1)), r);
+    r = vf_fmadd(c2, _mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2)), r);
+    r = vf_fmadd(c3, _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3)), r);
+    _mm256_storeu_ps(out + 4 * i, r);
+  }
+#elif defined(__SSE2__)
+  __m128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8), c3 = _mm_loadu_ps(m + 12);
+  for (; i < count; i++) {
+    __m128 v = _mm_loadu_ps(in + 4 * i);
+    __m128 r = _mm_mul_ps(c0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+    r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+    _mm_storeu_ps(out + 4 * i, r);
+  }
+#endif
+  for (; i < count; i++) {
+    float v[4] = {in[4 * i], in[4 * i + 1], in[4 * i + 2], in[4 * i + 3]};
+    mulv_scalar(m, v, out + 4 * i);
+  }
+}
+
+// count matrices times count vec4
+void SIMD_VARIANT(batch_mat4_mulv)(const float *m, const float *v, float *dest, int count) {
+  int i = 0;
+#if defined(__AVX__)
+  for (; i + 2 <= count; i += 2) {
+    const float *a = m + 16 * i, *b = a + 16;
+    __m256 x = _mm256_loadu_ps(v + 4 * i);
+    __m256 r = _mm256_mul_ps(_mm256_loadu2_m128(b, a), _mm256_permute_ps(x, _MM_SHUFFLE(0, 0, 0, 0)));
+    r = vf_fmadd(_mm256_loadu2_m128(b + 4, a + 4), _mm256_permute_ps(x, _MM_SHUFFLE(1, 1, 1, 1)), r);
+    r = vf_fmadd(_mm256_loadu2_m128(b + 8, a + 8), _mm256_permute_ps(x, _MM_SHUFFLE(2, 2, 2, 2)), r);
+    r = vf_fmadd(_mm256_loadu2_m128(b + 12, a + 12), _mm256_permute_ps(x, _MM_SHUFFLE(3, 3, 3, 3)), r);
+    _mm256_storeu_ps(dest + 4 * i, r);
+  }
+#elif defined(__SSE2__)
+  for (; i < count; i++) {
+    const float *a = m + 16 * i;
+    __m128 x = _mm_loadu_ps(v + 4 * i);
+    __m128 r = _mm_mul_ps(_mm_loadu_ps(a), _mm_shuffle_ps(x, x, _MM_SHUFFLE(0, 0, 0, 0)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(a + 4), _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1))));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(a + 8), _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 2, 2, 2))));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(a + 12), _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3))));
+    _mm_storeu_ps(dest + 4 * i, r);
+  }
+#endif
+  for (; i < count; i++) {
+    float x[4] = {v[4 * i], v[4 * i + 1], v[4 * i + 2], v[4 * i + 3]};
+    mulv_scalar(m + 16 * i, x, dest + 4 * i);
+  }
+}
@@ -0,0 +1,176 @@
+#include "platform/headless.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include "glad/glad.h"
+
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLContext context = EGL_NO_CONTEXT;
+static EGLSurface surface = EGL_NO_SURFACE;
+static GLuint fbo, color_rb, depth_rb;
+
+static int has_extension(const char *extensions, const char *name) {
+  size_t len = strlen(name);
+  const char *p = extensions;
+
+  while (p && (p = strstr(p, name))) {
+    if ((p == extensions || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0')) {
+      return 1;
+    }
+    p += len;
+  }
+
+  return 0;
+}
+
+static EGLDisplay open_display(void) {
+  const char *client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+  // the surfaceless platform needs no X11/Wayland/DRM node at all, which is
+  // exactly what the CI boxes lack
+  if (has_extension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    if (get_platform_display) {
+      EGLDisplay d = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+      if (d != EGL_NO_DISPLAY) {
+        return d;
+      }
+    }
+  }
+
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+int headless_init(void) {
+  display = open_display();
+
+  EGLint major, minor;
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+    fprintf(stderr, "ERROR: could not initialize EGL display (0x%x).\n", eglGetError());
+    return -1;
+  }
+
+  printf("Starting EGL %i.%i (headless).\n", major, minor);
+
+  if (!eglBindAPI(EGL_OPENGL_API)) {
+    fprintf(stderr, "ERROR: EGL display does not support desktop OpenGL.\n");
+    headless_terminate();
+    return -1;
+  }
+
+  int surfaceless = has_extension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+
+  const EGLint config_attribs[] = {
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+    EGL_RED_SIZE, 8,
+    EGL_GREEN_SIZE, 8,
+    EGL_BLUE_SIZE, 8,
+    EGL_NONE
+  };
+
+  EGLConfig config;
+  EGLint num_configs = 0;
+  if (!eglChooseConfig(display, config_attribs, &config, 1, &num_configs) || num_configs < 1) {
+    fprintf(stderr, "ERROR: no suitable EGL config.\n");
+    headless_terminate();
+    return -1;
+  }
+
+  const EGLint context_attribs[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 3,
+    EGL_CONTEXT_MINOR_VERSION, 3,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE, EGL_TRUE,
+    EGL_NONE
+  };
+
+  context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+  if (context == EGL_NO_CONTEXT) {
+    fprintf(stderr, "ERROR: could not create GL 3.3 core context (0x%x).\n", eglGetError());
+    headless_terminate();
+    return -1;
+  }
+
+  if (!surfaceless) {
+    // we never draw to it, it only exists so the context can be made current
+    const EGLint pbuffer_attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    surface = eglCreatePbufferSurface(display, config, pbuffer_attribs);
+    if (surface == EGL_NO_SURFACE) {
+      fprintf(stderr, "ERROR: could not create EGL pbuffer (0x%x).\n", eglGetError());
+      headless_terminate();
+      return -1;
+    }
+  }
+
+  if (!eglMakeCurrent(display, surface, surface, context)) {
+    fprintf(stderr, "ERROR: could not make EGL context current (0x%x).\n", eglGetError());
+    headless_terminate();
+    return -1;
+  }
+
+  return 0;
+}
+
+void *headless_get_proc_address(const char *name) {
+  return (void *)eglGetProcAddress(name);
+}
+
+int headless_create_framebuffer(int width, int height) {
+  if (fbo) {
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &color_rb);
+    glDeleteRenderbuffers(1, &depth_rb);
+  }
+
+  glGenRenderbuffers(1, &color_rb);
+  glBindRenderbuffer(GL_RENDERBUFFER, color_rb);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+  glGenRenderbuffers(1, &depth_rb);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth_rb);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+  glGenFramebuffers(1, &fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_rb);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_rb);
+
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    fprintf(stderr, "ERROR: headless framebuffer incomplete (0x%x).\n", status);
+    return -1;
+  }
+
+  return 0;
+}
+
+void headless_terminate(void) {
+  if (display == EGL_NO_DISPLAY) {
+    return;
+  }
+
+  if (fbo) {
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &color_rb);
+    glDeleteRenderbuffers(1, &depth_rb);
+    fbo = 0;
+  }
+
+  eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (surface != EGL_NO_SURFACE) {
+    eglDestroySurface(display, surface);
+    surface = EGL_NO_SURFACE;
+  }
+  if (context != EGL_NO_CONTEXT) {
+    eglDestroyContext(display, context);
+    context = EGL_NO_CONTEXT;
+  }
+  eglTerminate(display);
+  display = EGL_NO_DISPLAY;
+}
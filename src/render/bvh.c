@@ -0,0 +1,823 @@
+#include "render/bvh.h"
+
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils/arena.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+#define IS_ITEM(child) ((child) < BVH_EMPTY)
+#define ITEM_CHILD(item) (-2 - (item))
+#define CHILD_ITEM(child) (-2 - (child))
+
+// nodes pending on a query's own stack before it recurses
+#define STACK_SIZE 128
+
+static void set_slot(bvh_node *node, int slot, vec3 box[2]) {
+  node->min_x[slot] = box[0][0];
+  node->min_y[slot] = box[0][1];
+  node->min_z[slot] = box[0][2];
+  node->max_x[slot] = box[1][0];
+  node->max_y[slot] = box[1][1];
+  node->max_z[slot] = box[1][2];
+}
+
+static void clear_slot(bvh_node *node, int slot) {
+  node->min_x[slot] = node->min_y[slot] = node->min_z[slot] = FLT_MAX;
+  node->max_x[slot] = node->max_y[slot] = node->max_z[slot] = -FLT_MAX;
+  node->child[slot] = BVH_EMPTY;
+}
+
+static void copy_box(vec3 src[2], vec3 dest[2]) {
+  glm_vec3_copy(src[0], dest[0]);
+  glm_vec3_copy(src[1], dest[1]);
+}
+
+static void node_bounds(const bvh_node *node, vec3 box[2]) {
+  glm_aabb_invalidate(box);
+  for (int s = 0; s < BVH_WIDTH; s++) {
+    if (node->child[s] == BVH_EMPTY) {
+      continue;
+    }
+    box[0][0] = glm_min(box[0][0], node->min_x[s]);
+    box[0][1] = glm_min(box[0][1], node->min_y[s]);
+    box[0][2] = glm_min(box[0][2], node->min_z[s]);
+    box[1][0] = glm_max(box[1][0], node->max_x[s]);
+    box[1][1] = glm_max(box[1][1], node->max_y[s]);
+    box[1][2] = glm_max(box[1][2], node->max_z[s]);
+  }
+}
+
+static float area(vec3 box[2]) {
+  vec3 size;
+  glm_vec3_sub(box[1], box[0], size);
+  return 2.0f * (size[0] * size[1] + size[1] * size[2] + size[2] * size[0]);
+}
+
+static int alloc_node(bvh *tree, int parent, int parent_slot) {
+  int index;
+  if (tree->free_node >= 0) {
+    index = tree->free_node;
+    tree->free_node = tree->nodes[index].parent_slot;
+  } else {
+    if (tree->num_nodes == tree->node_capacity) {
+      int capacity = tree->node_capacity ? tree->node_capacity * 2 : 64;
+      bvh_node *nodes = aligned_alloc(64, capacity * sizeof(bvh_node));
+      if (!nodes) {
+        fprintf(stderr, "ERROR: could not allocate memory for %i BVH nodes.\n", capacity);
+        return -1;
+      }
+      if (tree->num_nodes) {
+        memcpy(nodes, tree->nodes, tree->num_nodes * sizeof(bvh_node));
+      }
+      free(tree->nodes);
+      tree->nodes = nodes;
+      tree->node_capacity = capacity;
+    }
+    index = tree->num_nodes++;
+  }
+
+  bvh_node *node = &tree->nodes[index];
+  for (int s = 0; s < BVH_WIDTH; s++) {
+    clear_slot(node, s);
+  }
+  node->parent = parent;
+  node->parent_slot = parent_slot;
+  return index;
+}
+
+static void release_node(bvh *tree, int index) {
+  tree->nodes[index].parent = -1;
+  tree->nodes[index].parent_slot = tree->free_node;
+  tree->free_node = index;
+}
+
+static int alloc_item(bvh *tree) {
+  if (tree->free_item >= 0) {
+    int item = tree->free_item;
+    tree->free_item = tree->items[item].slot;
+    return item;
+  }
+
+  if (tree->num_items == tree->item_capacity) {
+    int capacity = tree->item_capacity ? tree->item_capacity * 2 : 64;
+    bvh_item *items = realloc(tree->items, capacity * sizeof(bvh_item));
+    if (!items) {
+      fprintf(stderr, "ERROR: could not allocate memory for %i BVH items.\n", capacity);
+      return -1;
+    }
+    tree->items = items;
+    tree->item_capacity = capacity;
+  }
+  return tree->num_items++;
+}
+
+// puts child (a node or an encoded item) into a slot and points it back
+static void attach(bvh *tree, int node, int slot, int child, vec3 box[2]) {
+  tree->nodes[node].child[slot] = child;
+  set_slot(&tree->nodes[node], slot, box);
+  if (IS_ITEM(child)) {
+    tree->items[CHILD_ITEM(child)].node = node;
+    tree->items[CHILD_ITEM(child)].slot = slot;
+  } else {
+    tree->nodes[child].parent = node;
+    tree->nodes[child].parent_slot = slot;
+  }
+}
+
+// recomputes the slots above node until they stop changing
+static void refit_up(bvh *tree, int node) {
+  while (node != 0) {
+    bvh_node *current = &tree->nodes[node];
+    bvh_node *parent = &tree->nodes[current->parent];
+    int slot = current->parent_slot;
+
+    vec3 box[2];
+    node_bounds(current, box);
+    if (parent->min_x[slot] == box[0][0] && parent->min_y[slot] == box[0][1] && parent->min_z[slot] == box[0][2] &&
+        parent->max_x[slot] == box[1][0] && parent->max_y[slot] == box[1][1] && parent->max_z[slot] == box[1][2]) {
+      return;
+    }
+    set_slot(parent, slot, box);
+    node = current->parent;
+  }
+}
+
+int bvh_init(bvh *tree) {
+  memset(tree, 0, sizeof(*tree));
+  tree->free_node = -1;
+  tree->free_item = -1;
+  return alloc_node(tree, -1, -1) == 0 ? 0 : -1;
+}
+
+void bvh_free(bvh *tree) {
+  free(tree->nodes);
+  free(tree->items);
+  memset(tree, 0, sizeof(*tree));
+}
+
+typedef struct {
+  bvh *tree;
+  int *refs;
+  vec3 *centroids;
+} build_context;
+
+static void range_bounds(build_context *build, int begin, int end, vec3 box[2]) {
+  glm_aabb_invalidate(box);
+  for (int i = begin; i < end; i++) {
+    glm_aabb_merge(box, build->tree->items[build->refs[i]].box, box);
+  }
+}
+
+// splits [begin, end) where the surface area heuristic says, returns the middle
+static int split_range(build_context *build, int begin, int end) {
+  vec3 centroid_box[2];
+  glm_aabb_invalidate(centroid_box);
+  for (int i = begin; i < end; i++) {
+    glm_vec3_minv(centroid_box[0], build->centroids[build->refs[i]], centroid_box[0]);
+    glm_vec3_maxv(centroid_box[1], build->centroids[build->refs[i]], centroid_box[1]);
+  }
+
+  float best_cost = FLT_MAX;
+  int best_axis = -1, best_bin = 0;
+
+  for (int axis = 0; axis < 3; axis++) {
+    float extent = centroid_box[1][axis] - centroid_box[0][axis];
+    if (extent <= 1e-6f) {
+      continue;
+    }
+    float scale = BVH_BINS * 0.9999f / extent;
+
+    vec3 bins[BVH_BINS][2];
+    int counts[BVH_BINS] = {0};
+    for (int b = 0; b < BVH_BINS; b++) {
+      glm_aabb_invalidate(bins[b]);
+    }
+    for (int i = begin; i < end; i++) {
+      int item = build->refs[i];
+      int b = (int)((build->centroids[item][axis] - centroid_box[0][axis]) * scale);
+      glm_aabb_merge(bins[b], build->tree->items[item].box, bins[b]);
+      counts[b]++;
+    }
+
+    // areas of everything right of each split, then sweep from the left
+    float right_area[BVH_BINS];
+    int right_count[BVH_BINS];
+    vec3 box[2];
+    glm_aabb_invalidate(box);
+    int count = 0;
+    for (int b = BVH_BINS - 1; b > 0; b--) {
+      glm_aabb_merge(box, bins[b], box);
+      count += counts[b];
+      right_area[b] = count ? area(box) : 0.0f;
+      right_count[b] = count;
+    }
+
+    glm_aabb_invalidate(box);
+    count = 0;
+    for (int b = 0; b < BVH_BINS - 1; b++) {
+      glm_aabb_merge(box, bins[b], box);
+      count += counts[b];
+      if (count == 0 || right_count[b + 1] == 0) {
+        continue;
+      }
+      float cost = area(box) * count + right_area[b + 1] * right_count[b + 1];
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_bin = b;
+      }
+    }
+  }
+
+  // all centroids in one spot, any split is as good as another
+  if (best_axis < 0) {
+    return begin + (end - begin) / 2;
+  }
+
+  float scale = BVH_BINS * 0.9999f / (centroid_box[1][best_axis] - centroid_box[0][best_axis]);
+  int middle = begin;
+  for (int i = begin; i < end; i++) {
+    int item = build->refs[i];
+    int b = (int)((build->centroids[item][best_axis] - centroid_box[0][best_axis]) * scale);
+    if (b <= best_bin) {
+      build->refs[i] = build->refs[middle];
+      build->refs[middle++] = item;
+    }
+  }
+  return middle;
+}
+
+// builds the node for [begin, end) and returns it, -1 if out of memory
+static int build_node(build_context *build, int begin, int end, int parent, int parent_slot) {
+  bvh *tree = build->tree;
+  int node = alloc_node(tree, parent, parent_slot);
+  if (node < 0) {
+    return -1;
+  }
+
+  // split the biggest range until there is one per slot
+  int ranges[BVH_WIDTH][2] = {{begin, end}};
+  int num_ranges = 1;
+  while (num_ranges < BVH_WIDTH) {
+    int largest = -1;
+    for (int r = 0; r < num_ranges; r++) {
+      int size = ranges[r][1] - ranges[r][0];
+      if (size > 1 && (largest < 0 || size > ranges[largest][1] - ranges[largest][0])) {
+        largest = r;
+      }
+    }
+    if (largest < 0) {
+      break;
+    }
+
+    int middle = split_range(build, ranges[largest][0], ranges[largest][1]);
+    ranges[num_ranges][0] = middle;
+    ranges[num_ranges][1] = ranges[largest][1];
+    ranges[largest][1] = middle;
+    num_ranges++;
+  }
+
+  for (int r = 0; r < num_ranges; r++) {
+    int child;
+    if (ranges[r][1] - ranges[r][0] == 1) {
+      child = ITEM_CHILD(build->refs[ranges[r][0]]);
+    } else {
+      child = build_node(build, ranges[r][0], ranges[r][1], node, r);
+      if (child < 0) {
+        return -1;
+      }
+    }
+
+    vec3 box[2];
+    range_bounds(build, ranges[r][0], ranges[r][1], box);
+    attach(tree, node, r, child, box);
+  }
+
+  return node;
+}
+
+int bvh_build(bvh *tree, vec3 (*boxes)[2], int count) {
+  tree->num_nodes = 0;
+  tree->free_node = -1;
+  tree->num_items = 0;
+  tree->free_item = -1;
+
+  for (int i = 0; i < count; i++) {
+    if (alloc_item(tree) < 0) {
+      return -1;
+    }
+    copy_box(boxes[i], tree->items[i].box);
+    tree->items[i].node = -1;
+    tree->items[i].slot = -1;
+  }
+  if (count == 0) {
+    return alloc_node(tree, -1, -1) == 0 ? 0 : -1;
+  }
+
+  arena *scratch = arena_scratch();
+  if (!scratch) {
+    return -1;
+  }
+  arena_mark mark = arena_get_mark(scratch);
+  build_context build;
+  build.tree = tree;
+  build.refs = arena_alloc(scratch, count * sizeof(int), 16);
+  build.centroids = arena_alloc(scratch, count * sizeof(vec3), 16);
+  if (!build.refs || !build.centroids) {
+    fprintf(stderr, "ERROR: could not allocate memory to build a BVH over %i items.\n", count);
+    arena_release(scratch, mark);
+    return -1;
+  }
+
+  for (int i = 0; i < count; i++) {
+    build.refs[i] = i;
+    glm_aabb_center(boxes[i], build.centroids[i]);
+  }
+
+  // the first node allocated is the root
+  int result = build_node(&build, 0, count, -1, -1) == 0 ? 0 : -1;
+
+  arena_release(scratch, mark);
+  return result;
+}
+
+int bvh_insert(bvh *tree, vec3 box[2]) {
+  int item = alloc_item(tree);
+  if (item < 0) {
+    return -1;
+  }
+  copy_box(box, tree->items[item].box);
+  tree->items[item].node = -1;
+
+  int node = 0;
+  for (;;) {
+    bvh_node *current = &tree->nodes[node];
+
+    // every slot is full here; starting on one keeps best valid even if all
+    // the growths overflow to inf or NaN
+    int best = 0;
+    float best_growth = FLT_MAX, best_area = FLT_MAX;
+    for (int s = 0; s < BVH_WIDTH; s++) {
+      if (current->child[s] == BVH_EMPTY) {
+        attach(tree, node, s, ITEM_CHILD(item), box);
+        refit_up(tree, node);
+        return item;
+      }
+
+      vec3 slot[2] = {{current->min_x[s], current->min_y[s], current->min_z[s]},
+                      {current->max_x[s], current->max_y[s], current->max_z[s]}};
+      float before = area(slot);
+      glm_aabb_merge(slot, box, slot);
+      float growth = area(slot) - before;
+      if (growth < best_growth || (growth == best_growth && before < best_area)) {
+        best = s;
+        best_growth = growth;
+        best_area = before;
+      }
+    }
+
+    int child = current->child[best];
+    if (!IS_ITEM(child)) {
+      // growing the slot on the way down keeps its bounds right
+      vec3 slot[2] = {{current->min_x[best], current->min_y[best], current->min_z[best]},
+                      {current->max_x[best], current->max_y[best], current->max_z[best]}};
+      glm_aabb_merge(slot, box, slot);
+      set_slot(current, best, slot);
+      node = child;
+      continue;
+    }
+
+    // two items share a new node where the old one was
+    int split = alloc_node(tree, node, best);
+    if (split < 0) {
+      bvh_remove(tree, item);
+      return -1;
+    }
+    int other = CHILD_ITEM(child);
+    attach(tree, split, 0, child, tree->items[other].box);
+    attach(tree, split, 1, ITEM_CHILD(item), box);
+
+    vec3 both[2];
+    glm_aabb_merge(tree->items[other].box, box, both);
+    attach(tree, node, best, split, both);
+    refit_up(tree, node);
+    return item;
+  }
+}
+
+void bvh_remove(bvh *tree, int item) {
+  bvh_item *removed = &tree->items[item];
+  int node = removed->node;
+  if (node >= 0) {
+    clear_slot(&tree->nodes[node], removed->slot);
+  }
+  removed->node = -1;
+  removed->slot = tree->free_item;
+  tree->free_item = item;
+
+  // collapse nodes left with one child or none
+  while (node > 0) {
+    bvh_node *current = &tree->nodes[node];
+    int remaining = -1, count = 0;
+    for (int s = 0; s < BVH_WIDTH; s++) {
+      if (current->child[s] != BVH_EMPTY) {
+        remaining = s;
+        count++;
+      }
+    }
+    if (count > 1) {
+      break;
+    }
+
+    int parent = current->parent;
+    int slot = current->parent_slot;
+    if (count == 1) {
+      vec3 box[2] = {{current->min_x[remaining], current->min_y[remaining], current->min_z[remaining]},
+                     {current->max_x[remaining], current->max_y[remaining], current->max_z[remaining]}};
+      attach(tree, parent, slot, current->child[remaining], box);
+    } else {
+      clear_slot(&tree->nodes[parent], slot);
+    }
+    release_node(tree, node);
+    node = parent;
+  }
+
+  if (node >= 0) {
+    refit_up(tree, node);
+  }
+}
+
+void bvh_update(bvh *tree, int item, vec3 box[2]) {
+  bvh_item *moved = &tree->items[item];
+  copy_box(box, moved->box);
+  set_slot(&tree->nodes[moved->node], moved->slot, box);
+  refit_up(tree, moved->node);
+}
+
+void bvh_set_box(bvh *tree, int item, vec3 box[2]) {
+  copy_box(box, tree->items[item].box);
+}
+
+static void refit_node(bvh *tree, int node, vec3 box[2]) {
+  for (int s = 0; s < BVH_WIDTH; s++) {
+    int child = tree->nodes[node].child[s];
+    if (child == BVH_EMPTY) {
+      continue;
+    }
+    if (IS_ITEM(child)) {
+      set_slot(&tree->nodes[node], s, tree->items[CHILD_ITEM(child)].box);
+    } else {
+      vec3 child_box[2];
+      refit_node(tree, child, child_box);
+      set_slot(&tree->nodes[node], s, child_box);
+    }
+  }
+  node_bounds(&tree->nodes[node], box);
+}
+
+void bvh_refit(bvh *tree) {
+  vec3 box[2];
+  refit_node(tree, 0, box);
+}
+
+// bit s set for each slot holding something
+static int valid_mask(const bvh_node *node) {
+  int mask = 0;
+  for (int s = 0; s < BVH_WIDTH; s++) {
+    mask |= (node->child[s] != BVH_EMPTY) << s;
+  }
+  return mask;
+}
+
+static int emit(int *out, int found, int max_out, int item) {
+  if (found < max_out) {
+    out[found] = item;
+  }
+  return found + 1;
+}
+
+static int collect_all(const bvh *tree, int node, int *out, int found, int max_out) {
+  const bvh_node *current = &tree->nodes[node];
+  for (int s = 0; s < BVH_WIDTH; s++) {
+    int child = current->child[s];
+    if (IS_ITEM(child)) {
+      found = emit(out, found, max_out, CHILD_ITEM(child));
+    } else if (child != BVH_EMPTY) {
+      found = collect_all(tree, child, out, found, max_out);
+    }
+  }
+  return found;
+}
+
+// slots outside the frustum, and slots entirely inside it
+static void frustum_masks(const bvh_node *node, vec4 planes[6], int *outside, int *inside) {
+#if defined(__SSE2__)
+  __m128 out = _mm_setzero_ps();
+  __m128 in = _mm_castsi128_ps(_mm_set1_epi32(-1));
+  __m128 min_x = _mm_load_ps(node->min_x), min_y = _mm_load_ps(node->min_y), min_z = _mm_load_ps(node->min_z);
+  __m128 max_x = _mm_load_ps(node->max_x), max_y = _mm_load_ps(node->max_y), max_z = _mm_load_ps(node->max_z);
+
+  for (int p = 0; p < 6; p++) {
+    float *plane = planes[p];
+    __m128 a = _mm_set1_ps(plane[0]), b = _mm_set1_ps(plane[1]), c = _mm_set1_ps(plane[2]);
+    __m128 d = _mm_set1_ps(-plane[3]);
+
+    // the corner furthest along the normal decides outside, the nearest inside
+    __m128 far = _mm_add_ps(_mm_add_ps(
+                   _mm_mul_ps(a, plane[0] > 0.0f ? max_x : min_x),
+                   _mm_mul_ps(b, plane[1] > 0.0f ? max_y : min_y)),
+                   _mm_mul_ps(c, plane[2] > 0.0f ? max_z : min_z));
+    __m128 near = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(a, plane[0] > 0.0f ? min_x : max_x),
+                    _mm_mul_ps(b, plane[1] > 0.0f ? min_y : max_y)),
+                    _mm_mul_ps(c, plane[2] > 0.0f ? min_z : max_z));
+
+    out = _mm_or_ps(out, _mm_cmplt_ps(far, d));
+    in = _mm_and_ps(in, _mm_cmpge_ps(near, d));
+  }
+
+  *outside = _mm_movemask_ps(out);
+  *inside = _mm_movemask_ps(in);
+#else
+  *outside = 0;
+  *inside = 0;
+  for (int s = 0; s < BVH_WIDTH; s++) {
+    int slot_in = 1;
+    for (int p = 0; p < 6; p++) {
+      float *plane = planes[p];
+      float far = plane[0] * (plane[0] > 0.0f ? node->max_x[s] : node->min_x[s])
+                + plane[1] * (plane[1] > 0.0f ? node->max_y[s] : node->min_y[s])
+                + plane[2] * (plane[2] > 0.0f ? node->max_z[s] : node->min_z[s]);
+      float near = plane[0] * (plane[0] > 0.0f ? node->min_x[s] : node->max_x[s])
+                 + plane[1] * (plane[1] > 0.0f ? node->min_y[s] : node->max_y[s])
+                 + plane[2] * (plane[2] > 0.0f ? node->min_z[s] : node->max_z[s]);
+      if (far < -plane[3]) {
+        *outside |= 1 << s;
+      }
+      slot_in &= near >= -plane[3];
+    }
+    *inside |= slot_in << s;
+  }
+#endif
+}
+
+static int query_frustum(const bvh *tree, int root, vec4 planes[6], int *out, int found, int max_out) {
+  int stack[STACK_SIZE];
+  int top = 0;
+  stack[top++] = root;
+
+  while (top > 0) {
+    const bvh_node *node = &tree->nodes[stack[--top]];
+    int outside, inside;
+    frustum_masks(node, planes, &outside, &inside);
+    int hit = valid_mask(node) & ~outside;
+
+    while (hit) {
+      int s = __builtin_ctz(hit);
+      hit &= hit - 1;
+
+      int child = node->child[s];
+      if (IS_ITEM(child)) {
+        found = emit(out, found, max_out, CHILD_ITEM(child));
+      } else if (inside & (1 << s)) {
+        found = collect_all(tree, child, out, found, max_out);
+      } else if (top < STACK_SIZE) {
+        stack[top++] = child;
+      } else {
+        found = query_frustum(tree, child, planes, out, found, max_out);
+      }
+    }
+  }
+
+  return found;
+}
+
+int bvh_query_frustum(const bvh *tree, vec4 planes[6], int *out, int max_out) {
+  return query_frustum(tree, 0, planes, out, 0, max_out);
+}
+
+static int aabb_mask(const bvh_node *node, vec3 box[2]) {
+#if defined(__SSE2__)
+  __m128 overlap = _mm_and_ps(
+    _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node->min_x), _mm_set1_ps(box[1][0])),
+               _mm_cmpge_ps(_mm_load_ps(node->max_x), _mm_set1_ps(box[0][0]))),
+    _mm_and_ps(_mm_and_ps(_mm_cmple_ps(_mm_load_ps(node->min_y), _mm_set1_ps(box[1][1])),
+                          _mm_cmpge_ps(_mm_load_ps(node->max_y), _mm_set1_ps(box[0][1]))),
+               _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node->min_z), _mm_set1_ps(box[1][2])),
+                          _mm_cmpge_ps(_mm_load_ps(node->max_z), _mm_set1_ps(box[0][2])))));
+  return _mm_movemask_ps(overlap);
+#else
+  int mask = 0;
+  for (int s = 0; s < BVH_WIDTH; s++) {
+    mask |= (node->min_x[s] <= box[1][0] && node->max_x[s] >= box[0][0] &&
+             node->min_y[s] <= box[1][1] && node->max_y[s] >= box[0][1] &&
+             node->min_z[s] <= box[1][2] && node->max_z[s] >= box[0][2]) << s;
+  }
+  return mask;
+#endif
+}
+
+static int sphere_mask(const bvh_node *node, vec4 sphere) {
+#if defined(__SSE2__)
+  // squared distance from the center to the closest point of each box
+  __m128 dx = _mm_sub_ps(_mm_max_ps(_mm_load_ps(node->min_x), _mm_min_ps(_mm_set1_ps(sphere[0]), _mm_load_ps(node->max_x))),
+                         _mm_set1_ps(sphere[0]));
+  __m128 dy = _mm_sub_ps(_mm_max_ps(_mm_load_ps(node->min_y), _mm_min_ps(_mm_set1_ps(sphere[1]), _mm_load_ps(node->max_y))),
+                         _mm_set1_ps(sphere[1]));
+  __m128 dz = _mm_sub_ps(_mm_max_ps(_mm_load_ps(node->min_z), _mm_min_ps(_mm_set1_ps(sphere[2]), _mm_load_ps(node->max_z))),
+                         _mm_set1_ps(sphere[2]));
+  __m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+  return _mm_movemask_ps(_mm_cmple_ps(dist2, _mm_set1_ps(sphere[3] * sphere[3])));
+#else
+  int mask = 0;
+  for (int s = 0; s < BVH_WIDTH; s++) {
+    float dx = glm_clamp(sphere[0], node->min_x[s], node->max_x[s]) - sphere[0];
+    float dy = glm_clamp(sphere[1], node->min_y[s], node->max_y[s]) - sphere[1];
+    float dz = glm_clamp(sphere[2], node->min_z[s], node->max_z[s]) - sphere[2];
+    mask |= (dx * dx + dy * dy + dz * dz <= sphere[3] * sphere[3]) << s;
+  }
+  return mask;
+#endif
+}
+
+// one traversal for the overlap queries, box_or_sphere is whichever is used
+static int query_overlap(const bvh *tree, int root, vec3 *box, float *sphere, int *out, int found, int max_out) {
+  int stack[STACK_SIZE];
+  int top = 0;
+  stack[top++] = root;
+
+  while (top > 0) {
+    const bvh_node *node = &tree->nodes[stack[--top]];
+    int hit = valid_mask(node) & (box ? aabb_mask(node, box) : sphere_mask(node, sphere));
+
+    while (hit) {
+      int s = __builtin_ctz(hit);
+      hit &= hit - 1;
+
+      int child = node->child[s];
+      if (IS_ITEM(child)) {
+        found = emit(out, found, max_out, CHILD_ITEM(child));
+      } else if (top < STACK_SIZE) {
+        stack[top++] = child;
+      } else {
+        found = query_overlap(tree, child, box, sphere, out, found, max_out);
+      }
+    }
+  }
+
+  return found;
+}
+
+int bvh_query_aabb(const bvh *tree, vec3 box[2], int *out, int max_out) {
+  return query_overlap(tree, 0, box, NULL, out, 0, max_out);
+}
+
+int bvh_query_sphere(const bvh *tree, vec4 sphere, int *out, int max_out) {
+  return query_overlap(tree, 0, NULL, sphere, out, 0, max_out);
+}
+
+#if defined(__SSE2__)
+// narrows [enter, leave] to one axis' slab. A zero direction component makes
+// inv_dir infinite and (min - origin) * inv_dir NaN for an origin on a plane,
+// but such a ray never crosses the slab: it is inside it for good or misses.
+static inline void slab4(const float *min, const float *max, float origin, float inv_dir,
+                         __m128 *enter, __m128 *leave, __m128 *inside) {
+  __m128 o = _mm_set1_ps(origin);
+  if (isinf(inv_dir)) {
+    *inside = _mm_and_ps(*inside, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(min), o), _mm_cmple_ps(o, _mm_load_ps(max))));
+    return;
+  }
+  __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(min), o), _mm_set1_ps(inv_dir));
+  __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(max), o), _mm_set1_ps(inv_dir));
+  *enter = _mm_max_ps(*enter, _mm_min_ps(t1, t2));
+  *leave = _mm_min_ps(*leave, _mm_max_ps(t1, t2));
+}
+#endif
+
+// slab test, entry distances go to near
+static int ray_mask(const bvh_node *node, vec3 origin, vec3 inv_dir, float max_distance, float near[BVH_WIDTH]) {
+#if defined(__SSE2__)
+  __m128 enter = _mm_setzero_ps(), leave = _mm_set1_ps(max_distance);
+  __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+  slab4(node->min_x, node->max_x, origin[0], inv_dir[0], &enter, &leave, &inside);
+  slab4(node->min_y, node->max_y, origin[1], inv_dir[1], &enter, &leave, &inside);
+  slab4(node->min_z, node->max_z, origin[2], inv_dir[2], &enter, &leave, &inside);
+  _mm_storeu_ps(near, enter);
+  return _mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(enter, leave), inside));
+#else
+  const float *min[3] = {node->min_x, node->min_y, node->min_z};
+  const float *max[3] = {node->max_x, node->max_y, node->max_z};
+  int mask = 0;
+  for (int s = 0; s < BVH_WIDTH; s++) {
+    float enter = 0.0f, leave = max_distance;
+    int inside = 1;
+    for (int a = 0; a < 3; a++) {
+      // see slab4()
+      if (isinf(inv_dir[a])) {
+        inside &= min[a][s] <= origin[a] && origin[a] <= max[a][s];
+        continue;
+      }
+      float t1 = (min[a][s] - origin[a]) * inv_dir[a], t2 = (max[a][s] - origin[a]) * inv_dir[a];
+      enter = glm_max(enter, glm_min(t1, t2));
+      leave = glm_min(leave, glm_max(t1, t2));
+    }
+    near[s] = enter;
+    mask |= (inside && enter <= leave) << s;
+  }
+  return mask;
+#endif
+}
+
+typedef struct {
+  vec3 origin, dir, inv_dir;
+  bvh_ray_test test;
+  void *user;
+  int best;
+  float best_distance;
+} ray_query;
+
+static void raycast(const bvh *tree, int root, float root_enter, ray_query *ray) {
+  // nodes with the distance at which the ray enters them, nearest on top
+  struct {
+    int node;
+    float enter;
+  } stack[STACK_SIZE];
+  int top = 0;
+  stack[top].node = root;
+  stack[top++].enter = root_enter;
+
+  while (top > 0) {
+    top--;
+    if (stack[top].enter > ray->best_distance) {
+      continue;
+    }
+    const bvh_node *node = &tree->nodes[stack[top].node];
+
+    float near[BVH_WIDTH];
+    int hit = valid_mask(node) & ray_mask(node, ray->origin, ray->inv_dir, ray->best_distance, near);
+
+    // furthest first, so the nearest child is popped next
+    int order[BVH_WIDTH], count = 0;
+    while (hit) {
+      int s = __builtin_ctz(hit);
+      hit &= hit - 1;
+      int i = count++;
+      while (i > 0 && near[order[i - 1]] < near[s]) {
+        order[i] = order[i - 1];
+        i--;
+      }
+      order[i] = s;
+    }
+
+    for (int i = 0; i < count; i++) {
+      int s = order[i];
+      int child = node->child[s];
+      if (!IS_ITEM(child)) {
+        if (top < STACK_SIZE) {
+          stack[top].node = child;
+          stack[top++].enter = near[s];
+        } else {
+          raycast(tree, child, near[s], ray);
+        }
+        continue;
+      }
+
+      int item = CHILD_ITEM(child);
+      float t = near[s];
+      if (ray->test && !ray->test(ray->user, item, ray->origin, ray->dir, &t)) {
+        continue;
+      }
+      if (t <= ray->best_distance) {
+        ray->best = item;
+        ray->best_distance = t;
+      }
+    }
+  }
+}
+
+int bvh_raycast(const bvh *tree, vec3 origin, vec3 dir, float max_distance,
+                bvh_ray_test test, void *user, float *distance) {
+  ray_query ray;
+  glm_vec3_copy(origin, ray.origin);
+  glm_vec3_copy(dir, ray.dir);
+  ray.inv_dir[0] = 1.0f / dir[0];
+  ray.inv_dir[1] = 1.0f / dir[1];
+  ray.inv_dir[2] = 1.0f / dir[2];
+  ray.test = test;
+  ray.user = user;
+  ray.best = -1;
+  ray.best_distance = max_distance;
+
+  raycast(tree, 0, 0.0f, &ray);
+
+  if (ray.best >= 0 && distance) {
+    *distance = ray.best_distance;
+  }
+  return ray.best;
+}
@@ -0,0 +1,233 @@
+#include "render/command_buffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "render/gl_state.h"
+
+#define UNKNOWN_STATE ((GLuint)-1)
+
+
+// room for size more bytes at the end, NULL if the buffer could not grow
+static void *append(command_buffer *buffer, size_t size) {
+  if (buffer->size + size > buffer->capacity) {
+    size_t capacity = buffer->capacity ? buffer->capacity * 2 : 64 * 1024;
+    while (capacity < buffer->size + size) {
+      capacity *= 2;
+    }
+    char *data = realloc(buffer->data, capacity);
+    if (!data) {
+      fprintf(stderr, "ERROR: could not allocate %zu bytes of render commands.\n", capacity);
+      return NULL;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+  }
+
+  void *command = buffer->data + buffer->size;
+  buffer->size += size;
+  buffer->commands++;
+  return command;
+}
+
+void command_buffer_init(command_buffer *buffer) {
+  memset(buffer, 0, sizeof(*buffer));
+  command_buffer_reset(buffer);
+}
+
+void command_buffer_free(command_buffer *buffer) {
+  free(buffer->data);
+  memset(buffer, 0, sizeof(*buffer));
+}
+
+void command_buffer_reset(command_buffer *buffer) {
+  buffer->size = 0;
+  buffer->commands = 0;
+  buffer->program = UNKNOWN_STATE;
+  buffer->vao = UNKNOWN_STATE;
+  buffer->texture = UNKNOWN_STATE;
+  buffer->blend_src = UNKNOWN_STATE;
+  buffer->blend_dst = UNKNOWN_STATE;
+  buffer->blend = -1;
+  buffer->depth_mask = -1;
+}
+
+int command_buffer_set_enabled(command_buffer *buffer, GLenum cap, int enabled) {
+  enabled = enabled != 0;
+  if (cap == GL_BLEND && buffer->blend == enabled) {
+    return 0;
+  }
+
+  set_enabled_command *command = append(buffer, sizeof(*command));
+  if (!command) {
+    return -1;
+  }
+  *command = (set_enabled_command){COMMAND_SET_ENABLED, cap, enabled};
+  if (cap == GL_BLEND) {
+    buffer->blend = enabled;
+  }
+  return 0;
+}
+
+int command_buffer_blend_func(command_buffer *buffer, GLenum src, GLenum dst) {
+  if (buffer->blend_src == src && buffer->blend_dst == dst) {
+    return 0;
+  }
+
+  blend_func_command *command = append(buffer, sizeof(*command));
+  if (!command) {
+    return -1;
+  }
+  *command = (blend_func_command){COMMAND_BLEND_FUNC, src, dst};
+  buffer->blend_src = src;
+  buffer->blend_dst = dst;
+  return 0;
+}
+
+int command_buffer_depth_mask(command_buffer *buffer, int mask) {
+  mask = mask != 0;
+  if (buffer->depth_mask == mask) {
+    return 0;
+  }
+
+  depth_mask_command *command = append(buffer, sizeof(*command));
+  if (!command) {
+    return -1;
+  }
+  *command = (depth_mask_command){COMMAND_DEPTH_MASK, mask};
+  buffer->depth_mask = mask;
+  return 0;
+}
+
+int command_buffer_use_program(command_buffer *buffer, GLuint program) {
+  if (buffer->program == program) {
+    return 0;
+  }
+
+  use_program_command *command = append(buffer, sizeof(*command));
+  if (!command) {
+    return -1;
+  }
+  *command = (use_program_command){COMMAND_USE_PROGRAM, program};
+  buffer->program = program;
+  return 0;
+}
+
+int command_buffer_bind_vertex_array(command_buffer *buffer, GLuint vao) {
+  if (buffer->vao == vao) {
+    return 0;
+  }
+
+  bind_vertex_array_command *command = append(buffer, sizeof(*command));
+  if (!command) {
+    return -1;
+  }
+  *command = (bind_vertex_array_command){COMMAND_BIND_VERTEX_ARRAY, vao};
+  buffer->vao = vao;
+  return 0;
+}
+
+int command_buffer_bind_texture(command_buffer *buffer, GLuint unit, GLenum target, GLuint texture) {
+  // only unit 0's 2D binding is tracked, the one draw packets use
+  int tracked = unit == 0 && target == GL_TEXTURE_2D;
+  if (tracked && buffer->texture == texture) {
+    return 0;
+  }
+
+  bind_texture_command *command = append(buffer, sizeof(*command));
+  if (!command) {
+    return -1;
+  }
+  *command = (bind_texture_command){COMMAND_BIND_TEXTURE, unit, target, texture};
+  if (tracked) {
+    buffer->texture = texture;
+  }
+  return 0;
+}
+
+int command_buffer_uniform_matrix4(command_buffer *buffer, GLint location, const GLfloat *value) {
+  uniform_matrix4_command *command = append(buffer, sizeof(*command));
+  if (!command) {
+    return -1;
+  }
+  command->type = COMMAND_UNIFORM_MATRIX4;
+  command->location = location;
+  memcpy(command->value, value, sizeof(command->value));
+  return 0;
+}
+
+int command_buffer_draw_arrays(command_buffer *buffer, GLenum mode, GLint first, GLsizei count,
+                               GLsizei instance_count) {
+  draw_arrays_command *command = append(buffer, sizeof(*command));
+  if (!command) {
+    return -1;
+  }
+  *command = (draw_arrays_command){COMMAND_DRAW_ARRAYS, mode, first, count, instance_count};
+  return 0;
+}
+
+void command_buffer_execute(const command_buffer *buffer) {
+  const char *at = buffer->data;
+  const char *end = at + buffer->size;
+
+  while (at < end) {
+    switch (*(const uint32_t *)at) {
+    case COMMAND_SET_ENABLED: {
+      const set_enabled_command *command = (const void *)at;
+      gl_state_set_enabled(command->cap, command->enabled);
+      at += sizeof(*command);
+      break;
+    }
+    case COMMAND_BLEND_FUNC: {
+      const blend_func_command *command = (const void *)at;
+      gl_state_blend_func(command->src, command->dst);
+      at += sizeof(*command);
+      break;
+    }
+    case COMMAND_DEPTH_MASK: {
+      const depth_mask_command *command = (const void *)at;
+      gl_state_depth_mask(command->mask ? GL_TRUE : GL_FALSE);
+      at += sizeof(*command);
+      break;
+    }
+    case COMMAND_USE_PROGRAM: {
+      const use_program_command *command = (const void *)at;
+      gl_state_use_program(command->program);
+      at += sizeof(*command);
+      break;
+    }
+    case COMMAND_BIND_VERTEX_ARRAY: {
+      const bind_vertex_array_command *command = (const void *)at;
+      gl_state_bind_vertex_array(command->vao);
+      at += sizeof(*command);
+      break;
+    }
+    case COMMAND_BIND_TEXTURE: {
+      const bind_texture_command *command = (const void *)at;
+      gl_state_bind_texture(command->unit, command->target, command->texture);
+      at += sizeof(*command);
+      break;
+    }
+    case COMMAND_UNIFORM_MATRIX4: {
+      const uniform_matrix4_command *command = (const void *)at;
+      gl_state_uniform_matrix4fv(command->location, command->value);
+      at += sizeof(*command);
+      break;
+    }
+    case COMMAND_DRAW_ARRAYS: {
+      const draw_arrays_command *command = (const void *)at;
+      if (command->instance_count > 0) {
+        glDrawArraysInstanced(command->mode, command->first, command->count, command->instance_count);
+      } else {
+        glDrawArrays(command->mode, command->first, command->count);
+      }
+      at += sizeof(*command);
+      break;
+    }
+    default:
+      fprintf(stderr, "ERROR: unknown render command %u, dropping the rest of the buffer.\n",
+              *(const uint32_t *)at);
+      return;
+    }
+  }
+}
@@ -0,0 +1,150 @@
+#include "render/cull.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "math/simd.h"
+#include "utils/frame_stats.h"
+
+
+struct cull_slice {
+  const cull_bounds *bounds;
+  vec4 *planes;
+  int begin, end;
+  uint32_t *out;
+  int count;
+};
+
+int cull_bounds_init(cull_bounds *bounds, int capacity) {
+  memset(bounds, 0, sizeof(*bounds));
+
+  capacity = (capacity + CULL_BATCH - 1) / CULL_BATCH * CULL_BATCH;
+  if (capacity < CULL_BATCH) {
+    capacity = CULL_BATCH;
+  }
+
+  // one block for all six arrays, each starting on a cache line
+  float *data = aligned_alloc(64, 6 * capacity * sizeof(float));
+  if (!data) {
+    fprintf(stderr, "ERROR: could not allocate memory for %i culling bounds.\n", capacity);
+    return -1;
+  }
+
+  bounds->min_x = data;
+  bounds->min_y = data + capacity;
+  bounds->min_z = data + 2 * capacity;
+  bounds->max_x = data + 3 * capacity;
+  bounds->max_y = data + 4 * capacity;
+  bounds->max_z = data + 5 * capacity;
+  bounds->capacity = capacity;
+
+  return 0;
+}
+
+void cull_bounds_free(cull_bounds *bounds) {
+  free(bounds->min_x);
+  memset(bounds, 0, sizeof(*bounds));
+}
+
+int cull_bounds_add(cull_bounds *bounds, vec3 box[2]) {
+  if (bounds->count == bounds->capacity) {
+    cull_bounds grown;
+    if (cull_bounds_init(&grown, bounds->capacity * 2) != 0) {
+      return -1;
+    }
+
+    size_t size = bounds->count * sizeof(float);
+    memcpy(grown.min_x, bounds->min_x, size);
+    memcpy(grown.min_y, bounds->min_y, size);
+    memcpy(grown.min_z, bounds->min_z, size);
+    memcpy(grown.max_x, bounds->max_x, size);
+    memcpy(grown.max_y, bounds->max_y, size);
+    memcpy(grown.max_z, bounds->max_z, size);
+    grown.count = bounds->count;
+
+    cull_bounds_free(bounds);
+    *bounds = grown;
+  }
+
+  int index = bounds->count++;
+  cull_bounds_set(bounds, index, box);
+  return index;
+}
+
+void cull_bounds_set(cull_bounds *bounds, int index, vec3 box[2]) {
+  bounds->min_x[index] = box[0][0];
+  bounds->min_y[index] = box[0][1];
+  bounds->min_z[index] = box[0][2];
+  bounds->max_x[index] = box[1][0];
+  bounds->max_y[index] = box[1][1];
+  bounds->max_z[index] = box[1][2];
+}
+
+static void cull_slice_job(void *context) {
+  cull_slice *slice = context;
+  slice->count = simd.cull_range(slice->bounds, slice->planes, slice->begin, slice->end, slice->out);
+}
+
+int cull_pool_init(cull_pool *pool, job_system *jobs) {
+  memset(pool, 0, sizeof(*pool));
+  pool->jobs = jobs;
+
+  pool->slices = calloc(CULL_MAX_SLICES, sizeof(cull_slice));
+  if (!pool->slices) {
+    fprintf(stderr, "ERROR: could not allocate memory for the culling worker slices.\n");
+    return -1;
+  }
+
+  return 0;
+}
+
+void cull_pool_free(cull_pool *pool) {
+  free(pool->slices);
+  memset(pool, 0, sizeof(*pool));
+}
+
+int cull_frustum(cull_pool *pool, const cull_bounds *bounds, vec4 planes[6], uint32_t *visible) {
+  double start = frame_stats_now_ms();
+  int count = bounds->count;
+  int n;
+
+  if (count < CULL_PARALLEL_THRESHOLD || pool->jobs->num_workers == 0) {
+    n = simd.cull_range(bounds, planes, 0, count, visible);
+  } else {
+    int parts = pool->jobs->num_workers + 1;
+    int per_part = (count + parts - 1) / parts;
+    per_part = (per_part + CULL_BATCH - 1) / CULL_BATCH * CULL_BATCH;
+
+    // each slice writes its indices where its boxes start, compacted afterwards
+    for (int s = 0; s < parts; s++) {
+      cull_slice *slice = &pool->slices[s];
+      slice->bounds = bounds;
+      slice->planes = planes;
+      slice->begin = s * per_part < count ? s * per_part : count;
+      slice->end = slice->begin + per_part < count ? slice->begin + per_part : count;
+      slice->out = visible + slice->begin;
+      slice->count = 0;
+    }
+
+    // slice 0 runs here, the rest wherever a thread is free
+    job_counter pending = 0;
+    for (int s = 1; s < parts; s++) {
+      jobs_run(pool->jobs, cull_slice_job, &pool->slices[s], &pending);
+    }
+    cull_slice *own = &pool->slices[0];
+    cull_slice_job(own);
+    jobs_wait(pool->jobs, &pending);
+
+    n = own->count;
+    for (int s = 1; s < parts; s++) {
+      cull_slice *slice = &pool->slices[s];
+      memmove(visible + n, slice->out, slice->count * sizeof(uint32_t));
+      n += slice->count;
+    }
+  }
+
+  pool->last_stats.tested = count;
+  pool->last_stats.visible = n;
+  pool->last_stats.ms = frame_stats_now_ms() - start;
+  return n;
+}
@@ -0,0 +1,103 @@
+#include "render/cull.h"
+
+#include "math/simd.h"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// cull_range() for each SIMD level, the vector width follows the compiler flags.
+
+
+// one frustum plane with the box corner it is tested against already picked
+typedef struct {
+  const float *x, *y, *z;
+  float a, b, c;
+  float d;  // -w, so a box is outside when a*x + b*y + c*z < d
+} cull_plane;
+
+// same corner choice as glm_aabb_frustum(): the one furthest along the plane normal
+static void select_planes(const cull_bounds *bounds, vec4 planes[6], cull_plane selected[6]) {
+  for (int p = 0; p < 6; p++) {
+    float *plane = planes[p];
+    selected[p].x = plane[0] > 0.0f ? bounds->max_x : bounds->min_x;
+    selected[p].y = plane[1] > 0.0f ? bounds->max_y : bounds->min_y;
+    selected[p].z = plane[2] > 0.0f ? bounds->max_z : bounds->min_z;
+    selected[p].a = plane[0];
+    selected[p].b = plane[1];
+    selected[p].c = plane[2];
+    selected[p].d = -plane[3];
+  }
+}
+
+// begin has to be a multiple of CULL_BATCH so the vector loads stay aligned
+int SIMD_VARIANT(cull_range)(const cull_bounds *bounds, vec4 planes[6], int begin, int end, uint32_t *out) {
+  cull_plane pl[6];
+  select_planes(bounds, planes, pl);
+
+  int n = 0;
+  int i = begin;
+
+#if defined(__AVX512F__)
+  __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  for (; i + 16 <= end; i += 16) {
+    __mmask16 inside = 0xFFFF;
+    for (int p = 0; p < 6; p++) {
+      __m512 dp = _mm512_add_ps(_mm512_add_ps(
+                    _mm512_mul_ps(_mm512_set1_ps(pl[p].a), _mm512_load_ps(pl[p].x + i)),
+                    _mm512_mul_ps(_mm512_set1_ps(pl[p].b), _mm512_load_ps(pl[p].y + i))),
+                    _mm512_mul_ps(_mm512_set1_ps(pl[p].c), _mm512_load_ps(pl[p].z + i)));
+      inside &= _mm512_cmp_ps_mask(dp, _mm512_set1_ps(pl[p].d), _CMP_NLT_UQ);
+    }
+    _mm512_mask_compressstoreu_epi32(out + n, inside, _mm512_add_epi32(_mm512_set1_epi32(i), lanes));
+    n += __builtin_popcount(inside);
+  }
+#elif defined(__AVX2__)
+  for (; i + 8 <= end; i += 8) {
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (int p = 0; p < 6; p++) {
+      __m256 dp = _mm256_add_ps(_mm256_add_ps(
+                    _mm256_mul_ps(_mm256_set1_ps(pl[p].a), _mm256_load_ps(pl[p].x + i)),
+                    _mm256_mul_ps(_mm256_set1_ps(pl[p].b), _mm256_load_ps(pl[p].y + i))),
+                    _mm256_mul_ps(_mm256_set1_ps(pl[p].c), _mm256_load_ps(pl[p].z + i)));
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(dp, _mm256_set1_ps(pl[p].d), _CMP_NLT_UQ));
+    }
+    // every lane is stored, only the visible ones advance n
+    int mask = _mm256_movemask_ps(inside);
+    for (int lane = 0; lane < 8; lane++) {
+      out[n] = i + lane;
+      n += (mask >> lane) & 1;
+    }
+  }
+#elif defined(__SSE2__)
+  for (; i + 4 <= end; i += 4) {
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (int p = 0; p < 6; p++) {
+      __m128 dp = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(_mm_set1_ps(pl[p].a), _mm_load_ps(pl[p].x + i)),
+                    _mm_mul_ps(_mm_set1_ps(pl[p].b), _mm_load_ps(pl[p].y + i))),
+                    _mm_mul_ps(_mm_set1_ps(pl[p].c), _mm_load_ps(pl[p].z + i)));
+      inside = _mm_and_ps(inside, _mm_cmpnlt_ps(dp, _mm_set1_ps(pl[p].d)));
+    }
+    int mask = _mm_movemask_ps(inside);
+    for (int lane = 0; lane < 4; lane++) {
+      out[n] = i + lane;
+      n += (mask >> lane) & 1;
+    }
+  }
+#endif
+
+  for (; i < end; i++) {
+    int inside = 1;
+    for (int p = 0; p < 6; p++) {
+      float dp = pl[p].a * pl[p].x[i] + pl[p].b * pl[p].y[i] + pl[p].c * pl[p].z[i];
+      inside &= !(dp < pl[p].d);
+    }
+    out[n] = i;
+    n += inside;
+  }
+
+  return n;
+}
@@ -0,0 +1,122 @@
+#include "render/frame_pipeline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static void simulate_into(frame_pipeline *pipeline, render_snapshot *snapshot, unsigned long frame) {
+  snapshot->frame = frame;
+  arena_reset(&snapshot->memory);
+  glm_mat4_identity(snapshot->view_projection);
+  pipeline->simulate(pipeline->context, snapshot);
+  render_queue_record(&snapshot->queue, pipeline->jobs);
+}
+
+static void *simulate_main(void *arg) {
+  frame_pipeline *pipeline = arg;
+
+  pthread_mutex_lock(&pipeline->lock);
+  for (;;) {
+    // every snapshot is either ready or still being drawn
+    while (!pipeline->quit && pipeline->produced - pipeline->released >= pipeline->num_snapshots) {
+      pthread_cond_wait(&pipeline->released_cond, &pipeline->lock);
+    }
+    if (pipeline->quit) {
+      break;
+    }
+    unsigned long frame = pipeline->produced;
+    pthread_mutex_unlock(&pipeline->lock);
+
+    simulate_into(pipeline, &pipeline->snapshots[frame % pipeline->num_snapshots], frame);
+
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->produced++;
+    pthread_cond_signal(&pipeline->produced_cond);
+  }
+  pthread_mutex_unlock(&pipeline->lock);
+
+  return NULL;
+}
+
+int frame_pipeline_init(frame_pipeline *pipeline, int latency, size_t frame_memory, job_system *jobs,
+                        frame_simulate_fn simulate, void *context) {
+  memset(pipeline, 0, sizeof(*pipeline));
+
+  if (latency < 0) {
+    latency = 0;
+  }
+  if (latency > FRAME_PIPELINE_MAX_LATENCY) {
+    latency = FRAME_PIPELINE_MAX_LATENCY;
+  }
+  pipeline->num_snapshots = latency + 1;
+  pipeline->simulate = simulate;
+  pipeline->context = context;
+  pipeline->jobs = jobs;
+
+  pthread_mutex_init(&pipeline->lock, NULL);
+  pthread_cond_init(&pipeline->produced_cond, NULL);
+  pthread_cond_init(&pipeline->released_cond, NULL);
+
+  for (int i = 0; i < pipeline->num_snapshots; i++) {
+    if (render_queue_init(&pipeline->snapshots[i].queue, 0) != 0 ||
+        arena_init(&pipeline->snapshots[i].memory, frame_memory) != 0) {
+      frame_pipeline_free(pipeline);
+      return -1;
+    }
+  }
+
+  if (latency > 0) {
+    if (pthread_create(&pipeline->thread, NULL, simulate_main, pipeline) != 0) {
+      fprintf(stderr, "ERROR: could not start the simulation thread.\n");
+      frame_pipeline_free(pipeline);
+      return -1;
+    }
+    pipeline->threaded = 1;
+  }
+
+  return 0;
+}
+
+void frame_pipeline_free(frame_pipeline *pipeline) {
+  if (pipeline->threaded) {
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->quit = 1;
+    pthread_cond_broadcast(&pipeline->released_cond);
+    pthread_mutex_unlock(&pipeline->lock);
+    pthread_join(pipeline->thread, NULL);
+  }
+
+  for (int i = 0; i < FRAME_PIPELINE_MAX_LATENCY + 1; i++) {
+    render_queue_free(&pipeline->snapshots[i].queue);
+    arena_free(&pipeline->snapshots[i].memory);
+  }
+
+  pthread_cond_destroy(&pipeline->released_cond);
+  pthread_cond_destroy(&pipeline->produced_cond);
+  pthread_mutex_destroy(&pipeline->lock);
+  memset(pipeline, 0, sizeof(*pipeline));
+}
+
+render_snapshot *frame_pipeline_acquire(frame_pipeline *pipeline) {
+  render_snapshot *snapshot = &pipeline->snapshots[pipeline->released % pipeline->num_snapshots];
+
+  if (!pipeline->threaded) {
+    simulate_into(pipeline, snapshot, pipeline->released);
+    pipeline->produced++;
+  } else {
+    pthread_mutex_lock(&pipeline->lock);
+    while (pipeline->produced == pipeline->released) {
+      pthread_cond_wait(&pipeline->produced_cond, &pipeline->lock);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+  }
+  return snapshot;
+}
+
+void frame_pipeline_release(frame_pipeline *pipeline) {
+  pthread_mutex_lock(&pipeline->lock);
+  pipeline->released++;
+  pthread_cond_signal(&pipeline->released_cond);
+  pthread_mutex_unlock(&pipeline->lock);
+}
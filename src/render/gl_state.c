@@ -0,0 +1,400 @@
+#include "render/gl_state.h"
+
+#include <string.h>
+
+
+#define UNKNOWN 0xFFFFFFFFu
+
+enum {
+  BUFFER_ARRAY,
+  BUFFER_ELEMENT_ARRAY,
+  BUFFER_UNIFORM,
+  BUFFER_PIXEL_PACK,
+  BUFFER_PIXEL_UNPACK,
+  BUFFER_COPY_READ,
+  BUFFER_COPY_WRITE,
+  BUFFER_TEXTURE,
+  NUM_BUFFER_TARGETS
+};
+
+enum {
+  TEXTURE_2D,
+  TEXTURE_2D_ARRAY,
+  TEXTURE_CUBE_MAP,
+  TEXTURE_BUFFER,
+  NUM_TEXTURE_TARGETS
+};
+
+enum {
+  CAP_BLEND,
+  CAP_DEPTH_TEST,
+  CAP_CULL_FACE,
+  CAP_SCISSOR_TEST,
+  NUM_CAPS
+};
+
+// open addressing, sized so a few hundred programs worth of uniforms fit comfortably
+#define UNIFORM_CACHE_SIZE 4096
+
+typedef struct {
+  GLuint program;
+  GLint location;
+  int num_values;
+  union {
+    GLfloat f[16];
+    GLint i;
+  } value;
+} uniform_entry;
+
+static struct {
+  GLuint program;
+  GLuint vao;
+  GLuint buffers[NUM_BUFFER_TARGETS];
+  GLuint draw_framebuffer;
+  GLuint read_framebuffer;
+  GLuint active_unit;
+  GLuint textures[GL_STATE_MAX_TEXTURE_UNITS][NUM_TEXTURE_TARGETS];
+  GLuint caps[NUM_CAPS];
+  GLuint blend_src, blend_dst;
+  GLuint depth_func;
+  GLuint depth_mask;
+  GLint viewport[4];
+  int viewport_known;
+} state;
+
+static uniform_entry uniforms[UNIFORM_CACHE_SIZE];
+
+static gl_state_counters frame_counters, last_frame_counters, total_counters;
+
+static void issued(void) {
+  frame_counters.issued++;
+  total_counters.issued++;
+}
+
+static void elided(void) {
+  frame_counters.elided++;
+  total_counters.elided++;
+}
+
+static int buffer_index(GLenum target) {
+  switch (target) {
+  case GL_ARRAY_BUFFER: return BUFFER_ARRAY;
+  case GL_ELEMENT_ARRAY_BUFFER: return BUFFER_ELEMENT_ARRAY;
+  case GL_UNIFORM_BUFFER: return BUFFER_UNIFORM;
+  case GL_PIXEL_PACK_BUFFER: return BUFFER_PIXEL_PACK;
+  case GL_PIXEL_UNPACK_BUFFER: return BUFFER_PIXEL_UNPACK;
+  case GL_COPY_READ_BUFFER: return BUFFER_COPY_READ;
+  case GL_COPY_WRITE_BUFFER: return BUFFER_COPY_WRITE;
+  case GL_TEXTURE_BUFFER: return BUFFER_TEXTURE;
+  default: return -1;
+  }
+}
+
+static int texture_index(GLenum target) {
+  switch (target) {
+  case GL_TEXTURE_2D: return TEXTURE_2D;
+  case GL_TEXTURE_2D_ARRAY: return TEXTURE_2D_ARRAY;
+  case GL_TEXTURE_CUBE_MAP: return TEXTURE_CUBE_MAP;
+  case GL_TEXTURE_BUFFER: return TEXTURE_BUFFER;
+  default: return -1;
+  }
+}
+
+static int cap_index(GLenum cap) {
+  switch (cap) {
+  case GL_BLEND: return CAP_BLEND;
+  case GL_DEPTH_TEST: return CAP_DEPTH_TEST;
+  case GL_CULL_FACE: return CAP_CULL_FACE;
+  case GL_SCISSOR_TEST: return CAP_SCISSOR_TEST;
+  default: return -1;
+  }
+}
+
+void gl_state_invalidate(void) {
+  memset(&state, 0xFF, sizeof(state));
+  state.viewport_known = 0;
+  memset(uniforms, 0, sizeof(uniforms));
+}
+
+void gl_state_begin_frame(void) {
+  last_frame_counters = frame_counters;
+  frame_counters.issued = 0;
+  frame_counters.elided = 0;
+}
+
+gl_state_counters gl_state_last_frame(void) {
+  return last_frame_counters;
+}
+
+gl_state_counters gl_state_total(void) {
+  return total_counters;
+}
+
+void gl_state_use_program(GLuint program) {
+  if (state.program == program) {
+    elided();
+    return;
+  }
+  glUseProgram(program);
+  state.program = program;
+  issued();
+}
+
+void gl_state_bind_vertex_array(GLuint vao) {
+  if (state.vao == vao) {
+    elided();
+    return;
+  }
+  glBindVertexArray(vao);
+  state.vao = vao;
+  // the element array binding belongs to the VAO
+  state.buffers[BUFFER_ELEMENT_ARRAY] = UNKNOWN;
+  issued();
+}
+
+void gl_state_bind_buffer(GLenum target, GLuint buffer) {
+  int index = buffer_index(target);
+  if (index >= 0 && state.buffers[index] == buffer) {
+    elided();
+    return;
+  }
+  glBindBuffer(target, buffer);
+  if (index >= 0) {
+    state.buffers[index] = buffer;
+  }
+  issued();
+}
+
+void gl_state_bind_framebuffer(GLenum target, GLuint framebuffer) {
+  int draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+  int read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+
+  if ((!draw || state.draw_framebuffer == framebuffer) && (!read || state.read_framebuffer == framebuffer)) {
+    elided();
+    return;
+  }
+  glBindFramebuffer(target, framebuffer);
+  if (draw) {
+    state.draw_framebuffer = framebuffer;
+  }
+  if (read) {
+    state.read_framebuffer = framebuffer;
+  }
+  issued();
+}
+
+void gl_state_bind_texture(GLuint unit, GLenum target, GLuint texture) {
+  int index = texture_index(target);
+  if (unit < GL_STATE_MAX_TEXTURE_UNITS && index >= 0 && state.textures[unit][index] == texture) {
+    elided();
+    return;
+  }
+
+  if (state.active_unit != unit) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    state.active_unit = unit;
+    issued();
+  }
+
+  glBindTexture(target, texture);
+  if (unit < GL_STATE_MAX_TEXTURE_UNITS && index >= 0) {
+    state.textures[unit][index] = texture;
+  }
+  issued();
+}
+
+void gl_state_set_enabled(GLenum cap, int enabled) {
+  int index = cap_index(cap);
+  GLuint value = enabled ? 1 : 0;
+  if (index >= 0 && state.caps[index] == value) {
+    elided();
+    return;
+  }
+  if (enabled) {
+    glEnable(cap);
+  } else {
+    glDisable(cap);
+  }
+  if (index >= 0) {
+    state.caps[index] = value;
+  }
+  issued();
+}
+
+void gl_state_blend_func(GLenum src, GLenum dst) {
+  if (state.blend_src == src && state.blend_dst == dst) {
+    elided();
+    return;
+  }
+  glBlendFunc(src, dst);
+  state.blend_src = src;
+  state.blend_dst = dst;
+  issued();
+}
+
+void gl_state_depth_func(GLenum func) {
+  if (state.depth_func == func) {
+    elided();
+    return;
+  }
+  glDepthFunc(func);
+  state.depth_func = func;
+  issued();
+}
+
+void gl_state_depth_mask(GLboolean mask) {
+  if (state.depth_mask == mask) {
+    elided();
+    return;
+  }
+  glDepthMask(mask);
+  state.depth_mask = mask;
+  issued();
+}
+
+void gl_state_viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  if (state.viewport_known == 1 && state.viewport[0] == x && state.viewport[1] == y &&
+      state.viewport[2] == width && state.viewport[3] == height) {
+    elided();
+    return;
+  }
+  glViewport(x, y, width, height);
+  state.viewport[0] = x;
+  state.viewport[1] = y;
+  state.viewport[2] = width;
+  state.viewport[3] = height;
+  state.viewport_known = 1;
+  issued();
+}
+
+// finds the slot for (current program, location); a free slot if it isn't cached yet,
+// NULL if the table is full. Deleted entries are left as tombstones (num_values == -1)
+// so probe chains stay intact, and get reused on insert.
+static uniform_entry *find_uniform(GLint location) {
+  GLuint program = state.program;
+  unsigned hash = (program * 2654435761u) ^ ((unsigned)location * 40503u);
+  uniform_entry *tombstone = NULL;
+
+  for (int i = 0; i < UNIFORM_CACHE_SIZE; i++) {
+    uniform_entry *e = &uniforms[(hash + i) & (UNIFORM_CACHE_SIZE - 1)];
+    if (e->num_values == 0) {
+      return tombstone ? tombstone : e;
+    }
+    if (e->num_values < 0) {
+      if (!tombstone) {
+        tombstone = e;
+      }
+    } else if (e->program == program && e->location == location) {
+      return e;
+    }
+  }
+
+  return tombstone;
+}
+
+// returns 1 if the value is already current, otherwise records it and returns 0
+static int uniform_cached(GLint location, const void *value, int num_values) {
+  // an unknown program could be anything, and -1 is silently ignored by GL anyway
+  if (state.program == UNKNOWN || location < 0) {
+    return 0;
+  }
+
+  uniform_entry *e = find_uniform(location);
+  if (!e) {
+    return 0;
+  }
+
+  size_t size = num_values * sizeof(GLfloat);
+  if (e->num_values == num_values && memcmp(&e->value, value, size) == 0) {
+    return 1;
+  }
+
+  e->program = state.program;
+  e->location = location;
+  e->num_values = num_values;
+  memcpy(&e->value, value, size);
+  return 0;
+}
+
+void gl_state_uniform1i(GLint location, GLint value) {
+  if (uniform_cached(location, &value, 1)) {
+    elided();
+    return;
+  }
+  glUniform1i(location, value);
+  issued();
+}
+
+void gl_state_uniform1f(GLint location, GLfloat value) {
+  if (uniform_cached(location, &value, 1)) {
+    elided();
+    return;
+  }
+  glUniform1f(location, value);
+  issued();
+}
+
+void gl_state_uniform4fv(GLint location, const GLfloat *value) {
+  if (uniform_cached(location, value, 4)) {
+    elided();
+    return;
+  }
+  glUniform4fv(location, 1, value);
+  issued();
+}
+
+void gl_state_uniform_matrix4fv(GLint location, const GLfloat *value) {
+  if (uniform_cached(location, value, 16)) {
+    elided();
+    return;
+  }
+  glUniformMatrix4fv(location, 1, GL_FALSE, value);
+  issued();
+}
+
+void gl_state_delete_program(GLuint program) {
+  glDeleteProgram(program);
+  if (state.program == program) {
+    state.program = UNKNOWN;
+  }
+
+  for (int i = 0; i < UNIFORM_CACHE_SIZE; i++) {
+    if (uniforms[i].num_values > 0 && uniforms[i].program == program) {
+      uniforms[i].num_values = -1;
+    }
+  }
+}
+
+void gl_state_delete_vertex_arrays(GLsizei n, const GLuint *vaos) {
+  glDeleteVertexArrays(n, vaos);
+  for (int i = 0; i < n; i++) {
+    if (state.vao == vaos[i]) {
+      state.vao = UNKNOWN;
+      state.buffers[BUFFER_ELEMENT_ARRAY] = UNKNOWN;
+    }
+  }
+}
+
+void gl_state_delete_buffers(GLsizei n, const GLuint *buffers) {
+  glDeleteBuffers(n, buffers);
+  for (int i = 0; i < n; i++) {
+    for (int t = 0; t < NUM_BUFFER_TARGETS; t++) {
+      if (state.buffers[t] == buffers[i]) {
+        state.buffers[t] = UNKNOWN;
+      }
+    }
+  }
+}
+
+void gl_state_delete_textures(GLsizei n, const GLuint *textures) {
+  glDeleteTextures(n, textures);
+  for (int i = 0; i < n; i++) {
+    for (int u = 0; u < GL_STATE_MAX_TEXTURE_UNITS; u++) {
+      for (int t = 0; t < NUM_TEXTURE_TARGETS; t++) {
+        if (state.textures[u][t] == textures[i]) {
+          state.textures[u][t] = UNKNOWN;
+        }
+      }
+    }
+  }
+}
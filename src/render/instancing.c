@@ -0,0 +1,58 @@
+#include "render/instancing.h"
+
+#include <stdio.h>
+#include "render/gl_state.h"
+
+
+int instance_buffer_init(instance_buffer *instances) {
+  instances->count = 0;
+
+  glGenVertexArrays(1, &instances->vao);
+  gl_state_bind_vertex_array(instances->vao);
+
+  // a mat4 attribute is really four vec4 attributes, one per column; where they
+  // point is set on every upload
+  for (int column = 0; column < 4; column++) {
+    glVertexAttribDivisor(INSTANCE_MODEL_ATTRIB + column, 1);
+  }
+
+  if (glGetError() != GL_NO_ERROR) {
+    fprintf(stderr, "ERROR: could not set up instance attributes.\n");
+    instance_buffer_free(instances);
+    return -1;
+  }
+
+  return 0;
+}
+
+void instance_buffer_free(instance_buffer *instances) {
+  if (instances->vao) {
+    gl_state_delete_vertex_arrays(1, &instances->vao);
+  }
+  instances->vao = 0;
+  instances->count = 0;
+}
+
+int instance_buffer_upload(instance_buffer *instances, ring_buffer *ring, const mat4 *models, GLsizei count) {
+  instances->count = 0;
+  if (count == 0) {
+    return 0;
+  }
+
+  GLintptr offset = ring_buffer_write(ring, models, count * sizeof(mat4), sizeof(vec4));
+  if (offset < 0) {
+    fprintf(stderr, "ERROR: no room in the stream buffer for %i instances.\n", count);
+    return -1;
+  }
+
+  gl_state_bind_vertex_array(instances->vao);
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, ring->buffer);
+  for (int column = 0; column < 4; column++) {
+    glVertexAttribPointer(INSTANCE_MODEL_ATTRIB + column, 4, GL_FLOAT, GL_FALSE, sizeof(mat4),
+                          (void *)(offset + column * sizeof(vec4)));
+    glEnableVertexAttribArray(INSTANCE_MODEL_ATTRIB + column);
+  }
+
+  instances->count = count;
+  return 0;
+}
@@ -0,0 +1,196 @@
+#include "render/program_cache.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "render/shader.h"
+#include "utils/file_read.h"
+
+
+#define CACHE_MAGIC 0x42504c47u // "GLPB"
+#define CACHE_VERSION 1
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+  uint32_t format;
+  uint32_t length;
+} cache_header;
+
+// FNV-1a, chained through seed so several strings hash as one
+static uint64_t hash_string(uint64_t seed, const char *s) {
+  uint64_t h = seed;
+  if (s) {
+    while (*s) {
+      h ^= (unsigned char)*s++;
+      h *= 0x100000001b3ull;
+    }
+  }
+  // terminator, so ("ab", "c") and ("a", "bc") differ
+  h ^= 0xff;
+  h *= 0x100000001b3ull;
+  return h;
+}
+
+int program_cache_init(program_cache *cache, const char *dir) {
+  memset(cache, 0, sizeof(*cache));
+  snprintf(cache->dir, sizeof(cache->dir), "%s", dir);
+
+  uint64_t h = 0xcbf29ce484222325ull;
+  h = hash_string(h, (const char *)glGetString(GL_VENDOR));
+  h = hash_string(h, (const char *)glGetString(GL_RENDERER));
+  h = hash_string(h, (const char *)glGetString(GL_VERSION));
+  cache->driver_hash = h;
+
+  if (!GLAD_GL_ARB_get_program_binary) {
+    printf("Program binary cache disabled: GL_ARB_get_program_binary not supported.\n");
+    return 0;
+  }
+
+  GLint num_formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+  if (num_formats < 1) {
+    printf("Program binary cache disabled: driver offers no binary formats.\n");
+    return 0;
+  }
+
+  if (mkdir(cache->dir, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "ERROR: could not create the program cache directory \"%s\".\n", cache->dir);
+    return -1;
+  }
+
+  cache->enabled = 1;
+  return 0;
+}
+
+static void cache_path(const program_cache *cache, uint64_t key, char *path, size_t size) {
+  snprintf(path, size, "%s/%016llx.bin", cache->dir, (unsigned long long)key);
+}
+
+uint64_t program_cache_key(const program_cache *cache, const char *vs_src, const char *fs_src, const char *defines) {
+  uint64_t key = cache->driver_hash;
+  key = hash_string(key, defines);
+  key = hash_string(key, vs_src);
+  key = hash_string(key, fs_src);
+  return key;
+}
+
+// a missing file is the normal cache miss, so nothing is printed for it
+GLuint program_cache_load(program_cache *cache, uint64_t key) {
+  if (!cache->enabled) {
+    cache->misses++;
+    return 0;
+  }
+
+  char path[512];
+  cache_path(cache, key, path, sizeof(path));
+
+  // mapped, so the driver reads the binary straight out of the page cache
+  file_view file;
+  if (file_map(path, &file) != FILE_OK) {
+    cache->misses++;
+    return 0;
+  }
+
+  GLuint program = 0;
+  const cache_header *header = (const cache_header *)file.data;
+
+  if (file.size >= sizeof(cache_header) && header->magic == CACHE_MAGIC && header->version == CACHE_VERSION &&
+      header->key == key && file.size - sizeof(cache_header) >= header->length) {
+    program = glCreateProgram();
+    glProgramBinary(program, header->format, file.data + sizeof(cache_header), header->length);
+
+    // a driver update or a different GPU rejects the binary at "link" time
+    int is_linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &is_linked);
+    if (is_linked == GL_FALSE) {
+      glDeleteProgram(program);
+      program = 0;
+    }
+  }
+
+  file_release(&file);
+
+  if (!program) {
+    cache->rejected++;
+    cache->misses++;
+    remove(path);
+    return 0;
+  }
+
+  cache->hits++;
+  return program;
+}
+
+void program_cache_store(program_cache *cache, uint64_t key, GLuint program) {
+  if (!cache->enabled) {
+    return;
+  }
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return;
+  }
+
+  void *binary = malloc(length);
+  if (!binary) {
+    fprintf(stderr, "ERROR: could not allocate memory for a %i byte program binary.\n", length);
+    return;
+  }
+
+  cache_header header = { CACHE_MAGIC, CACHE_VERSION, key, 0, 0 };
+  GLenum format = 0;
+  GLsizei written = 0;
+  glGetProgramBinary(program, length, &written, &format, binary);
+  header.format = format;
+  header.length = written;
+
+  char path[512], tmp_path[520];
+  cache_path(cache, key, path, sizeof(path));
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+  // written aside and renamed, so a crash never leaves a torn binary behind
+  FILE *file = fopen(tmp_path, "wb");
+  if (!file) {
+    fprintf(stderr, "ERROR: could not open \"%s\" for writing.\n", tmp_path);
+    free(binary);
+    return;
+  }
+
+  int ok = written > 0 && fwrite(&header, sizeof(header), 1, file) == 1 &&
+           fwrite(binary, 1, written, file) == (size_t)written;
+  ok = fclose(file) == 0 && ok;
+
+  if (!ok || rename(tmp_path, path) != 0) {
+    fprintf(stderr, "ERROR: could not write \"%s\".\n", path);
+    remove(tmp_path);
+  }
+
+  free(binary);
+}
+
+GLuint program_cache_get(program_cache *cache, const char *vs_src, const char *fs_src, const char *defines) {
+  uint64_t key = program_cache_key(cache, vs_src, fs_src, defines);
+
+  GLuint program = program_cache_load(cache, key);
+  if (program) {
+    return program;
+  }
+
+  GLuint vert = shader_compile(GL_VERTEX_SHADER, vs_src, defines);
+  GLuint frag = vert ? shader_compile(GL_FRAGMENT_SHADER, fs_src, defines) : 0;
+  program = frag ? shader_link(vert, frag, cache->enabled) : 0;
+
+  glDeleteShader(vert);
+  glDeleteShader(frag);
+
+  if (program) {
+    program_cache_store(cache, key, program);
+  }
+
+  return program;
+}
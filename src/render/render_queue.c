@@ -0,0 +1,287 @@
+#include "render/render_queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "render/gl_state.h"
+#include "utils/frame_stats.h"
+
+
+#define PROGRAM_BITS 11
+#define MATERIAL_BITS 16
+#define DEPTH_BITS 24
+#define DEPTH_MAX ((1u << DEPTH_BITS) - 1)
+
+// 12-bit digits over the 56 used key bits: five passes at most, and only two
+// when packets differ just by depth
+#define RADIX_BITS 12
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_MASK (RADIX_SIZE - 1)
+#define KEY_FIRST_BIT 8
+#define RADIX_PASSES 5
+
+typedef struct {
+  render_queue *queue;
+  int buffer;
+  int begin, end;
+  int state_changes;
+  int failed;
+} record_slice;
+
+uint64_t render_queue_make_key(unsigned layer, int translucent, unsigned program, unsigned material, float depth) {
+  if (depth < 0.0f) {
+    depth = 0.0f;
+  } else if (depth > 1.0f) {
+    depth = 1.0f;
+  }
+  uint64_t quantized = (uint64_t)(depth * DEPTH_MAX);
+
+  uint64_t key = (uint64_t)(layer & (RENDER_QUEUE_MAX_LAYERS - 1)) << 60;
+  uint64_t state = ((uint64_t)(program & ((1u << PROGRAM_BITS) - 1)) << MATERIAL_BITS) |
+                   (material & ((1u << MATERIAL_BITS) - 1));
+
+  if (translucent) {
+    // blending needs back to front, so depth has to win over state here
+    key |= 1ull << 59;
+    key |= (DEPTH_MAX - quantized) << (PROGRAM_BITS + MATERIAL_BITS + 8);
+    key |= state << 8;
+  } else {
+    key |= state << (DEPTH_BITS + 8);
+    key |= quantized << 8;
+  }
+
+  return key;
+}
+
+int render_queue_init(render_queue *queue, int capacity) {
+  memset(queue, 0, sizeof(*queue));
+  queue->capacity = capacity > 0 ? capacity : 1024;
+
+  queue->packets = malloc(queue->capacity * sizeof(draw_packet));
+  queue->items = malloc(queue->capacity * sizeof(sort_item));
+  queue->scratch = malloc(queue->capacity * sizeof(sort_item));
+
+  if (!queue->packets || !queue->items || !queue->scratch) {
+    fprintf(stderr, "ERROR: could not allocate memory for %i render packets.\n", queue->capacity);
+    render_queue_free(queue);
+    return -1;
+  }
+
+  return 0;
+}
+
+void render_queue_free(render_queue *queue) {
+  for (int i = 0; i < RENDER_QUEUE_MAX_BUFFERS; i++) {
+    command_buffer_free(&queue->buffers[i]);
+  }
+  free(queue->packets);
+  free(queue->items);
+  free(queue->scratch);
+  memset(queue, 0, sizeof(*queue));
+}
+
+static int grow(render_queue *queue) {
+  int capacity = queue->capacity * 2;
+
+  draw_packet *packets = realloc(queue->packets, capacity * sizeof(draw_packet));
+  if (packets) {
+    queue->packets = packets;
+  }
+  sort_item *items = realloc(queue->items, capacity * sizeof(sort_item));
+  if (items) {
+    queue->items = items;
+  }
+  sort_item *scratch = realloc(queue->scratch, capacity * sizeof(sort_item));
+  if (scratch) {
+    queue->scratch = scratch;
+  }
+
+  if (!packets || !items || !scratch) {
+    fprintf(stderr, "ERROR: could not grow the render queue to %i packets.\n", capacity);
+    return -1;
+  }
+
+  queue->capacity = capacity;
+  return 0;
+}
+
+static int changes_state(const draw_packet *a, const draw_packet *b) {
+  return a->program != b->program || a->vao != b->vao || a->texture != b->texture;
+}
+
+int render_queue_push(render_queue *queue, uint64_t key, const draw_packet *packet) {
+  if (queue->count == queue->capacity && grow(queue) != 0) {
+    return -1;
+  }
+
+  int index = queue->count++;
+  queue->packets[index] = *packet;
+  queue->items[index].key = key;
+  queue->items[index].packet = index;
+
+  if (index == 0 || changes_state(&queue->packets[index - 1], packet)) {
+    queue->unsorted_state_changes++;
+  }
+
+  return 0;
+}
+
+void render_queue_sort(render_queue *queue) {
+  int count = queue->count;
+  sort_item *src = queue->items;
+  sort_item *dst = queue->scratch;
+
+  // every histogram in a single read over the keys
+  uint32_t histograms[RADIX_PASSES][RADIX_SIZE];
+  memset(histograms, 0, sizeof(histograms));
+
+  for (int i = 0; i < count; i++) {
+    uint64_t key = src[i].key;
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+      histograms[pass][(key >> (KEY_FIRST_BIT + pass * RADIX_BITS)) & RADIX_MASK]++;
+    }
+  }
+
+  for (int pass = 0; pass < RADIX_PASSES; pass++) {
+    uint32_t *histogram = histograms[pass];
+    int shift = KEY_FIRST_BIT + pass * RADIX_BITS;
+
+    // unused key bits (and digits every packet agrees on) would be a pointless copy
+    if (count == 0 || histogram[(src[0].key >> shift) & RADIX_MASK] == (uint32_t)count) {
+      continue;
+    }
+
+    uint32_t offset = 0;
+    for (int digit = 0; digit < RADIX_SIZE; digit++) {
+      uint32_t n = histogram[digit];
+      histogram[digit] = offset;
+      offset += n;
+    }
+
+    for (int i = 0; i < count; i++) {
+      dst[histogram[(src[i].key >> shift) & RADIX_MASK]++] = src[i];
+    }
+
+    sort_item *tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+
+  queue->items = src;
+  queue->scratch = dst;
+}
+
+// everything a packet needs, minus the state its buffer already has set
+static int record_packet(command_buffer *buffer, const draw_packet *packet) {
+  // translucent packets blend over what is behind them and leave depth alone
+  int translucent = packet->translucent != 0;
+  if (command_buffer_set_enabled(buffer, GL_BLEND, translucent) != 0 ||
+      command_buffer_depth_mask(buffer, !translucent) != 0) {
+    return -1;
+  }
+  if (translucent && command_buffer_blend_func(buffer, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) != 0) {
+    return -1;
+  }
+  if (command_buffer_use_program(buffer, packet->program) != 0 ||
+      command_buffer_bind_vertex_array(buffer, packet->vao) != 0) {
+    return -1;
+  }
+  if (packet->texture && command_buffer_bind_texture(buffer, 0, GL_TEXTURE_2D, packet->texture) != 0) {
+    return -1;
+  }
+  if (packet->transform_loc >= 0 &&
+      command_buffer_uniform_matrix4(buffer, packet->transform_loc, &packet->transform[0][0]) != 0) {
+    return -1;
+  }
+  return command_buffer_draw_arrays(buffer, packet->mode, packet->first, packet->count, packet->instance_count);
+}
+
+static void record_range(void *context) {
+  record_slice *slice = context;
+  const render_queue *queue = slice->queue;
+  command_buffer *buffer = &slice->queue->buffers[slice->buffer];
+  command_buffer_reset(buffer);
+
+  // compared with the packet before the range too, so the counts add up
+  const draw_packet *previous = slice->begin > 0 ? &queue->packets[queue->items[slice->begin - 1].packet] : NULL;
+  for (int i = slice->begin; i < slice->end; i++) {
+    const draw_packet *packet = &queue->packets[queue->items[i].packet];
+    if (!previous || changes_state(previous, packet)) {
+      slice->state_changes++;
+    }
+    previous = packet;
+
+    if (record_packet(buffer, packet) != 0) {
+      slice->failed = 1;
+      return;
+    }
+  }
+}
+
+void render_queue_record(render_queue *queue, job_system *jobs) {
+  double start = frame_stats_now_ms();
+  render_queue_sort(queue);
+  double sorted = frame_stats_now_ms();
+
+  int count = queue->count;
+  int parts = (count + RENDER_QUEUE_MIN_RECORD - 1) / RENDER_QUEUE_MIN_RECORD;
+  int threads = jobs ? jobs->num_workers + 1 : 1;
+  if (parts > threads) {
+    parts = threads;
+  }
+  if (parts > RENDER_QUEUE_MAX_BUFFERS) {
+    parts = RENDER_QUEUE_MAX_BUFFERS;
+  }
+  if (parts < 1) {
+    parts = 1;
+  }
+
+  record_slice slices[RENDER_QUEUE_MAX_BUFFERS];
+  for (int s = 0; s < parts; s++) {
+    slices[s] = (record_slice){queue, s, (long)count * s / parts, (long)count * (s + 1) / parts, 0, 0};
+  }
+
+  // slice 0 here, the rest wherever a thread is free
+  job_counter pending = 0;
+  for (int s = 1; s < parts; s++) {
+    jobs_run(jobs, record_range, &slices[s], &pending);
+  }
+  record_range(&slices[0]);
+  if (parts > 1) {
+    jobs_wait(jobs, &pending);
+  }
+
+  render_queue_stats *stats = &queue->last_stats;
+  stats->packets = count;
+  stats->unsorted_state_changes = queue->unsorted_state_changes;
+  stats->state_changes = 0;
+  stats->buffers = parts;
+  for (int s = 0; s < parts; s++) {
+    stats->state_changes += slices[s].state_changes;
+    if (slices[s].failed) {
+      fprintf(stderr, "ERROR: render commands for packets %i to %i were dropped.\n", slices[s].begin, slices[s].end);
+    }
+  }
+  stats->sort_ms = sorted - start;
+  stats->record_ms = frame_stats_now_ms() - sorted;
+
+  queue->num_buffers = parts;
+  queue->count = 0;
+  queue->unsorted_state_changes = 0;
+}
+
+void render_queue_execute(render_queue *queue) {
+  for (int i = 0; i < queue->num_buffers; i++) {
+    command_buffer_execute(&queue->buffers[i]);
+  }
+  queue->num_buffers = 0;
+
+  // translucent packets sort last, so undo them for whatever is drawn next
+  gl_state_set_enabled(GL_BLEND, 0);
+  gl_state_depth_mask(GL_TRUE);
+}
+
+void render_queue_submit(render_queue *queue, job_system *jobs) {
+  render_queue_record(queue, jobs);
+  render_queue_execute(queue);
+}
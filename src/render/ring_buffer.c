@@ -0,0 +1,116 @@
+#include "render/ring_buffer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "render/gl_state.h"
+
+
+// one second; if the GPU is that far behind something else is badly wrong
+#define FENCE_TIMEOUT_NS 1000000000ull
+
+int ring_buffer_init(ring_buffer *ring, GLenum target, GLsizeiptr frame_size) {
+  memset(ring, 0, sizeof(*ring));
+  ring->target = target;
+  ring->frame_size = frame_size;
+
+  glGenBuffers(1, &ring->buffer);
+  gl_state_bind_buffer(target, ring->buffer);
+  glBufferData(target, frame_size * RING_BUFFER_FRAMES, NULL, GL_STREAM_DRAW);
+
+  if (glGetError() != GL_NO_ERROR) {
+    fprintf(stderr, "ERROR: could not allocate a %li byte ring buffer.\n", (long)(frame_size * RING_BUFFER_FRAMES));
+    ring_buffer_free(ring);
+    return -1;
+  }
+
+  return 0;
+}
+
+void ring_buffer_free(ring_buffer *ring) {
+  ring_buffer_unmap(ring);
+  for (int i = 0; i < RING_BUFFER_FRAMES; i++) {
+    if (ring->fences[i]) {
+      glDeleteSync(ring->fences[i]);
+    }
+  }
+  if (ring->buffer) {
+    gl_state_delete_buffers(1, &ring->buffer);
+  }
+  memset(ring, 0, sizeof(*ring));
+}
+
+int ring_buffer_alloc(ring_buffer *ring, GLsizeiptr size, GLsizeiptr alignment, ring_allocation *out) {
+  ring_buffer_unmap(ring);
+
+  GLsizeiptr start = (ring->head + alignment - 1) & ~(alignment - 1);
+  if (start + size > ring->frame_size) {
+    return -1;
+  }
+
+  GLintptr offset = ring->frame * ring->frame_size + start;
+
+  gl_state_bind_buffer(ring->target, ring->buffer);
+  // the fence in ring_buffer_end_frame already guarantees the GPU is done with this region
+  void *ptr = glMapBufferRange(ring->target, offset, size,
+                               GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+  if (!ptr) {
+    fprintf(stderr, "ERROR: could not map %li bytes of ring buffer.\n", (long)size);
+    return -1;
+  }
+
+  ring->mapped = 1;
+  ring->head = start + size;
+  if (ring->head > ring->high_water) {
+    ring->high_water = ring->head;
+  }
+
+  out->ptr = ptr;
+  out->offset = offset;
+  out->size = size;
+  return 0;
+}
+
+void ring_buffer_unmap(ring_buffer *ring) {
+  if (!ring->mapped) {
+    return;
+  }
+  gl_state_bind_buffer(ring->target, ring->buffer);
+  glUnmapBuffer(ring->target);
+  ring->mapped = 0;
+}
+
+GLintptr ring_buffer_write(ring_buffer *ring, const void *data, GLsizeiptr size, GLsizeiptr alignment) {
+  ring_allocation allocation;
+  if (ring_buffer_alloc(ring, size, alignment, &allocation) != 0) {
+    return -1;
+  }
+  memcpy(allocation.ptr, data, size);
+  ring_buffer_unmap(ring);
+  return allocation.offset;
+}
+
+void ring_buffer_end_frame(ring_buffer *ring) {
+  ring_buffer_unmap(ring);
+
+  ring->fences[ring->frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  ring->frame = (ring->frame + 1) % RING_BUFFER_FRAMES;
+  ring->head = 0;
+
+  GLsync fence = ring->fences[ring->frame];
+  if (!fence) {
+    return;
+  }
+
+  // normally signalled long ago, so this is a poll
+  GLenum result = glClientWaitSync(fence, 0, 0);
+  if (result == GL_TIMEOUT_EXPIRED) {
+    ring->waits++;
+    result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+  }
+  if (result == GL_WAIT_FAILED || result == GL_TIMEOUT_EXPIRED) {
+    fprintf(stderr, "WARNING: ring buffer fence did not signal (0x%x).\n", result);
+  }
+
+  glDeleteSync(fence);
+  ring->fences[ring->frame] = NULL;
+}
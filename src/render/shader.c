@@ -0,0 +1,130 @@
+#include "render/shader.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+GLuint shader_compile_begin(GLenum type, const char *src, const char *defines) {
+  // #version has to stay first, so the defines go in after it and #line keeps
+  // the line numbers in error messages pointing at the real file
+  const char *body = src;
+  GLint version_len = 0;
+  if (strncmp(src, "#version", 8) == 0) {
+    const char *newline = strchr(src, '\n');
+    body = newline ? newline + 1 : src + strlen(src);
+    version_len = body - src;
+  }
+
+  const char *sources[] = { src, defines ? defines : "", "\n#line 2\n", body };
+  GLint lengths[] = { version_len, -1, -1, -1 };
+  int first = version_len > 0 ? 0 : 1;
+
+  GLuint shader = glCreateShader(type);
+  glShaderSource(shader, 4 - first, sources + first, lengths + first);
+  glCompileShader(shader);
+
+  return shader;
+}
+
+int shader_compile_check(GLuint shader) {
+  int is_compiled = 0;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &is_compiled);
+
+  if (is_compiled == GL_FALSE) {
+    int max_len = 2048;
+    char log[max_len];
+
+    glGetShaderInfoLog(shader, max_len, NULL, log);
+
+    fprintf(stderr, "ERROR: compile shader index %i did not compile.\n%s\n", shader, log);
+
+    return 0;
+  }
+
+  return 1;
+}
+
+GLuint shader_link_begin(GLuint vert, GLuint frag, int retrievable) {
+  GLuint program = glCreateProgram();
+
+  if (retrievable && GLAD_GL_ARB_get_program_binary) {
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+
+  glAttachShader(program, vert);
+  glAttachShader(program, frag);
+
+  glLinkProgram(program);
+
+  return program;
+}
+
+int shader_link_check(GLuint program, GLuint vert, GLuint frag) {
+  // the program keeps what it needs, the shader objects can go once it is linked
+  glDetachShader(program, vert);
+  glDetachShader(program, frag);
+
+  int is_linked = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &is_linked);
+  if (is_linked == GL_FALSE) {
+    int max_len = 2048;
+    char log[max_len];
+
+    glGetProgramInfoLog(program, max_len, NULL, log);
+
+    fprintf(stderr, "ERROR: could not link shader program.\n%s\n", log);
+
+    return 0;
+  }
+
+  glValidateProgram(program);
+
+  int is_validated = 0;
+  glGetProgramiv(program, GL_VALIDATE_STATUS, &is_validated);
+
+  if (is_validated == GL_FALSE) {
+    int max_len = 2048;
+    char log[max_len];
+
+    glGetProgramInfoLog(program, max_len, NULL, log);
+
+    fprintf(stderr, "ERROR: validation of shader program failed.\n%s\n", log);
+
+    return 0;
+  }
+
+  return 1;
+}
+
+int shader_is_complete(GLuint object, int is_program) {
+  if (!GLAD_GL_KHR_parallel_shader_compile && !GLAD_GL_ARB_parallel_shader_compile) {
+    return 1;
+  }
+
+  // the KHR and ARB tokens have the same value
+  GLint complete = GL_TRUE;
+  if (is_program) {
+    glGetProgramiv(object, GL_COMPLETION_STATUS_KHR, &complete);
+  } else {
+    glGetShaderiv(object, GL_COMPLETION_STATUS_KHR, &complete);
+  }
+  return complete == GL_TRUE;
+}
+
+GLuint shader_compile(GLenum type, const char *src, const char *defines) {
+  GLuint shader = shader_compile_begin(type, src, defines);
+  if (!shader_compile_check(shader)) {
+    glDeleteShader(shader);
+    return 0;
+  }
+  return shader;
+}
+
+GLuint shader_link(GLuint vert, GLuint frag, int retrievable) {
+  GLuint program = shader_link_begin(vert, frag, retrievable);
+  if (!shader_link_check(program, vert, frag)) {
+    glDeleteProgram(program);
+    return 0;
+  }
+  return program;
+}
@@ -0,0 +1,164 @@
+#include "render/shader_pipeline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "render/shader.h"
+
+
+int shader_pipeline_init(shader_pipeline *pipeline, program_cache *cache) {
+  memset(pipeline, 0, sizeof(*pipeline));
+  pipeline->cache = cache;
+
+  if (GLAD_GL_KHR_parallel_shader_compile) {
+    // let the driver pick how many threads to use
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+    pipeline->parallel = 1;
+  } else if (GLAD_GL_ARB_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+    pipeline->parallel = 1;
+  }
+
+  printf("Shader compilation: %s.\n", pipeline->parallel ? "parallel" : "serial (no parallel_shader_compile)");
+  return 0;
+}
+
+void shader_pipeline_free(shader_pipeline *pipeline) {
+  for (int i = 0; i < pipeline->count; i++) {
+    program_request *request = &pipeline->requests[i];
+    glDeleteShader(request->vert);
+    glDeleteShader(request->frag);
+    glDeleteProgram(request->program);
+  }
+  free(pipeline->requests);
+  memset(pipeline, 0, sizeof(*pipeline));
+}
+
+program_handle shader_pipeline_submit(shader_pipeline *pipeline, const char *vs_src, const char *fs_src, const char *defines) {
+  if (pipeline->count == pipeline->capacity) {
+    int capacity = pipeline->capacity ? pipeline->capacity * 2 : 16;
+    program_request *requests = realloc(pipeline->requests, capacity * sizeof(program_request));
+    if (!requests) {
+      fprintf(stderr, "ERROR: could not allocate memory for %i shader programs.\n", capacity);
+      return -1;
+    }
+    pipeline->requests = requests;
+    pipeline->capacity = capacity;
+  }
+
+  program_handle handle = pipeline->count++;
+  program_request *request = &pipeline->requests[handle];
+  memset(request, 0, sizeof(*request));
+
+  request->key = program_cache_key(pipeline->cache, vs_src, fs_src, defines);
+  request->program = program_cache_load(pipeline->cache, request->key);
+  if (request->program) {
+    request->status = PROGRAM_READY;
+    return handle;
+  }
+
+  // no status queries here, those are what would make the driver finish
+  request->vert = shader_compile_begin(GL_VERTEX_SHADER, vs_src, defines);
+  request->frag = shader_compile_begin(GL_FRAGMENT_SHADER, fs_src, defines);
+  request->status = PROGRAM_COMPILING;
+  pipeline->pending++;
+
+  return handle;
+}
+
+static void fail(shader_pipeline *pipeline, program_request *request) {
+  glDeleteShader(request->vert);
+  glDeleteShader(request->frag);
+  glDeleteProgram(request->program);
+  request->vert = 0;
+  request->frag = 0;
+  request->program = 0;
+  request->status = PROGRAM_FAILED;
+  pipeline->pending--;
+}
+
+static void advance_compile(shader_pipeline *pipeline, program_request *request, int block) {
+  if (!block && !(shader_is_complete(request->vert, 0) && shader_is_complete(request->frag, 0))) {
+    return;
+  }
+
+  if (!shader_compile_check(request->vert) || !shader_compile_check(request->frag)) {
+    fail(pipeline, request);
+    return;
+  }
+
+  request->program = shader_link_begin(request->vert, request->frag, pipeline->cache->enabled);
+  request->status = PROGRAM_LINKING;
+}
+
+static void advance_link(shader_pipeline *pipeline, program_request *request, int block) {
+  if (!block && !shader_is_complete(request->program, 1)) {
+    return;
+  }
+
+  if (!shader_link_check(request->program, request->vert, request->frag)) {
+    fail(pipeline, request);
+    return;
+  }
+
+  glDeleteShader(request->vert);
+  glDeleteShader(request->frag);
+  request->vert = 0;
+  request->frag = 0;
+
+  program_cache_store(pipeline->cache, request->key, request->program);
+  request->status = PROGRAM_READY;
+  pipeline->pending--;
+}
+
+int shader_pipeline_poll(shader_pipeline *pipeline, int block) {
+  if (pipeline->pending == 0) {
+    return 0;
+  }
+
+  // all the compiles get checked (and their links started) before any link is
+  // waited on, so a serial driver still overlaps as much as it can
+  for (int i = 0; i < pipeline->count; i++) {
+    if (pipeline->requests[i].status == PROGRAM_COMPILING) {
+      advance_compile(pipeline, &pipeline->requests[i], block);
+    }
+  }
+
+  for (int i = 0; i < pipeline->count; i++) {
+    if (pipeline->requests[i].status == PROGRAM_LINKING) {
+      advance_link(pipeline, &pipeline->requests[i], block);
+    }
+  }
+
+  return pipeline->pending;
+}
+
+program_status shader_pipeline_status(const shader_pipeline *pipeline, program_handle handle) {
+  if (handle < 0 || handle >= pipeline->count) {
+    return PROGRAM_FAILED;
+  }
+  return pipeline->requests[handle].status;
+}
+
+GLuint shader_pipeline_program(const shader_pipeline *pipeline, program_handle handle) {
+  if (shader_pipeline_status(pipeline, handle) != PROGRAM_READY) {
+    return 0;
+  }
+  return pipeline->requests[handle].program;
+}
+
+GLuint shader_pipeline_wait(shader_pipeline *pipeline, program_handle handle) {
+  if (handle < 0 || handle >= pipeline->count) {
+    return 0;
+  }
+
+  program_request *request = &pipeline->requests[handle];
+  if (request->status == PROGRAM_COMPILING) {
+    advance_compile(pipeline, request, 1);
+  }
+  if (request->status == PROGRAM_LINKING) {
+    advance_link(pipeline, request, 1);
+  }
+
+  return shader_pipeline_program(pipeline, handle);
+}
@@ -0,0 +1,395 @@
+#include "render/texture.h"
+
+#include <png.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "render/gl_state.h"
+#include "utils/file_read.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+enum job_stage {
+  STAGE_READ_HEADER,   // job
+  STAGE_NEEDS_BUFFER,  // GL thread maps a pixel buffer
+  STAGE_DECODE,        // job decodes and builds mips into it
+  STAGE_DECODED,       // GL thread uploads
+  STAGE_FAILED         // GL thread cleans up
+};
+
+struct texture_job {
+  texture_manager *manager;
+  texture_handle handle;
+  enum job_stage stage;
+  char path[256];
+
+  file_view file;
+  png_image image;
+
+  GLuint pbo;
+  uint8_t *pixels;
+  size_t size;
+  int levels;
+
+  texture_job *next;
+};
+
+static size_t mip_chain_size(int width, int height, int *levels) {
+  size_t size = 0;
+  *levels = 0;
+  for (;;) {
+    size += (size_t)width * height * 4;
+    (*levels)++;
+    if (width == 1 && height == 1) {
+      return size;
+    }
+    width = width > 1 ? width / 2 : 1;
+    height = height > 1 ? height / 2 : 1;
+  }
+}
+
+static void downsample_pixel(const uint8_t *src, int sw, int sh, uint8_t *dst, int x, int y) {
+  int x0 = 2 * x, y0 = 2 * y;
+  int x1 = x0 + 1 < sw ? x0 + 1 : x0;
+  int y1 = y0 + 1 < sh ? y0 + 1 : y0;
+
+  const uint8_t *a = src + ((size_t)y0 * sw + x0) * 4;
+  const uint8_t *b = src + ((size_t)y0 * sw + x1) * 4;
+  const uint8_t *c = src + ((size_t)y1 * sw + x0) * 4;
+  const uint8_t *d = src + ((size_t)y1 * sw + x1) * 4;
+
+  for (int i = 0; i < 4; i++) {
+    dst[i] = (a[i] + b[i] + c[i] + d[i] + 2) >> 2;
+  }
+}
+
+// 2x2 box filter; odd edges reuse the last row/column
+static void downsample(const uint8_t *src, int sw, int sh, uint8_t *dst, int dw, int dh) {
+  for (int y = 0; y < dh; y++) {
+    const uint8_t *row0 = src + (size_t)(2 * y) * sw * 4;
+    const uint8_t *row1 = 2 * y + 1 < sh ? row0 + (size_t)sw * 4 : row0;
+    uint8_t *out = dst + (size_t)y * dw * 4;
+    int x = 0;
+
+#if defined(__SSE2__)
+    // four output pixels from two rows of eight input pixels
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(2);
+    for (; x + 4 <= sw / 2; x += 4) {
+      __m128i result[2];
+      for (int half = 0; half < 2; half++) {
+        __m128i top = _mm_loadu_si128((const __m128i *)(row0 + (x * 2 + half * 4) * 4));
+        __m128i bottom = _mm_loadu_si128((const __m128i *)(row1 + (x * 2 + half * 4) * 4));
+
+        // columns summed as 16-bit: lo holds pixels 0 and 1, hi pixels 2 and 3
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+
+        // then each pixel pair
+        lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+        hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+        __m128i sum = _mm_unpacklo_epi64(lo, hi);
+        result[half] = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+      }
+      _mm_storeu_si128((__m128i *)(out + x * 4), _mm_packus_epi16(result[0], result[1]));
+    }
+#endif
+
+    for (; x < dw; x++) {
+      downsample_pixel(src, sw, sh, out + x * 4, x, y);
+    }
+  }
+}
+
+static void build_mips(uint8_t *pixels, int width, int height, int levels) {
+  uint8_t *src = pixels;
+  for (int level = 1; level < levels; level++) {
+    int dw = width > 1 ? width / 2 : 1;
+    int dh = height > 1 ? height / 2 : 1;
+    uint8_t *dst = src + (size_t)width * height * 4;
+
+    downsample(src, width, height, dst, dw, dh);
+
+    src = dst;
+    width = dw;
+    height = dh;
+  }
+}
+
+static void push(texture_job **head, texture_job **tail, texture_job *job) {
+  job->next = NULL;
+  if (*tail) {
+    (*tail)->next = job;
+  } else {
+    *head = job;
+  }
+  *tail = job;
+}
+
+static void read_header(texture_job *job) {
+  int result = file_map(job->path, &job->file);
+  if (result != FILE_OK) {
+    fprintf(stderr, "ERROR: could not load texture \"%s\": %s.\n", job->path, file_error_string(result));
+    job->stage = STAGE_FAILED;
+    return;
+  }
+
+  memset(&job->image, 0, sizeof(job->image));
+  job->image.version = PNG_IMAGE_VERSION;
+  if (!png_image_begin_read_from_memory(&job->image, job->file.data, job->file.size)) {
+    fprintf(stderr, "ERROR: could not decode texture \"%s\": %s.\n", job->path, job->image.message);
+    job->stage = STAGE_FAILED;
+    return;
+  }
+
+  job->image.format = PNG_FORMAT_RGBA;
+  job->size = mip_chain_size(job->image.width, job->image.height, &job->levels);
+  job->stage = STAGE_NEEDS_BUFFER;
+}
+
+static void decode(texture_job *job) {
+  if (!png_image_finish_read(&job->image, NULL, job->pixels, 0, NULL)) {
+    fprintf(stderr, "ERROR: could not decode texture \"%s\": %s.\n", job->path, job->image.message);
+    job->stage = STAGE_FAILED;
+    return;
+  }
+
+  build_mips(job->pixels, job->image.width, job->image.height, job->levels);
+  job->stage = STAGE_DECODED;
+}
+
+// one step of a load, run on the job system, then back to the GL thread
+static void load_step(void *context) {
+  texture_job *job = context;
+  texture_manager *manager = job->manager;
+
+  if (job->stage == STAGE_READ_HEADER) {
+    read_header(job);
+  } else {
+    decode(job);
+  }
+
+  pthread_mutex_lock(&manager->lock);
+  push(&manager->gl_head, &manager->gl_tail, job);
+  pthread_mutex_unlock(&manager->lock);
+}
+
+int texture_manager_init(texture_manager *manager, job_system *jobs) {
+  memset(manager, 0, sizeof(*manager));
+  manager->jobs = jobs;
+  pthread_mutex_init(&manager->lock, NULL);
+  return pool_init(&manager->job_pool, sizeof(texture_job), 64, 16);
+}
+
+static void free_job(texture_job *job) {
+  if (job->pbo) {
+    if (job->pixels) {
+      gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, job->pbo);
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    gl_state_delete_buffers(1, &job->pbo);
+  }
+  png_image_free(&job->image);
+  file_release(&job->file);
+  pool_release(&job->manager->job_pool, job);
+}
+
+static void free_list(texture_job *job) {
+  while (job) {
+    texture_job *next = job->next;
+    free_job(job);
+    job = next;
+  }
+}
+
+void texture_manager_free(texture_manager *manager) {
+  if (manager->jobs) {
+    jobs_wait(manager->jobs, &manager->in_flight);
+  }
+
+  free_list(manager->gl_head);
+  free_list(manager->stalled);
+
+  for (int i = 0; i < manager->count; i++) {
+    gl_state_delete_textures(1, &manager->textures[i].name);
+  }
+  free(manager->textures);
+  pool_free(&manager->job_pool);
+
+  pthread_mutex_destroy(&manager->lock);
+  memset(manager, 0, sizeof(*manager));
+}
+
+texture_handle texture_load(texture_manager *manager, const char *path) {
+  if (manager->count == manager->capacity) {
+    int capacity = manager->capacity ? manager->capacity * 2 : 64;
+    texture *textures = realloc(manager->textures, capacity * sizeof(texture));
+    if (!textures) {
+      fprintf(stderr, "ERROR: could not allocate memory for %i textures.\n", capacity);
+      return -1;
+    }
+    manager->textures = textures;
+    manager->capacity = capacity;
+  }
+
+  texture_job *job = pool_alloc(&manager->job_pool);
+  if (!job) {
+    fprintf(stderr, "ERROR: could not allocate memory for a texture load job.\n");
+    return -1;
+  }
+  memset(job, 0, sizeof(*job));
+
+  texture_handle handle = manager->count++;
+  texture *tex = &manager->textures[handle];
+  memset(tex, 0, sizeof(*tex));
+  tex->status = TEXTURE_LOADING;
+
+  // a single mid-grey texel until the real image arrives
+  static const uint8_t placeholder[4] = { 128, 128, 128, 255 };
+  glGenTextures(1, &tex->name);
+  gl_state_bind_texture(0, GL_TEXTURE_2D, tex->name);
+  gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+  job->manager = manager;
+  job->handle = handle;
+  job->stage = STAGE_READ_HEADER;
+  snprintf(job->path, sizeof(job->path), "%s", path);
+  jobs_run(manager->jobs, load_step, job, &manager->in_flight);
+
+  return handle;
+}
+
+// maps a pixel buffer big enough for the whole mip chain and hands it to a job
+static void map_buffer(texture_manager *manager, texture_job *job) {
+  glGenBuffers(1, &job->pbo);
+  gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, job->pbo);
+  glBufferData(GL_PIXEL_UNPACK_BUFFER, job->size, NULL, GL_STREAM_DRAW);
+  job->pixels = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, job->size,
+                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  if (!job->pixels) {
+    fprintf(stderr, "ERROR: could not map a %zu byte pixel buffer for \"%s\".\n", job->size, job->path);
+    job->stage = STAGE_FAILED;
+    manager->textures[job->handle].status = TEXTURE_FAILED;
+    free_job(job);
+    return;
+  }
+
+  manager->mapped_uploads++;
+  job->stage = STAGE_DECODE;
+  jobs_run(manager->jobs, load_step, job, &manager->in_flight);
+}
+
+static void upload(texture_manager *manager, texture_job *job) {
+  texture *tex = &manager->textures[job->handle];
+
+  gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, job->pbo);
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  job->pixels = NULL;
+  manager->mapped_uploads--;
+
+  gl_state_bind_texture(0, GL_TEXTURE_2D, tex->name);
+
+  // offsets into the bound unpack buffer, so the driver copies without the CPU
+  int width = job->image.width;
+  int height = job->image.height;
+  size_t offset = 0;
+  for (int level = 0; level < job->levels; level++) {
+    glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, (void *)offset);
+    offset += (size_t)width * height * 4;
+    width = width > 1 ? width / 2 : 1;
+    height = height > 1 ? height / 2 : 1;
+  }
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, job->levels - 1);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+  // leaving it bound would turn every later client-memory upload into an offset
+  gl_state_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  tex->width = job->image.width;
+  tex->height = job->image.height;
+  tex->status = TEXTURE_RESIDENT;
+
+  free_job(job);
+}
+
+void texture_manager_update(texture_manager *manager) {
+  pthread_mutex_lock(&manager->lock);
+  texture_job *ready = manager->gl_head;
+  manager->gl_head = NULL;
+  manager->gl_tail = NULL;
+  pthread_mutex_unlock(&manager->lock);
+
+  // jobs that were waiting for a free mapping slot go first
+  texture_job *stalled = NULL, *stalled_tail = NULL;
+  texture_job *job = manager->stalled;
+  manager->stalled = NULL;
+  if (job) {
+    texture_job *last = job;
+    while (last->next) {
+      last = last->next;
+    }
+    last->next = ready;
+    ready = job;
+  }
+
+  size_t uploaded = 0;
+  while ((job = ready)) {
+    ready = job->next;
+
+    switch (job->stage) {
+    case STAGE_NEEDS_BUFFER:
+      if (manager->mapped_uploads >= TEXTURE_MAX_MAPPED_UPLOADS) {
+        push(&stalled, &stalled_tail, job);
+      } else {
+        map_buffer(manager, job);
+      }
+      break;
+    case STAGE_DECODED:
+      if (uploaded >= TEXTURE_UPLOAD_BUDGET) {
+        push(&stalled, &stalled_tail, job);
+      } else {
+        uploaded += job->size;
+        upload(manager, job);
+      }
+      break;
+    default:
+      if (job->pixels) {
+        manager->mapped_uploads--;
+      }
+      manager->textures[job->handle].status = TEXTURE_FAILED;
+      free_job(job);
+      break;
+    }
+  }
+
+  manager->stalled = stalled;
+}
+
+GLuint texture_gl_name(const texture_manager *manager, texture_handle handle) {
+  if (handle < 0 || handle >= manager->count) {
+    return 0;
+  }
+  return manager->textures[handle].name;
+}
+
+texture_status texture_get_status(const texture_manager *manager, texture_handle handle) {
+  if (handle < 0 || handle >= manager->count) {
+    return TEXTURE_FAILED;
+  }
+  return manager->textures[handle].status;
+}
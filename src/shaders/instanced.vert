@@ -0,0 +1,14 @@
+#version 330 core
+
+layout (location = 0) in vec3 pos;
+// one per instance, takes locations 1 to 4
+layout (location = 1) in mat4 model;
+
+uniform mat4 view_projection;
+
+out vec2 uv;
+
+void main() {
+     gl_Position = view_projection * model * vec4(pos, 1.0);
+     uv = pos.xy * 0.5 + 0.5;
+}
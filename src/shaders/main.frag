@@ -1,7 +1,11 @@
 #version 330 core
 
+in vec2 uv;
+
+uniform sampler2D albedo;
+
 out vec4 fragment_color;
 
 void main() {
-     fragment_color = vec4(1.0, 0.0, 0.0, 1.0);
+     fragment_color = texture(albedo, uv);
 }
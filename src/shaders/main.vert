@@ -4,6 +4,9 @@ layout (location = 0) in vec3 pos;
 
 uniform mat4 mvp;
 
+out vec2 uv;
+
 void main() {
      gl_Position = mvp * vec4(pos, 1.0);
+     uv = pos.xy * 0.5 + 0.5;
 }
@@ -0,0 +1,161 @@
+#include "utils/arena.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct arena_block {
+  arena_block *prev;
+  size_t capacity;
+};
+
+static pthread_once_t scratch_once = PTHREAD_ONCE_INIT;
+static pthread_key_t scratch_key;
+static _Thread_local arena scratch;
+static _Thread_local int has_scratch;
+
+
+static inline char *block_data(arena_block *block) {
+  return (char *)(block + 1);
+}
+
+static arena_block *new_block(size_t capacity, arena_block *prev) {
+  arena_block *block = malloc(sizeof(arena_block) + capacity);
+  if (!block) {
+    fprintf(stderr, "ERROR: could not allocate a %zu byte arena block.\n", capacity);
+    return NULL;
+  }
+  block->prev = prev;
+  block->capacity = capacity;
+  return block;
+}
+
+static void free_blocks(arena_block *block) {
+  while (block) {
+    arena_block *prev = block->prev;
+    free(block);
+    block = prev;
+  }
+}
+
+// one block as large as all of them, or just the newest if that fails
+static void fold(arena *a) {
+  if (!a->block->prev) {
+    return;
+  }
+  arena_block *merged = new_block(a->capacity, NULL);
+  if (merged) {
+    free_blocks(a->block);
+    a->block = merged;
+  } else {
+    free_blocks(a->block->prev);
+    a->block->prev = NULL;
+    a->capacity = a->block->capacity;
+  }
+}
+
+int arena_init(arena *a, size_t capacity) {
+  memset(a, 0, sizeof(*a));
+  if (capacity < 4096) {
+    capacity = 4096;
+  }
+  a->block = new_block(capacity, NULL);
+  if (!a->block) {
+    return -1;
+  }
+  a->capacity = capacity;
+  return 0;
+}
+
+void arena_free(arena *a) {
+  free_blocks(a->block);
+  memset(a, 0, sizeof(*a));
+}
+
+void *arena_alloc(arena *a, size_t size, size_t align) {
+  uintptr_t base = (uintptr_t)block_data(a->block);
+  uintptr_t start = (base + a->used + align - 1) & ~(uintptr_t)(align - 1);
+
+  if (start - base + size > a->block->capacity) {
+    size_t capacity = a->block->capacity * 2;
+    while (capacity < size + align) {
+      capacity *= 2;
+    }
+    arena_block *block = new_block(capacity, a->block);
+    if (!block) {
+      return NULL;
+    }
+    a->block = block;
+    a->used = 0;
+    a->capacity += capacity;
+    a->grows++;
+
+    base = (uintptr_t)block_data(block);
+    start = (base + align - 1) & ~(uintptr_t)(align - 1);
+  }
+
+  size_t end = start - base + size;
+  a->allocated += end - a->used;
+  a->used = end;
+  if (a->allocated > a->high_water) {
+    a->high_water = a->allocated;
+  }
+  return (void *)start;
+}
+
+void arena_reset(arena *a) {
+  a->last_allocated = a->allocated;
+  fold(a);
+  a->used = 0;
+  a->allocated = 0;
+}
+
+arena_mark arena_get_mark(const arena *a) {
+  return (arena_mark){a->block, a->used, a->allocated};
+}
+
+void arena_release(arena *a, arena_mark mark) {
+  if (mark.allocated == 0) {
+    // back to empty, so the blocks can be merged like on a reset
+    fold(a);
+  } else {
+    while (a->block != mark.block) {
+      arena_block *prev = a->block->prev;
+      a->capacity -= a->block->capacity;
+      free(a->block);
+      a->block = prev;
+    }
+  }
+  a->used = mark.used;
+  a->allocated = mark.allocated;
+}
+
+static void scratch_destroy(void *value) {
+  arena_free(value);
+}
+
+static void make_scratch_key(void) {
+  pthread_key_create(&scratch_key, scratch_destroy);
+}
+
+arena *arena_scratch(void) {
+  if (!has_scratch) {
+    pthread_once(&scratch_once, make_scratch_key);
+    if (arena_init(&scratch, ARENA_SCRATCH_SIZE) != 0) {
+      return NULL;
+    }
+    pthread_setspecific(scratch_key, &scratch);
+    has_scratch = 1;
+  }
+  return &scratch;
+}
+
+void arena_scratch_free(void) {
+  if (has_scratch) {
+    pthread_setspecific(scratch_key, NULL);
+    arena_free(&scratch);
+    has_scratch = 0;
+  }
+}
@@ -1,35 +1,127 @@
 #include "utils/file_read.h"
 
-#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 
-char *read_file(const char *path) {
-  FILE *file = fopen(path, "r");
-  if (!file) {
-    fprintf(stderr, "Could not open file at %s\n", path);
-    exit(1);
+// for anything that can't be mapped: grows a buffer until EOF
+static int read_stream(int fd, file_view *view) {
+  size_t capacity = 64 * 1024;
+  size_t size = 0;
+  char *buffer = malloc(capacity);
+  if (!buffer) {
+    return FILE_ERROR_MEMORY;
   }
 
-  fseek(file, 0, SEEK_END);
-  ulong size = ftell(file);
-  rewind(file);
+  for (;;) {
+    if (size + 1 >= capacity) {
+      char *bigger = realloc(buffer, capacity * 2);
+      if (!bigger) {
+        free(buffer);
+        return FILE_ERROR_MEMORY;
+      }
+      buffer = bigger;
+      capacity *= 2;
+    }
 
-  char *buffer = malloc(size + 1);
-  if (!buffer) {
-    fprintf(stderr, "read_file: Could not allocate memory for buffer.");
-    fclose(file);
-    exit(1);
+    ssize_t n = read(fd, buffer + size, capacity - size - 1);
+    if (n == 0) {
+      break;
+    }
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      free(buffer);
+      return FILE_ERROR_READ;
+    }
+    size += n;
   }
 
-  if (fread(buffer, 1, size, file) != size) {
-    fprintf(stderr, "read_file: Could not read all of file at \"%s\".", path);
-    free(buffer);
-    fclose(file);
-    exit(1);
+  buffer[size] = '\0';
+  view->data = buffer;
+  view->size = size;
+  view->mapped = 0;
+  return FILE_OK;
+}
+
+int file_map(const char *path, file_view *view) {
+  memset(view, 0, sizeof(*view));
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return FILE_ERROR_OPEN;
   }
 
-  buffer[size] = '\0';
-  fclose(file);
-  return buffer;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return FILE_ERROR_STAT;
+  }
+
+  // an empty file can't be mapped, so it takes the buffered path like pipes do
+  if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+    int result = read_stream(fd, view);
+    close(fd);
+    return result;
+  }
+
+  // The kernel zero fills the rest of the last page, which is the terminator.
+  // A file that ends exactly on a page boundary has none, so it goes over the
+  // start of a zeroed reservation one page longer and that page is the
+  // terminator instead.
+  size_t size = st.st_size;
+  long page_size = sysconf(_SC_PAGESIZE);
+  void *data;
+  if (size % page_size == 0) {
+    void *reserved = mmap(NULL, size + page_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    data = reserved == MAP_FAILED ? MAP_FAILED : mmap(reserved, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    if (reserved != MAP_FAILED && data == MAP_FAILED) {
+      munmap(reserved, size + page_size);
+    }
+  } else {
+    data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+  if (data == MAP_FAILED) {
+    return FILE_ERROR_MAP;
+  }
+
+  view->data = data;
+  view->size = st.st_size;
+  view->mapped = 1;
+  return FILE_OK;
+}
+
+void file_release(file_view *view) {
+  if (!view->data) {
+    return;
+  }
+
+  if (view->mapped) {
+    // munmap rounds up to whole pages, so size + 1 covers the terminator's page
+    // too, whether it came from the file's last page or the reservation
+    munmap((void *)view->data, view->size + 1);
+  } else {
+    free((void *)view->data);
+  }
+  memset(view, 0, sizeof(*view));
+}
+
+const char *file_error_string(int error) {
+  switch (error) {
+  case FILE_OK: return "no error";
+  case FILE_ERROR_OPEN: return "could not open file";
+  case FILE_ERROR_STAT: return "could not stat file";
+  case FILE_ERROR_MAP: return "could not map file";
+  case FILE_ERROR_READ: return "could not read file";
+  case FILE_ERROR_MEMORY: return "out of memory";
+  default: return "unknown error";
+  }
 }
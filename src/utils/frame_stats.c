@@ -0,0 +1,234 @@
+#include "utils/frame_stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+double frame_stats_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+static int reserve(frame_stats *stats, int capacity) {
+  if (capacity <= stats->capacity) {
+    return 0;
+  }
+
+  double *cpu_ms = realloc(stats->cpu_ms, capacity * sizeof(double));
+  if (cpu_ms) {
+    stats->cpu_ms = cpu_ms;
+  }
+  double *gpu_ms = realloc(stats->gpu_ms, capacity * sizeof(double));
+  if (gpu_ms) {
+    stats->gpu_ms = gpu_ms;
+  }
+  double *phase_ms = realloc(stats->phase_ms, capacity * FRAME_STATS_MAX_PHASES * sizeof(double));
+  if (phase_ms) {
+    stats->phase_ms = phase_ms;
+  }
+
+  if (!cpu_ms || !gpu_ms || !phase_ms) {
+    fprintf(stderr, "ERROR: could not allocate memory for %i frames of stats.\n", capacity);
+    return -1;
+  }
+
+  stats->capacity = capacity;
+  return 0;
+}
+
+int frame_stats_init(frame_stats *stats, int expected_frames) {
+  memset(stats, 0, sizeof(*stats));
+
+  if (reserve(stats, expected_frames > 0 ? expected_frames : 1024) != 0) {
+    frame_stats_free(stats);
+    return -1;
+  }
+
+  glGenQueries(FRAME_STATS_QUERY_RING, stats->queries);
+  for (int i = 0; i < FRAME_STATS_QUERY_RING; i++) {
+    stats->query_frame[i] = -1;
+  }
+
+  return 0;
+}
+
+void frame_stats_free(frame_stats *stats) {
+  if (stats->queries[0]) {
+    glDeleteQueries(FRAME_STATS_QUERY_RING, stats->queries);
+  }
+  free(stats->cpu_ms);
+  free(stats->gpu_ms);
+  free(stats->phase_ms);
+  memset(stats, 0, sizeof(*stats));
+}
+
+int frame_stats_add_phase(frame_stats *stats, const char *name) {
+  if (stats->num_phases == FRAME_STATS_MAX_PHASES) {
+    return -1;
+  }
+  stats->phase_names[stats->num_phases] = name;
+  return stats->num_phases++;
+}
+
+static void collect_query(frame_stats *stats, int slot) {
+  int frame = stats->query_frame[slot];
+  if (frame < 0) {
+    return;
+  }
+
+  GLuint64 elapsed_ns = 0;
+  glGetQueryObjectui64v(stats->queries[slot], GL_QUERY_RESULT, &elapsed_ns);
+  stats->gpu_ms[frame] = elapsed_ns * 1e-6;
+  stats->query_frame[slot] = -1;
+}
+
+int frame_stats_begin_frame(frame_stats *stats) {
+  int frame = stats->num_frames;
+  if (reserve(stats, frame < stats->capacity ? stats->capacity : stats->capacity * 2) != 0) {
+    return -1;
+  }
+
+  int slot = frame % FRAME_STATS_QUERY_RING;
+  // the result for this slot is FRAME_STATS_QUERY_RING frames old, so this rarely waits
+  collect_query(stats, slot);
+
+  glBeginQuery(GL_TIME_ELAPSED, stats->queries[slot]);
+  stats->query_frame[slot] = frame;
+
+  memset(&stats->phase_ms[frame * FRAME_STATS_MAX_PHASES], 0, FRAME_STATS_MAX_PHASES * sizeof(double));
+  stats->gpu_ms[frame] = 0.0;
+
+  stats->frame_start = frame_stats_now_ms();
+  stats->last_mark = stats->frame_start;
+  return 0;
+}
+
+void frame_stats_mark(frame_stats *stats, int phase) {
+  double now = frame_stats_now_ms();
+  stats->phase_ms[stats->num_frames * FRAME_STATS_MAX_PHASES + phase] += now - stats->last_mark;
+  stats->last_mark = now;
+}
+
+int frame_stats_end_frame(frame_stats *stats) {
+  glEndQuery(GL_TIME_ELAPSED);
+  stats->cpu_ms[stats->num_frames] = frame_stats_now_ms() - stats->frame_start;
+  return ++stats->num_frames;
+}
+
+void frame_stats_finish(frame_stats *stats) {
+  for (int i = 0; i < FRAME_STATS_QUERY_RING; i++) {
+    collect_query(stats, i);
+  }
+}
+
+static int compare_double(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// nearest-rank percentile of an already sorted array
+static double percentile(const double *sorted, int count, double p) {
+  int rank = (int)(p / 100.0 * count + 0.999999);
+  if (rank < 1) {
+    rank = 1;
+  }
+  return sorted[rank - 1];
+}
+
+void frame_stats_summarize(const double *samples, int count, int stride, frame_stats_summary *out) {
+  memset(out, 0, sizeof(*out));
+  if (count == 0) {
+    return;
+  }
+
+  double *sorted = malloc(count * sizeof(double));
+  if (!sorted) {
+    fprintf(stderr, "ERROR: could not allocate memory for the frame stats summary.\n");
+    return;
+  }
+
+  double sum = 0.0;
+  for (int i = 0; i < count; i++) {
+    sorted[i] = samples[i * stride];
+    sum += sorted[i];
+  }
+  qsort(sorted, count, sizeof(double), compare_double);
+
+  out->min = sorted[0];
+  out->median = percentile(sorted, count, 50.0);
+  out->p95 = percentile(sorted, count, 95.0);
+  out->p99 = percentile(sorted, count, 99.0);
+  out->max = sorted[count - 1];
+  out->mean = sum / count;
+
+  free(sorted);
+}
+
+// calls fn once per reported metric: frame cpu, frame gpu, then each phase
+static void for_each_metric(const frame_stats *stats, void *ctx,
+                            void (*fn)(void *ctx, const char *name, const frame_stats_summary *s, int first)) {
+  frame_stats_summary s;
+
+  frame_stats_summarize(stats->cpu_ms, stats->num_frames, 1, &s);
+  fn(ctx, "frame_cpu", &s, 1);
+  frame_stats_summarize(stats->gpu_ms, stats->num_frames, 1, &s);
+  fn(ctx, "frame_gpu", &s, 0);
+
+  for (int p = 0; p < stats->num_phases; p++) {
+    frame_stats_summarize(stats->phase_ms + p, stats->num_frames, FRAME_STATS_MAX_PHASES, &s);
+    fn(ctx, stats->phase_names[p], &s, 0);
+  }
+}
+
+static void print_metric(void *ctx, const char *name, const frame_stats_summary *s, int first) {
+  if (first) {
+    printf("%-12s %9s %9s %9s %9s %9s %9s\n", "ms", "min", "median", "p95", "p99", "max", "mean");
+  }
+  printf("%-12s %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f\n",
+         name, s->min, s->median, s->p95, s->p99, s->max, s->mean);
+}
+
+static void write_json_metric(void *ctx, const char *name, const frame_stats_summary *s, int first) {
+  fprintf(ctx, "%s    \"%s\": {\"min\": %.6f, \"median\": %.6f, \"p95\": %.6f, \"p99\": %.6f, \"max\": %.6f, \"mean\": %.6f}",
+          first ? "" : ",\n", name, s->min, s->median, s->p95, s->p99, s->max, s->mean);
+}
+
+static void write_csv_metric(void *ctx, const char *name, const frame_stats_summary *s, int first) {
+  if (first) {
+    fprintf(ctx, "metric,min_ms,median_ms,p95_ms,p99_ms,max_ms,mean_ms\n");
+  }
+  fprintf(ctx, "%s,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n",
+          name, s->min, s->median, s->p95, s->p99, s->max, s->mean);
+}
+
+void frame_stats_print(const frame_stats *stats) {
+  printf("%i frames\n", stats->num_frames);
+  for_each_metric(stats, NULL, print_metric);
+}
+
+int frame_stats_write(const frame_stats *stats, const char *path) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    fprintf(stderr, "ERROR: could not open \"%s\" for writing.\n", path);
+    return -1;
+  }
+
+  size_t len = strlen(path);
+  if (len >= 4 && strcmp(path + len - 4, ".csv") == 0) {
+    for_each_metric(stats, file, write_csv_metric);
+  } else {
+    fprintf(file, "{\n  \"frames\": %i,\n  \"metrics\": {\n", stats->num_frames);
+    for_each_metric(stats, file, write_json_metric);
+    fprintf(file, "\n  }\n}\n");
+  }
+
+  if (fclose(file) != 0) {
+    fprintf(stderr, "ERROR: could not write \"%s\".\n", path);
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,399 @@
+#include "utils/jobs.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define cpu_relax() _mm_pause()
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+// tries before an idle worker goes to sleep
+#define JOBS_IDLE_SPINS 256
+// a parallel_for leaf is at most this fraction of the range per thread
+#define JOBS_SPLITS_PER_THREAD 8
+
+// A thief may read a slot while its owner overwrites it; the CAS on top then
+// fails and the read is thrown away, but the loads still have to be atomic.
+typedef struct {
+  _Atomic(job_fn) fn;
+  _Atomic(void *) context;
+  _Atomic(job_counter *) counter;
+  _Atomic(job_counter *) dependency;
+} job_slot;
+
+struct job_deque {
+  _Alignas(64) atomic_long top;
+  _Alignas(64) atomic_long bottom;
+  _Alignas(64) job_slot slots[JOBS_DEQUE_SIZE];
+};
+
+typedef struct {
+  job_system *jobs;
+  int index;
+} worker_start;
+
+typedef struct {
+  job_system *jobs;
+  job_range_fn fn;
+  void *context;
+  long begin, end;
+  long grain, leaf_blocks;
+} range_job;
+
+// which deque the current thread owns, if any
+static _Thread_local job_system *self_jobs;
+static _Thread_local int self_index = -1;
+static _Thread_local unsigned self_random = 1;
+
+
+static void write_slot(job_slot *slot, const job *j) {
+  atomic_store_explicit(&slot->fn, j->fn, memory_order_relaxed);
+  atomic_store_explicit(&slot->context, j->context, memory_order_relaxed);
+  atomic_store_explicit(&slot->counter, j->counter, memory_order_relaxed);
+  atomic_store_explicit(&slot->dependency, j->dependency, memory_order_relaxed);
+}
+
+static void read_slot(job_slot *slot, job *j) {
+  j->fn = atomic_load_explicit(&slot->fn, memory_order_relaxed);
+  j->context = atomic_load_explicit(&slot->context, memory_order_relaxed);
+  j->counter = atomic_load_explicit(&slot->counter, memory_order_relaxed);
+  j->dependency = atomic_load_explicit(&slot->dependency, memory_order_relaxed);
+}
+
+// Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for
+// Weak Memory Models", with a fixed size array
+static int deque_push(job_deque *deque, const job *j) {
+  long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+  long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+  if (b - t >= JOBS_DEQUE_SIZE) {
+    return 0;
+  }
+  write_slot(&deque->slots[b & (JOBS_DEQUE_SIZE - 1)], j);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+  return 1;
+}
+
+static int deque_pop(job_deque *deque, job *j) {
+  long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  long t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+  if (t > b) {
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    return 0;
+  }
+
+  read_slot(&deque->slots[b & (JOBS_DEQUE_SIZE - 1)], j);
+  if (t < b) {
+    return 1;
+  }
+
+  // the last one, which a thief may be taking at the same time
+  int won = atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst,
+                                                    memory_order_relaxed);
+  atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+  return won;
+}
+
+static int deque_steal(job_deque *deque, job *j) {
+  long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  long b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+  if (t >= b) {
+    return 0;
+  }
+
+  read_slot(&deque->slots[t & (JOBS_DEQUE_SIZE - 1)], j);
+  return atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst,
+                                                 memory_order_relaxed);
+}
+
+static int inject(job_system *jobs, const job *j) {
+  pthread_mutex_lock(&jobs->lock);
+  if (jobs->num_injected == jobs->max_injected) {
+    int max = jobs->max_injected ? jobs->max_injected * 2 : 256;
+    job *injected = malloc(max * sizeof(job));
+    if (!injected) {
+      pthread_mutex_unlock(&jobs->lock);
+      fprintf(stderr, "ERROR: could not allocate memory for %i queued jobs.\n", max);
+      return 0;
+    }
+    for (int i = 0; i < jobs->num_injected; i++) {
+      injected[i] = jobs->injected[(jobs->injected_head + i) % jobs->max_injected];
+    }
+    free(jobs->injected);
+    jobs->injected = injected;
+    jobs->injected_head = 0;
+    jobs->max_injected = max;
+  }
+
+  jobs->injected[(jobs->injected_head + jobs->num_injected) % jobs->max_injected] = *j;
+  jobs->num_injected++;
+  atomic_store_explicit(&jobs->has_injected, 1, memory_order_relaxed);
+  pthread_mutex_unlock(&jobs->lock);
+  return 1;
+}
+
+static int take_injected(job_system *jobs, job *j) {
+  if (!atomic_load_explicit(&jobs->has_injected, memory_order_relaxed)) {
+    return 0;
+  }
+
+  pthread_mutex_lock(&jobs->lock);
+  int found = jobs->num_injected > 0;
+  if (found) {
+    *j = jobs->injected[jobs->injected_head];
+    jobs->injected_head = (jobs->injected_head + 1) % jobs->max_injected;
+    jobs->num_injected--;
+    atomic_store_explicit(&jobs->has_injected, jobs->num_injected > 0, memory_order_relaxed);
+  }
+  pthread_mutex_unlock(&jobs->lock);
+  return found;
+}
+
+static void wake_one(job_system *jobs) {
+  // pairs with the sleeping/queued check in worker_main(): either the worker
+  // sees the new job or this sees the worker
+  if (atomic_load(&jobs->sleeping) > 0) {
+    pthread_mutex_lock(&jobs->lock);
+    pthread_cond_signal(&jobs->wake);
+    pthread_mutex_unlock(&jobs->lock);
+  }
+}
+
+static void run_job(const job *j) {
+  j->fn(j->context);
+  if (j->counter) {
+    atomic_fetch_sub_explicit(j->counter, 1, memory_order_release);
+  }
+}
+
+static void push(job_system *jobs, const job *j) {
+  atomic_fetch_add(&jobs->queued, 1);
+  int queued = self_jobs == jobs && deque_push(&jobs->deques[self_index], j);
+  if (!queued && !inject(jobs, j)) {
+    // out of memory: do it here rather than lose it
+    atomic_fetch_sub(&jobs->queued, 1);
+    if (j->dependency) {
+      jobs_wait(jobs, j->dependency);
+    }
+    run_job(j);
+    return;
+  }
+  wake_one(jobs);
+}
+
+// own deque first, then the locked queue, then the others from a random one on
+static int take(job_system *jobs, job *j) {
+  int own = self_jobs == jobs ? self_index : -1;
+  int found = (own >= 0 && deque_pop(&jobs->deques[own], j)) || take_injected(jobs, j);
+
+  int num_deques = jobs->num_workers + 1;
+  self_random ^= self_random << 13;
+  self_random ^= self_random >> 17;
+  self_random ^= self_random << 5;
+  for (int i = 0, victim = self_random % num_deques; !found && i < num_deques; i++) {
+    found = victim != own && deque_steal(&jobs->deques[victim], j);
+    victim = victim + 1 < num_deques ? victim + 1 : 0;
+  }
+
+  if (found) {
+    atomic_fetch_sub(&jobs->queued, 1);
+  }
+  return found;
+}
+
+// 1 if a job ran
+static int run_one(job_system *jobs) {
+  job j;
+  if (!take(jobs, &j)) {
+    return 0;
+  }
+
+  // not ready yet: to the back of the locked queue, so everything else gets a turn first
+  if (j.dependency && atomic_load_explicit(j.dependency, memory_order_acquire) > 0) {
+    atomic_fetch_add(&jobs->queued, 1);
+    if (inject(jobs, &j)) {
+      return 0;
+    }
+    atomic_fetch_sub(&jobs->queued, 1);
+    jobs_wait(jobs, j.dependency);
+  }
+
+  run_job(&j);
+  return 1;
+}
+
+static void *worker_main(void *arg) {
+  worker_start *start = arg;
+  job_system *jobs = start->jobs;
+  self_jobs = jobs;
+  self_index = start->index;
+  self_random = 2654435761u * (start->index + 1);
+  free(start);
+
+  int idle = 0;
+  while (!atomic_load(&jobs->quit)) {
+    if (run_one(jobs)) {
+      idle = 0;
+      continue;
+    }
+    if (++idle < JOBS_IDLE_SPINS) {
+      cpu_relax();
+      continue;
+    }
+
+    idle = 0;
+    pthread_mutex_lock(&jobs->lock);
+    atomic_fetch_add(&jobs->sleeping, 1);
+    while (atomic_load(&jobs->queued) == 0 && !atomic_load(&jobs->quit)) {
+      pthread_cond_wait(&jobs->wake, &jobs->lock);
+    }
+    atomic_fetch_sub(&jobs->sleeping, 1);
+    pthread_mutex_unlock(&jobs->lock);
+  }
+
+  return NULL;
+}
+
+int jobs_init(job_system *jobs, int num_workers) {
+  memset(jobs, 0, sizeof(*jobs));
+
+  if (num_workers <= 0) {
+    num_workers = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+  }
+  if (num_workers > JOBS_MAX_WORKERS) {
+    num_workers = JOBS_MAX_WORKERS;
+  }
+  // at least one, so jobs nobody waits on still run
+  if (num_workers < 1) {
+    num_workers = 1;
+  }
+
+  jobs->deques = aligned_alloc(64, (num_workers + 1) * sizeof(job_deque));
+  if (!jobs->deques) {
+    fprintf(stderr, "ERROR: could not allocate memory for %i job queues.\n", num_workers + 1);
+    return -1;
+  }
+  memset(jobs->deques, 0, (num_workers + 1) * sizeof(job_deque));
+
+  pthread_mutex_init(&jobs->lock, NULL);
+  pthread_cond_init(&jobs->wake, NULL);
+
+  // stealing reads num_workers, so it is set before any worker starts
+  self_jobs = jobs;
+  self_index = num_workers;
+  jobs->num_workers = num_workers;
+  for (int i = 0; i < num_workers; i++) {
+    worker_start *start = malloc(sizeof(worker_start));
+    if (start) {
+      *start = (worker_start){jobs, i};
+    }
+    if (!start || pthread_create(&jobs->workers[i], NULL, worker_main, start) != 0) {
+      fprintf(stderr, "ERROR: could not start job worker thread.\n");
+      free(start);
+      jobs->num_workers = i;
+      jobs_free(jobs);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+void jobs_free(job_system *jobs) {
+  pthread_mutex_lock(&jobs->lock);
+  atomic_store(&jobs->quit, 1);
+  pthread_cond_broadcast(&jobs->wake);
+  pthread_mutex_unlock(&jobs->lock);
+
+  for (int i = 0; i < jobs->num_workers; i++) {
+    pthread_join(jobs->workers[i], NULL);
+  }
+
+  if (self_jobs == jobs) {
+    self_jobs = NULL;
+    self_index = -1;
+  }
+
+  pthread_cond_destroy(&jobs->wake);
+  pthread_mutex_destroy(&jobs->lock);
+  free(jobs->injected);
+  free(jobs->deques);
+  memset(jobs, 0, sizeof(*jobs));
+}
+
+void jobs_run(job_system *jobs, job_fn fn, void *context, job_counter *counter) {
+  jobs_run_after(jobs, NULL, fn, context, counter);
+}
+
+void jobs_run_after(job_system *jobs, job_counter *dependency, job_fn fn, void *context, job_counter *counter) {
+  if (counter) {
+    atomic_fetch_add_explicit(counter, 1, memory_order_relaxed);
+  }
+  job j = {fn, context, counter, dependency};
+  push(jobs, &j);
+}
+
+void jobs_wait(job_system *jobs, job_counter *counter) {
+  int idle = 0;
+  while (atomic_load_explicit(counter, memory_order_acquire) > 0) {
+    if (run_one(jobs)) {
+      idle = 0;
+    } else if (++idle < JOBS_IDLE_SPINS) {
+      cpu_relax();
+    } else {
+      // what's left is running elsewhere
+      sched_yield();
+    }
+  }
+}
+
+// keeps halving its range, queueing the upper half each time, and runs what's left
+static void run_range(void *arg) {
+  const range_job *range = arg;
+  range_job halves[64];
+  job_counter counter = 0;
+  int num_halves = 0;
+
+  long begin = range->begin, end = range->end;
+  long blocks = (end - begin + range->grain - 1) / range->grain;
+  while (blocks > range->leaf_blocks) {
+    long mid = begin + blocks / 2 * range->grain;
+    halves[num_halves] = *range;
+    halves[num_halves].begin = mid;
+    halves[num_halves].end = end;
+    jobs_run(range->jobs, run_range, &halves[num_halves], &counter);
+    num_halves++;
+
+    end = mid;
+    blocks /= 2;
+  }
+
+  range->fn(range->context, begin, end);
+  jobs_wait(range->jobs, &counter);
+}
+
+void jobs_parallel_for(job_system *jobs, long count, long grain, job_range_fn fn, void *context) {
+  if (grain < 1) {
+    grain = 1;
+  }
+  long blocks = (count + grain - 1) / grain;
+  long leaf_blocks = blocks / ((jobs->num_workers + 1) * JOBS_SPLITS_PER_THREAD);
+  if (jobs->num_workers == 0 || blocks < 2) {
+    if (count > 0) {
+      fn(context, 0, count);
+    }
+    return;
+  }
+
+  range_job range = {jobs, fn, context, 0, count, grain, leaf_blocks > 0 ? leaf_blocks : 1};
+  run_range(&range);
+}
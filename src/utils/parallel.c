@@ -0,0 +1,69 @@
+#include "utils/parallel.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct {
+  parallel_fn fn;
+  void *context;
+  long begin, end;
+} parallel_slice;
+
+static job_system *shared_jobs;
+
+static void *slice_main(void *arg) {
+  parallel_slice *slice = arg;
+  slice->fn(slice->context, slice->begin, slice->end);
+  return NULL;
+}
+
+void parallel_use_jobs(job_system *jobs) {
+  shared_jobs = jobs;
+}
+
+void parallel_range(long count, long grain, int num_threads, parallel_fn fn, void *context) {
+  if (shared_jobs && num_threads != 1) {
+    jobs_parallel_for(shared_jobs, count, grain, fn, context);
+    return;
+  }
+
+  if (grain < 1) {
+    grain = 1;
+  }
+  long blocks = (count + grain - 1) / grain;
+
+  if (num_threads <= 0) {
+    num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if (num_threads > PARALLEL_MAX_THREADS) {
+    num_threads = PARALLEL_MAX_THREADS;
+  }
+  if (num_threads > blocks) {
+    num_threads = blocks > 0 ? blocks : 1;
+  }
+  if (num_threads == 1) {
+    fn(context, 0, count);
+    return;
+  }
+
+  parallel_slice slices[PARALLEL_MAX_THREADS];
+  pthread_t threads[PARALLEL_MAX_THREADS];
+  int started[PARALLEL_MAX_THREADS] = {0};
+  for (int i = 0; i < num_threads; i++) {
+    long begin = blocks * i / num_threads * grain, end = blocks * (i + 1) / num_threads * grain;
+    slices[i] = (parallel_slice){fn, context, begin, end < count ? end : count};
+  }
+
+  for (int i = 1; i < num_threads; i++) {
+    started[i] = pthread_create(&threads[i], NULL, slice_main, &slices[i]) == 0;
+  }
+  slice_main(&slices[0]);
+  // a slice whose thread did not start runs here instead
+  for (int i = 1; i < num_threads; i++) {
+    if (started[i]) {
+      pthread_join(threads[i], NULL);
+    } else {
+      slice_main(&slices[i]);
+    }
+  }
+}
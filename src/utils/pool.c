@@ -0,0 +1,75 @@
+#include "utils/pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static int grow(pool *p) {
+  if (p->num_chunks == p->max_chunks) {
+    int max = p->max_chunks ? p->max_chunks * 2 : 8;
+    char **chunks = realloc(p->chunks, max * sizeof(char *));
+    if (!chunks) {
+      fprintf(stderr, "ERROR: could not allocate memory for %i pool chunks.\n", max);
+      return -1;
+    }
+    p->chunks = chunks;
+    p->max_chunks = max;
+  }
+
+  char *chunk = aligned_alloc(p->align, p->block_size * p->blocks_per_chunk);
+  if (!chunk) {
+    fprintf(stderr, "ERROR: could not allocate %i pool blocks of %zu bytes.\n", p->blocks_per_chunk, p->block_size);
+    return -1;
+  }
+  p->chunks[p->num_chunks++] = chunk;
+
+  // threaded back to front so blocks come out in address order
+  for (int i = p->blocks_per_chunk - 1; i >= 0; i--) {
+    void *block = chunk + i * p->block_size;
+    *(void **)block = p->free_list;
+    p->free_list = block;
+  }
+  return 0;
+}
+
+int pool_init(pool *p, size_t block_size, size_t align, int blocks_per_chunk) {
+  memset(p, 0, sizeof(*p));
+  if (align < sizeof(void *)) {
+    align = sizeof(void *);
+  }
+  if (block_size < sizeof(void *)) {
+    block_size = sizeof(void *);
+  }
+  p->block_size = (block_size + align - 1) & ~(align - 1);
+  p->align = align;
+  p->blocks_per_chunk = blocks_per_chunk > 0 ? blocks_per_chunk : 1;
+  return 0;
+}
+
+void pool_free(pool *p) {
+  for (int i = 0; i < p->num_chunks; i++) {
+    free(p->chunks[i]);
+  }
+  free(p->chunks);
+  memset(p, 0, sizeof(*p));
+}
+
+void *pool_alloc(pool *p) {
+  if (!p->free_list && grow(p) != 0) {
+    return NULL;
+  }
+
+  void *block = p->free_list;
+  p->free_list = *(void **)block;
+  if (++p->live > p->high_water) {
+    p->high_water = p->live;
+  }
+  return block;
+}
+
+void pool_release(pool *p, void *block) {
+  *(void **)block = p->free_list;
+  p->free_list = block;
+  p->live--;
+}